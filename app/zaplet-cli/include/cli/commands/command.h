@@ -23,10 +23,18 @@ namespace zaplet::cli
 
         virtual void setupOptions() = 0;
 
+        // Process exit code after the command ran
+        [[nodiscard]] int getExitCode() const;
+
     protected:
+        // Exit codes besides success; a run stopped by a signal exits with 128 + the signal number, like shells report it
+        static constexpr int EXIT_FAILURES = 1;
+        static constexpr int EXIT_ERROR = 2;
+
         CLI::App* m_app;
         std::shared_ptr<http::Client> m_client;
         std::shared_ptr<output::Formatter> m_formatter;
+        int m_exitCode = 0;
 
         virtual void execute() = 0;
     };
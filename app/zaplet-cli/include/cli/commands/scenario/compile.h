@@ -0,0 +1,36 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#include "cli/commands/command.h"
+
+#include <zaplet/zaplet.h>
+
+#include <string>
+#include <vector>
+
+namespace zaplet::cli
+{
+    class CompileCommand final : public Command
+    {
+    public:
+        using Command::Command;
+
+        void setupOptions() override;
+
+    protected:
+        void execute() override;
+
+    private:
+        std::string m_scenarioFile;
+        std::vector<std::string> m_variables;
+        bool m_dump = false;
+        bool m_graph = false;
+        bool m_dot = false;
+    };
+}
+
+#endif // COMPILE_H
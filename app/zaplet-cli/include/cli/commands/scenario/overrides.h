@@ -0,0 +1,19 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef OVERRIDES_H
+#define OVERRIDES_H
+
+#include <zaplet/zaplet.h>
+
+#include <string>
+#include <vector>
+
+namespace zaplet::cli
+{
+    // Applies -v KEY=VALUE options on top of the scenario environment
+    void applyVariableOverrides(scenario::Scenario& scenario, const std::vector<std::string>& variables);
+} // namespace zaplet::cli
+
+#endif // OVERRIDES_H
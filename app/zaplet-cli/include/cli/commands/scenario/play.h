@@ -9,6 +9,10 @@
 
 #include <zaplet/zaplet.h>
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -27,6 +31,14 @@ namespace zaplet::cli
     private:
         std::string m_scenarioFile;
         std::vector<std::string> m_variables;
+        std::size_t m_virtualUsers = 0;
+        std::optional<std::uint64_t> m_seed;
+        std::string m_duration;
+        std::string m_gracePeriod = "30s";
+        std::optional<std::size_t> m_responseWorkers;
+        std::optional<std::chrono::milliseconds> m_runDuration;
+
+        scenario::Runner::Flow loadFlow(const scenario::YamlParser& parser, const std::string& filePath) const;
     };
 }
 
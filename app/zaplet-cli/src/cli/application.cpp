@@ -10,6 +10,7 @@
 #include "cli/commands/http/patch.h"
 #include "cli/commands/http/post.h"
 #include "cli/commands/http/put.h"
+#include "cli/commands/scenario/compile.h"
 #include "cli/commands/scenario/play.h"
 
 #include <format>
@@ -48,6 +49,13 @@ namespace zaplet::cli
                 return 0;
             }
 
+            for (const auto& command : m_commands)
+            {
+                if (command->getExitCode() != 0)
+                {
+                    return command->getExitCode();
+                }
+            }
             return 0;
         } catch (const CLI::ParseError& e)
         {
@@ -97,6 +105,11 @@ namespace zaplet::cli
         playCmd->setupOptions();
         m_commands.push_back(std::move(playCmd));
 
+        auto compile = m_cliApp.add_subcommand("compile", "Compile the .zpl script without executing it");
+        auto compileCmd = std::make_unique<CompileCommand>(compile, m_client, m_formatter);
+        compileCmd->setupOptions();
+        m_commands.push_back(std::move(compileCmd));
+
         m_cliApp.require_subcommand(1);
     }
 
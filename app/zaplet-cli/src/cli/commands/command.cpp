@@ -22,4 +22,9 @@ namespace zaplet::cli
     {
         return m_app->get_name();
     }
+
+    int Command::getExitCode() const
+    {
+        return m_exitCode;
+    }
 } // namespace zaplet::cli
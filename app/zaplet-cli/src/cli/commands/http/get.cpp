@@ -6,8 +6,6 @@
 
 #include <zaplet/zaplet.h>
 
-#include <map>
-
 namespace zaplet::cli
 {
     void GetCommand::setupOptions()
@@ -21,12 +19,12 @@ namespace zaplet::cli
     {
         LOG_INFO_FMT("Executing GET request to {}", m_url);
 
-        const std::map<std::string, std::string> headerMap = http::headersVectorToMap(m_headers);
+        const http::Headers headers = http::parseHeaders(m_headers);
 
         http::Request request;
         request.setUrl(m_url);
         request.setMethod("GET");
-        request.setHeaders(headerMap);
+        request.setHeaders(headers);
         request.setTimeout(m_timeout);
 
         auto response = m_client->execute(request);
@@ -19,12 +19,12 @@ namespace zaplet::cli
     {
         LOG_INFO_FMT("Executing HEAD request to {}", m_url);
 
-        std::map<std::string, std::string> headerMap = http::headersVectorToMap(m_headers);
+        http::Headers headers = http::parseHeaders(m_headers);
 
         http::Request request;
         request.setUrl(m_url);
         request.setMethod("HEAD");
-        request.setHeaders(headerMap);
+        request.setHeaders(headers);
         request.setTimeout(m_timeout);
 
         auto response = m_client->execute(request);
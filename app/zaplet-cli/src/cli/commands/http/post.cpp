@@ -21,18 +21,18 @@ namespace zaplet::cli
     {
         LOG_INFO_FMT("Executing POST request to {}", m_url);
 
-        std::map<std::string, std::string> headerMap = http::headersVectorToMap(m_headers);
+        http::Headers headers = http::parseHeaders(m_headers);
 
-        if (!m_body.empty() && headerMap.find("Content-Type") == headerMap.end())
+        if (!m_body.empty() && !headers.contains("Content-Type"))
         {
-            headerMap["Content-Type"] = m_contentType;
+            headers.set("Content-Type", m_contentType);
             LOG_DEBUG_FMT("Added Content-Type: {}", m_contentType);
         }
 
         http::Request request;
         request.setUrl(m_url);
         request.setMethod("POST");
-        request.setHeaders(headerMap);
+        request.setHeaders(headers);
         request.setBody(m_body);
         request.setTimeout(m_timeout);
 
@@ -0,0 +1,61 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "cli/commands/scenario/compile.h"
+
+#include "cli/commands/scenario/overrides.h"
+
+#include <format>
+#include <iostream>
+
+namespace zaplet::cli
+{
+    void CompileCommand::setupOptions()
+    {
+        m_app->add_option("scenario_file", m_scenarioFile, "Scenario file to compile")->required();
+        m_app->add_option("-v,--variable", m_variables, "Variables in KEY=VALUE format (can be specified multiple times)");
+        m_app->add_flag("--dump", m_dump, "Print the compiled program");
+        m_app->add_flag("--graph", m_graph, "Print the step dependency graph");
+        m_app->add_flag("--dot", m_dot, "Print the step dependency graph in Graphviz format");
+    }
+
+    void CompileCommand::execute()
+    {
+        LOG_INFO_FMT("Compiling scenario from file: {}", m_scenarioFile);
+
+        try
+        {
+            scenario::YamlParser parser;
+            auto scenario = parser.parseFile(m_scenarioFile);
+            applyVariableOverrides(scenario, m_variables);
+
+            auto program = scenario::Program::compile(scenario);
+
+            if (m_graph || m_dot)
+            {
+                auto graph = scenario::DependencyGraph::build(scenario);
+                std::cout << (m_dot ? graph.toDot() : graph.dump());
+            }
+
+            if (m_dump)
+            {
+                std::cout << program.dump();
+            }
+            else if (!m_graph && !m_dot)
+            {
+                std::cout << std::format(
+                    "Scenario '{}' compiled: {} steps, {} instructions, {} variable slots\n",
+                    program.getName(),
+                    program.getSteps().size(),
+                    program.getCode().size(),
+                    program.getTable().size());
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT("Error compiling scenario: {}", e.what());
+            m_exitCode = EXIT_ERROR;
+        }
+    }
+} // namespace zaplet::cli
@@ -0,0 +1,31 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "cli/commands/scenario/overrides.h"
+
+namespace zaplet::cli
+{
+    void applyVariableOverrides(scenario::Scenario& scenario, const std::vector<std::string>& variables)
+    {
+        auto env = scenario.getEnvironment();
+
+        for (const auto& var : variables)
+        {
+            auto pos = var.find('=');
+            if (pos != std::string::npos)
+            {
+                std::string key = var.substr(0, pos);
+                std::string value = var.substr(pos + 1);
+                env[key] = value;
+                LOG_DEBUG_FMT("Variable: {}={}", key, value);
+            }
+            else
+            {
+                LOG_WARNING_FMT("Invalid variable format: {}, should be KEY=VALUE", var);
+            }
+        }
+
+        scenario.setEnvironment(env);
+    }
+} // namespace zaplet::cli
@@ -4,64 +4,195 @@
 
 #include "cli/commands/scenario/play.h"
 
+#include "cli/commands/scenario/overrides.h"
+#include "zaplet/scenario/program.h"
+#include "zaplet/scenario/runner.h"
 #include "zaplet/scenario/yaml_parser.h"
 
+#include <atomic>
+#include <csignal>
+#include <format>
+#include <iostream>
+#include <memory>
+
 namespace zaplet::cli
 {
+    namespace
+    {
+        volatile std::sig_atomic_t receivedSignal = 0;
+        std::atomic<scenario::Runner*> activeRunner{ nullptr };
+
+        static_assert(std::atomic<scenario::Runner*>::is_always_lock_free);
+
+        void onSignal(int signal)
+        {
+            receivedSignal = signal;
+            if (auto* runner = activeRunner.load())
+            {
+                runner->requestStop();
+            }
+        }
+
+        // Routes SIGINT and SIGTERM to a runner while it runs: the first one drains the run, the second one abandons it
+        class StopOnSignal
+        {
+        public:
+            explicit StopOnSignal(scenario::Runner& runner)
+            {
+                activeRunner.store(&runner);
+                m_interrupt = std::signal(SIGINT, onSignal);
+                m_terminate = std::signal(SIGTERM, onSignal);
+            }
+
+            ~StopOnSignal()
+            {
+                std::signal(SIGINT, m_interrupt == SIG_ERR ? SIG_DFL : m_interrupt);
+                std::signal(SIGTERM, m_terminate == SIG_ERR ? SIG_DFL : m_terminate);
+                activeRunner.store(nullptr);
+            }
+
+            StopOnSignal(const StopOnSignal&) = delete;
+            StopOnSignal& operator=(const StopOnSignal&) = delete;
+
+        private:
+            void (*m_interrupt)(int) = SIG_DFL;
+            void (*m_terminate)(int) = SIG_DFL;
+        };
+    } // namespace
+
     void PlayCommand::setupOptions()
     {
-        m_app->add_option("scenario_file", m_scenarioFile, "Scenario file to play")->required();
+        m_app->add_option("scenario_file", m_scenarioFile, "Scenario or mix file to play")->required();
         m_app->add_option("-v,--variable", m_variables, "Variables in KEY=VALUE format (can be specified multiple times)");
+        m_app->add_option("-u,--vus", m_virtualUsers, "Number of concurrent virtual users (overrides the scenario 'vus')");
+        m_app->add_option("--seed", m_seed, "Seed of the template random generators, to repeat a previous run");
+        m_app->add_option(
+            "-d,--duration", m_duration, "Run time such as 90s, 10m or 1h30m (overrides the scenario 'duration' and 'repeat')");
+        m_app->add_option("--grace-period", m_gracePeriod, "How long a stopping run waits for running iterations")->default_str("30s");
+        m_app->add_option("--response-workers",
+                          m_responseWorkers,
+                          "Threads formatting, logging and validating responses off the request threads (default 0 keeps it on them)");
     }
 
     void PlayCommand::execute()
     {
         LOG_INFO_FMT("Playing scenario from file: {}", m_scenarioFile);
+        m_exitCode = 0;
+        receivedSignal = 0;
 
         try
         {
-            std::map<std::string, std::string> variables;
-            for (const auto& var : m_variables)
+            m_runDuration.reset();
+            if (!m_duration.empty())
             {
-                auto pos = var.find('=');
-                if (pos != std::string::npos)
+                m_runDuration = scenario::YamlParser::parseDuration(m_duration);
+            }
+            auto gracePeriod = scenario::YamlParser::parseDuration(m_gracePeriod);
+
+            std::optional<std::chrono::milliseconds> mixDuration;
+            scenario::YamlParser parser;
+            std::vector<scenario::Runner::Flow> flows;
+            std::string title;
+
+            if (scenario::YamlParser::isMixFile(m_scenarioFile))
+            {
+                auto mix = parser.parseMixFile(m_scenarioFile);
+                title = mix.name;
+                mixDuration = mix.duration;
+
+                std::size_t fixed = 0;
+                std::size_t weighted = 0;
+                for (const auto& entry : mix.entries)
                 {
-                    std::string key = var.substr(0, pos);
-                    std::string value = var.substr(pos + 1);
-                    variables[key] = value;
-                    LOG_DEBUG_FMT("Variable: {}={}", key, value);
+                    fixed += entry.virtualUsers.value_or(0);
+                    weighted += entry.virtualUsers.has_value() ? 0 : 1;
                 }
-                else
+
+                std::size_t total = m_virtualUsers > 0 ? m_virtualUsers : mix.virtualUsers.value_or(fixed + weighted);
+                auto allocation = mix.allocate(total);
+                for (std::size_t i = 0; i < mix.entries.size(); ++i)
+                {
+                    flows.push_back(loadFlow(parser, mix.entries[i].file));
+                    flows.back().virtualUsers = allocation[i];
+                }
+            }
+            else
+            {
+                flows.push_back(loadFlow(parser, m_scenarioFile));
+                if (m_virtualUsers > 0)
                 {
-                    LOG_WARNING_FMT("Invalid variable format: {}, should be KEY=VALUE", var);
+                    flows.back().virtualUsers = m_virtualUsers;
                 }
             }
 
-            scenario::YamlParser parser;
-            auto scenario = parser.parseFile(m_scenarioFile);
+            scenario::Runner runner(m_client, m_formatter);
+            runner.setDuration(m_runDuration.has_value() ? m_runDuration : mixDuration);
+            runner.setGracePeriod(gracePeriod);
+            if (m_responseWorkers.has_value())
+            {
+                runner.setPipelineWorkers(m_responseWorkers.value());
+            }
 
-            auto env = scenario.getEnvironment();
-            for (const auto& [key, value] : variables)
+            bool success = false;
             {
-                env[key] = value;
+                StopOnSignal stopOnSignal(runner);
+                success = runner.run(flows);
             }
-            scenario.setEnvironment(env);
 
-            scenario::Player player(m_client, m_formatter);
-            bool success = player.play(scenario);
+            scenario::Metrics combined;
+            for (const auto& flow : flows)
+            {
+                std::cout << flow.metrics.format(std::format("{} ({} virtual users)", flow.name, flow.virtualUsers), runner.getElapsed());
+                combined.merge(flow.metrics);
+            }
+            if (flows.size() > 1)
+            {
+                std::cout << combined.format(std::format("{} (combined)", title), runner.getElapsed());
+            }
 
-            if (success)
+            if (receivedSignal != 0)
+            {
+                LOG_WARNING_FMT("Scenario stopped by signal {}", static_cast<int>(receivedSignal));
+                m_exitCode = 128 + receivedSignal;
+            }
+            else if (success)
             {
                 LOG_INFO("Scenario completed successfully");
             }
             else
             {
                 LOG_ERROR("Scenario completed with errors");
+                m_exitCode = EXIT_FAILURES;
             }
         }
         catch (const std::exception& e)
         {
             LOG_ERROR_FMT("Error playing scenario: {}", e.what());
+            m_exitCode = EXIT_ERROR;
+        }
+
+        // Sinks are otherwise flushed every few seconds, which could lose the last lines of a run stopped by a signal
+        logging::Logger::getInstance().get()->flush();
+    }
+
+    scenario::Runner::Flow PlayCommand::loadFlow(const scenario::YamlParser& parser, const std::string& filePath) const
+    {
+        auto scenario = parser.parseFile(filePath);
+        applyVariableOverrides(scenario, m_variables);
+        if (m_seed.has_value())
+        {
+            scenario.setSeed(m_seed);
         }
+        if (m_runDuration.has_value())
+        {
+            scenario.setDuration(m_runDuration);
+            scenario.setRepeatCount(std::nullopt);
+        }
+
+        scenario::Runner::Flow flow;
+        flow.name = scenario.getName();
+        flow.program = std::make_shared<const scenario::Program>(scenario::Program::compile(scenario));
+        flow.virtualUsers = flow.program->getVirtualUsers();
+        return flow;
     }
-} // namespace zaplet::cli
\ No newline at end of file
+} // namespace zaplet::cli
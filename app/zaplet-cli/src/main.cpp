@@ -34,5 +34,5 @@ int main(int argc, char** argv)
         std::cerr << "Unknown error occurred" << std::endl;
     }
 
-    return 0;
+    return 1;
 }
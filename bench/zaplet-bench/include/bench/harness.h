@@ -0,0 +1,72 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string>
+
+namespace zaplet::bench
+{
+    struct Result
+    {
+        std::string name;
+        std::size_t iterations = 0;
+        double nsPerOp = 0.0;
+    };
+
+    struct Allocations
+    {
+        std::string name;
+        std::size_t iterations = 0;
+        double perIteration = 0.0;
+    };
+
+    // fn() returns a value derived from its work so the optimizer cannot drop the loop
+    template<typename Fn>
+    Result run(const std::string& name, std::size_t iterations, Fn&& fn)
+    {
+        volatile std::size_t sink = 0;
+
+        for (std::size_t i = 0; i < iterations / 10 + 1; ++i)
+        {
+            sink = sink + fn();
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            sink = sink + fn();
+        }
+        auto endTime = std::chrono::steady_clock::now();
+
+        auto elapsed = std::chrono::duration<double, std::nano>(endTime - startTime).count();
+        return { name, iterations, elapsed / static_cast<double>(iterations) };
+    }
+
+    inline void report(const Result& result)
+    {
+        std::cout << std::format("{:<48} {:>12} iters {:>12.1f} ns/op\n", result.name, result.iterations, result.nsPerOp);
+    }
+
+    inline void reportSpeedup(const Result& baseline, const Result& candidate)
+    {
+        std::cout << std::format("{:<48} x{:.1f}\n", candidate.name + " speedup", baseline.nsPerOp / candidate.nsPerOp);
+    }
+
+    inline void reportAllocations(const Allocations& result)
+    {
+        std::cout << std::format("{:<48} {:>12} iters {:>12.1f} allocs/iter\n", result.name, result.iterations, result.perIteration);
+    }
+
+    void runTemplateBenchmarks();
+    void runJsonBenchmarks();
+    void runAllocationBenchmarks();
+} // namespace zaplet::bench
+
+#endif // HARNESS_H
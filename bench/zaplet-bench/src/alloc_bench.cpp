@@ -0,0 +1,183 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "bench/harness.h"
+
+#include <zaplet/zaplet.h>
+
+#include <httplib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Counted on every thread while a play runs, parallel branches included; the server answering it is left out
+    std::atomic<bool> g_counting{ false };
+    std::atomic<std::uint64_t> g_allocations{ 0 };
+    thread_local bool t_server = false;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed) && !t_server)
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace zaplet::bench
+{
+    namespace
+    {
+        // Runs the handlers of the server on threads whose allocations are not counted
+        class ServerQueue final : public httplib::TaskQueue
+        {
+        public:
+            bool enqueue(std::function<void()> task) override
+            {
+                return m_pool.enqueue(
+                    [task = std::move(task)]()
+                    {
+                        t_server = true;
+                        task();
+                    });
+            }
+
+            void shutdown() override
+            {
+                m_pool.shutdown();
+            }
+
+        private:
+            httplib::ThreadPool m_pool{ CPPHTTPLIB_THREAD_POOL_COUNT };
+        };
+
+        struct Case
+        {
+            std::string name;
+            std::string steps;
+        };
+
+        const std::vector<Case> CASES = {
+            { "get", R"(
+  - name: item
+    request:
+      url: "${base_url}/item"
+)" },
+            { "post/extract/validate", R"(
+  - name: login
+    request:
+      url: "${base_url}/login"
+      method: POST
+      headers:
+        Content-Type: application/json
+        X-Request-Id: "${token}"
+      body: '{"user": "bench", "password": "secret"}'
+    variables:
+      token: "$.token"
+      user_name: "$.user.name"
+    expected_response:
+      status_code: 200
+      json:
+        ok: true
+)" },
+            { "foreach/parallel", R"(
+  - name: pages
+    foreach: '["first", "second", "third"]'
+    request:
+      url: "${base_url}/item/${item}"
+  - name: dashboard
+    parallel:
+      - name: profile
+        request:
+          url: "${base_url}/login"
+          method: POST
+        variables:
+          user_name: "$.user.name"
+      - name: feed
+        request:
+          url: "${base_url}/item"
+)" },
+        };
+
+        // Allocations of one play with the given number of iterations
+        std::uint64_t countAllocations(const std::string& source, int iterations)
+        {
+            auto scenario = scenario::YamlParser().parseString(source + "repeat: " + std::to_string(iterations) + "\n");
+            auto program = std::make_shared<const scenario::Program>(scenario::Program::compile(scenario));
+            scenario::Player player(std::make_shared<http::Client>(), output::FormatterFactory::create("json"));
+
+            g_allocations = 0;
+            g_counting = true;
+            player.play(program);
+            g_counting = false;
+            return g_allocations;
+        }
+    } // namespace
+
+    void runAllocationBenchmarks()
+    {
+        httplib::Server server;
+        server.new_task_queue = []() { return new ServerQueue(); };
+        server.Get("/item.*",
+                   [](const httplib::Request&, httplib::Response& response)
+                   { response.set_content(R"({"id": 42, "name": "item", "tags": ["a", "b"]})", "application/json"); });
+        server.Post("/login",
+                    [](const httplib::Request&, httplib::Response& response)
+                    {
+                        response.set_content(R"({"ok": true, "token": "0123456789abcdef0123456789abcdef", "user": {"name": "bench"}})",
+                                             "application/json");
+                    });
+
+        int port = server.bind_to_any_port("127.0.0.1");
+        std::thread listener(
+            [&server]()
+            {
+                t_server = true;
+                server.listen_after_bind();
+            });
+        server.wait_until_ready();
+
+        // The difference of two plays leaves out parsing, compiling and the first iteration growing the buffers
+        constexpr int warmup = 20;
+        constexpr int iterations = 200;
+
+        for (const auto& benchCase : CASES)
+        {
+            std::string source = "name: " + benchCase.name + "\nthink_time: 0\nenvironment:\n  base_url: \"http://127.0.0.1:" +
+                                 std::to_string(port) + "\"\nsteps:" + benchCase.steps;
+
+            std::uint64_t baseline = countAllocations(source, warmup);
+            std::uint64_t total = countAllocations(source, warmup + iterations);
+            reportAllocations({ "player/" + benchCase.name, static_cast<std::size_t>(iterations),
+                                static_cast<double>(total - baseline) / iterations });
+        }
+
+        server.stop();
+        listener.join();
+    }
+} // namespace zaplet::bench
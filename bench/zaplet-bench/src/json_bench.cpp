@@ -0,0 +1,80 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "bench/harness.h"
+
+#include <zaplet/zaplet.h>
+
+#include <nlohmann/json.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace zaplet::bench
+{
+    namespace
+    {
+        // A list endpoint response with the interesting fields near the start of the document
+        std::string makeListBody(std::size_t items)
+        {
+            nlohmann::ordered_json body;
+            body["meta"] = { { "total", items }, { "page", 1 } };
+            body["data"] = nlohmann::ordered_json::array();
+
+            for (std::size_t i = 0; i < items; ++i)
+            {
+                body["data"].push_back({ { "id", i }, { "name", "item-" + std::to_string(i) }, { "tags", { "a", "b", "c" } } });
+            }
+
+            return body.dump();
+        }
+    } // namespace
+
+    void runJsonBenchmarks()
+    {
+        for (std::size_t items : { 10, 1000, 50000 })
+        {
+            http::Response response;
+            response.setBody(makeListBody(items));
+
+            auto total = scenario::Extractor::compile("$.meta.total");
+            auto firstId = scenario::Extractor::compile("$.data[0].id");
+
+            scenario::JsonStreamSelector selector;
+            selector.addPath(total.getPath());
+            selector.addPath(firstId.getPath());
+
+            std::size_t iterations = items >= 50000 ? 10 : 1000;
+            std::string suffix = std::format("/{}items", items);
+            std::string out;
+
+            auto dom = run(
+                "json/extract" + suffix + "/dom",
+                iterations,
+                [&]()
+                {
+                    scenario::ResponseDocument document(response);
+                    total.extract(document, out);
+                    std::size_t size = out.size();
+                    firstId.extract(document, out);
+                    return size + out.size();
+                });
+
+            std::vector<std::optional<std::string>> results;
+            auto streamed = run(
+                "json/extract" + suffix + "/stream",
+                iterations,
+                [&]()
+                {
+                    selector.select(response.getBody(), results);
+                    return results[0]->size() + results[1]->size();
+                });
+
+            report(dom);
+            report(streamed);
+            reportSpeedup(dom, streamed);
+        }
+    }
+} // namespace zaplet::bench
@@ -0,0 +1,30 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "bench/harness.h"
+
+#include <zaplet/zaplet.h>
+
+#include <iostream>
+
+int main()
+{
+    try
+    {
+        zaplet::logging::Config config;
+        config.level = zaplet::logging::LogLevel::Off;
+        config.fileLoggingEnabled = false;
+        LOG_INITIALIZE_WITH_CONFIG(config);
+
+        zaplet::bench::runTemplateBenchmarks();
+        zaplet::bench::runJsonBenchmarks();
+        zaplet::bench::runAllocationBenchmarks();
+    } catch (const std::exception& e)
+    {
+        std::cerr << "Fatal: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "bench/harness.h"
+
+#include <zaplet/zaplet.h>
+
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace zaplet::bench
+{
+    namespace
+    {
+        // The regex based substitution used by Player before templates were compiled
+        std::string legacyReplaceVariables(const std::string& input, std::map<std::string, std::string>& variables)
+        {
+            std::string result = input;
+            std::regex variablePattern("\\$\\{([\\w.]+)\\}");
+
+            std::smatch matches;
+            std::string::const_iterator searchStart(input.cbegin());
+
+            while (std::regex_search(searchStart, input.cend(), matches, variablePattern))
+            {
+                std::string varName = matches[1].str();
+                std::string replacement;
+
+                if (variables.find(varName) != variables.end())
+                {
+                    replacement = variables[varName];
+                    LOG_DEBUG_FMT("Replacing variable '{}' with '{}'", varName, replacement);
+                }
+                else
+                {
+                    replacement = matches[0].str();
+                }
+
+                size_t pos = result.find(matches[0].str());
+                if (pos != std::string::npos)
+                {
+                    result.replace(pos, matches[0].length(), replacement);
+                }
+
+                searchStart = matches.suffix().first;
+            }
+
+            return result;
+        }
+
+        struct Case
+        {
+            std::string name;
+            std::string source;
+        };
+
+        const std::vector<Case> CASES = {
+            { "url", "${api_url}/auth/profile/" },
+            { "header", "Bearer ${token}" },
+            { "literal", "application/json" },
+            { "body",
+              R"({
+    "email": "${email}",
+    "username": "GOD",
+    "password": "${password}",
+    "password2": "${password}",
+    "first_name": "John",
+    "last_name": "Malcov",
+    "phone_number": "+79527981865"
+})" },
+        };
+    } // namespace
+
+    void runTemplateBenchmarks()
+    {
+        std::map<std::string, std::string> variables = {
+            { "api_url", "http://127.0.0.1:8000/api/v1" },
+            { "token", "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIn0.signature" },
+            { "email", "example@gmail.com" },
+            { "password", "Qwerty1234567890" },
+        };
+
+        scenario::VariableTable table;
+        std::vector<scenario::Template> templates;
+        for (const auto& benchCase : CASES)
+        {
+            templates.push_back(scenario::Template::compile(benchCase.source, table));
+        }
+
+        scenario::VariableFrame frame(table.size());
+        for (const auto& [name, value] : variables)
+        {
+            frame.set(table.intern(name), value);
+        }
+
+        constexpr std::size_t iterations = 100000;
+        std::string buffer;
+
+        for (std::size_t i = 0; i < CASES.size(); ++i)
+        {
+            const auto& benchCase = CASES[i];
+            const auto& compiled = templates[i];
+
+            auto legacy = run(
+                "template/" + benchCase.name + "/regex",
+                iterations,
+                [&]()
+                {
+                    return legacyReplaceVariables(benchCase.source, variables).size();
+                });
+
+            auto rendered = run(
+                "template/" + benchCase.name + "/compiled",
+                iterations,
+                [&]()
+                {
+                    compiled.render(frame, buffer);
+                    return buffer.size();
+                });
+
+            report(legacy);
+            report(rendered);
+            reportSpeedup(legacy, rendered);
+        }
+    }
+} // namespace zaplet::bench
@@ -8,9 +8,15 @@
 #include "zaplet/http/http_wrapper.h"
 #include "zaplet/http/request.h"
 #include "zaplet/http/response.h"
+#include "zaplet/http/response_cache.h"
+#include "zaplet/http/url.h"
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace httplib
 {
@@ -20,18 +26,54 @@ namespace httplib
 
 namespace zaplet::http
 {
+    // A request resolved into its client, path and headers, so that sending it does no more preparation
+    struct PreparedRequest
+    {
+        const Request* request = nullptr;
+        std::unique_ptr<IClientWrapper> client;
+        std::string path;
+        httplib::Headers headers;
+        // set when the request cannot be sent; send() then returns it as the response error
+        std::string error;
+        // scheme, host and port of the request, and the address it connects to when pinned, under which its client
+        // goes back to the pool
+        std::string origin;
+        ResponseCache* cache = nullptr;
+        // scheme, host, port and path of the request, under which its response is cached
+        std::string cacheKey;
+        // a fresh cached response, returned by send() without sending anything
+        std::optional<Response> cached;
+    };
+
+    // Sends requests over connections kept open per origin. A request takes an idle connection to its origin or opens
+    // a new one, and hands it back once its response arrived, so every caller sharing the client shares the pool.
     class Client
     {
     public:
         Client() = default;
         ~Client() = default;
 
-        Response execute(const Request& request);
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        // The cache, when given, is the private cache of the caller, such as a virtual user
+        Response execute(const Request& request, ResponseCache* cache = nullptr);
+
+        // execute() in two halves; the request must outlive the prepared one
+        PreparedRequest prepare(const Request& request, ResponseCache* cache = nullptr);
+        Response send(PreparedRequest& prepared);
+
+        // Appends the query parameters to the path the way they are sent
+        static void appendQuery(std::string& path, const std::map<std::string, std::string>& params);
 
     private:
-        std::unique_ptr<IClientWrapper> createClient(const std::string& url);
+        std::mutex m_poolMutex;
+        // clients with an open connection that no request is using, by origin
+        std::map<std::string, std::vector<std::unique_ptr<IClientWrapper>>, std::less<>> m_idle;
 
-        bool parseUrl(const std::string& url, std::string& scheme, std::string& host, int& port, std::string& path);
+        std::unique_ptr<IClientWrapper> acquireClient(const Url& url, const std::string& origin);
+        void releaseClient(PreparedRequest& prepared);
+        std::unique_ptr<IClientWrapper> createClient(const Url& url);
     };
 } // namespace zaplet::http
 
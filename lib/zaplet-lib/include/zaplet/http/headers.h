@@ -0,0 +1,147 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef HEADERS_H
+#define HEADERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace zaplet::http
+{
+    [[nodiscard]] bool equalsIgnoreCase(std::string_view left, std::string_view right);
+
+    // Header fields of a request or response in the order they were added. Names are matched without regard to case
+    // and may repeat, as Set-Cookie does. The first fields live inside the object, so a typical message allocates
+    // nothing for its headers, and cleared fields keep their strings to be filled again.
+    class Headers
+    {
+    public:
+        struct Field
+        {
+            std::string name;
+            std::string value;
+        };
+
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Field;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Field*;
+            using reference = const Field&;
+
+            const_iterator() = default;
+
+            reference operator*() const
+            {
+                return m_headers->entry(m_index).field;
+            }
+
+            pointer operator->() const
+            {
+                return &m_headers->entry(m_index).field;
+            }
+
+            const_iterator& operator++()
+            {
+                ++m_index;
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator previous = *this;
+                ++m_index;
+                return previous;
+            }
+
+            bool operator==(const const_iterator& other) const = default;
+
+        private:
+            friend class Headers;
+
+            const_iterator(const Headers* headers, std::size_t index)
+                : m_headers(headers)
+                , m_index(index)
+            {
+            }
+
+            const Headers* m_headers = nullptr;
+            std::size_t m_index = 0;
+        };
+
+        Headers() = default;
+        Headers(std::initializer_list<std::pair<std::string_view, std::string_view>> fields);
+        ~Headers() = default;
+
+        // Copies only the fields in use, not the strings cleared fields keep
+        Headers(const Headers& other);
+        Headers& operator=(const Headers& other);
+        // Leaves the other headers empty
+        Headers(Headers&& other) noexcept;
+        Headers& operator=(Headers&& other) noexcept;
+
+        // Appends a field, keeping the other values of the name
+        void add(std::string_view name, std::string_view value);
+        // Replaces every value of the name with this one
+        void set(std::string_view name, std::string_view value);
+        // Removes every value of the name, returning how many there were
+        std::size_t erase(std::string_view name);
+        void clear();
+
+        // The first value of the name; nullptr when there is none
+        [[nodiscard]] const std::string* find(std::string_view name) const;
+        [[nodiscard]] bool contains(std::string_view name) const;
+        [[nodiscard]] std::size_t count(std::string_view name) const;
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] bool empty() const;
+        [[nodiscard]] const_iterator begin() const;
+        [[nodiscard]] const_iterator end() const;
+
+        // Of the name folded to lower case, so that names differing in case only hash alike
+        [[nodiscard]] static std::uint32_t hash(std::string_view name);
+
+    private:
+        static constexpr std::size_t INLINE_FIELDS = 8;
+
+        struct Entry
+        {
+            std::uint32_t hash = 0;
+            Field field;
+        };
+
+        std::array<Entry, INLINE_FIELDS> m_inline;
+        // fields past the inline ones, in order
+        std::vector<Entry> m_overflow;
+        std::size_t m_size = 0;
+
+        [[nodiscard]] Entry& entry(std::size_t index)
+        {
+            return index < INLINE_FIELDS ? m_inline[index] : m_overflow[index - INLINE_FIELDS];
+        }
+
+        [[nodiscard]] const Entry& entry(std::size_t index) const
+        {
+            return index < INLINE_FIELDS ? m_inline[index] : m_overflow[index - INLINE_FIELDS];
+        }
+
+        // index of the first field of the name at or after from, or m_size
+        [[nodiscard]] std::size_t indexOf(std::uint32_t hash, std::string_view name, std::size_t from) const;
+        void append(std::uint32_t hash, std::string_view name, std::string_view value);
+        // Drops the fields of the name at or after from, keeping the order of the others
+        std::size_t removeFrom(std::uint32_t hash, std::string_view name, std::size_t from);
+    };
+} // namespace zaplet::http
+
+#endif // HEADERS_H
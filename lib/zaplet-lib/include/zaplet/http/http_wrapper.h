@@ -18,6 +18,9 @@ namespace zaplet::http
         virtual ~IClientWrapper() = default;
 
         virtual void setConnectionTimeout(std::chrono::seconds timeout) = 0;
+        virtual void setKeepAlive(bool keepAlive) = 0;
+        // Connects to the address instead of resolving the host name
+        virtual void setAddress(const std::string& host, const std::string& address) = 0;
 
         virtual httplib::Result get(const std::string& path, const httplib::Headers& headers) = 0;
         virtual httplib::Result post(const std::string& path, const httplib::Headers& headers, const std::string& body) = 0;
@@ -44,6 +47,16 @@ namespace zaplet::http
             m_client->set_connection_timeout(timeout);
         }
 
+        void setKeepAlive(bool keepAlive) override
+        {
+            m_client->set_keep_alive(keepAlive);
+        }
+
+        void setAddress(const std::string& host, const std::string& address) override
+        {
+            m_client->set_hostname_addr_map({ { host, address } });
+        }
+
         httplib::Result get(const std::string& path, const httplib::Headers& headers) override
         {
             return m_client->Get(path, headers);
@@ -111,6 +124,16 @@ namespace zaplet::http
             m_client->set_connection_timeout(timeout);
         }
 
+        void setKeepAlive(bool keepAlive) override
+        {
+            m_client->set_keep_alive(keepAlive);
+        }
+
+        void setAddress(const std::string& host, const std::string& address) override
+        {
+            m_client->set_hostname_addr_map({ { host, address } });
+        }
+
         httplib::Result get(const std::string& path, const httplib::Headers& headers) override
         {
             return m_client->Get(path, headers);
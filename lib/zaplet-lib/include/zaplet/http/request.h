@@ -5,10 +5,14 @@
 #ifndef REQUEST_H
 #define REQUEST_H
 
+#include "zaplet/http/headers.h"
+#include "zaplet/http/url.h"
+
 #include <chrono>
 #include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace zaplet::http
 {
@@ -19,13 +23,19 @@ namespace zaplet::http
 
         [[nodiscard]] const std::string& getUrl() const;
         void setUrl(const std::string& url);
+        // Sets the URL from an origin parsed in advance, so the client does not parse it again
+        void setUrl(const Url& origin, std::string_view path);
+        // The parsed URL, when it was set from one
+        [[nodiscard]] const std::optional<Url>& getTarget() const;
 
         [[nodiscard]] const std::string& getMethod() const;
         void setMethod(const std::string& method);
 
-        [[nodiscard]] const std::map<std::string, std::string>& getHeaders() const;
-        void setHeaders(const std::map<std::string, std::string>& headers);
-        void addHeader(const std::string& name, const std::string& value);
+        [[nodiscard]] const Headers& getHeaders() const;
+        void setHeaders(Headers headers);
+        // Replaces the values the header had
+        void setHeader(std::string_view name, std::string_view value);
+        void addHeader(std::string_view name, std::string_view value);
 
         [[nodiscard]] const std::optional<std::string>& getBody() const;
         void setBody(const std::string& body);
@@ -39,8 +49,9 @@ namespace zaplet::http
 
     private:
         std::string m_url;
+        std::optional<Url> m_target;
         std::string m_method = "GET";
-        std::map<std::string, std::string> m_headers;
+        Headers m_headers;
         std::optional<std::string> m_body;
         std::map<std::string, std::string> m_queryParams;
         int m_timeout = 30;
@@ -5,15 +5,29 @@
 #ifndef RESPONSE_H
 #define RESPONSE_H
 
+#include "zaplet/http/headers.h"
 #include "zaplet/logging/logger.h"
 
 #include <chrono>
-#include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace zaplet::http
 {
+    // How a response cache served a request
+    enum class CacheStatus
+    {
+        // the request did not go through a cache, or cannot be cached
+        None,
+        // sent to the server
+        Miss,
+        // served from the cache without sending anything
+        Hit,
+        // the server confirmed the cached response with 304 Not Modified
+        Revalidated
+    };
+
     class Response
     {
     public:
@@ -22,12 +36,12 @@ namespace zaplet::http
         [[nodiscard]] int getStatusCode() const;
         void setStatusCode(int statusCode);
 
-        [[nodiscard]] const std::map<std::string, std::string>& getHeaders() const;
-        void setHeaders(const std::map<std::string, std::string>& headers);
-        void addHeader(const std::string& name, const std::string& value);
+        [[nodiscard]] const Headers& getHeaders() const;
+        void setHeaders(Headers headers);
+        void addHeader(std::string_view name, std::string_view value);
 
         [[nodiscard]] const std::string& getBody() const;
-        void setBody(const std::string& body);
+        void setBody(std::string body);
 
         [[nodiscard]] std::chrono::milliseconds getLatency() const;
         void setLatency(std::chrono::milliseconds latency);
@@ -38,15 +52,21 @@ namespace zaplet::http
 
         [[nodiscard]] bool isSuccess() const;
 
+        [[nodiscard]] CacheStatus getCacheStatus() const;
+        void setCacheStatus(CacheStatus status);
+
     private:
         int m_statusCode = 0;
-        std::map<std::string, std::string> m_headers;
+        Headers m_headers;
         std::string m_body;
         std::chrono::milliseconds m_latency{ 0 };
         std::optional<std::string> m_error;
+        CacheStatus m_cacheStatus = CacheStatus::None;
     };
 
     void printResponse(const std::string& response, int statusCode);
+    // Whether printResponse writes a response with this status at the current log level; callers skip formatting otherwise
+    [[nodiscard]] bool isResponsePrinted(int statusCode);
 } // namespace zaplet::http
 
 #endif // RESPONSE_H
@@ -0,0 +1,76 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include "zaplet/http/headers.h"
+#include "zaplet/http/response.h"
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace zaplet::http
+{
+    // A private HTTP cache after RFC 9111, as a browser keeps one: GET responses are stored with their freshness
+    // lifetime, replayed while fresh and revalidated with If-None-Match and If-Modified-Since once stale. Entries are
+    // evicted least recently used first when there are too many or they take too much memory.
+    class ResponseCache
+    {
+    public:
+        ResponseCache(std::size_t maxEntries, std::size_t maxBytes);
+        ~ResponseCache() = default;
+
+        ResponseCache(const ResponseCache&) = delete;
+        ResponseCache& operator=(const ResponseCache&) = delete;
+
+        // Before a GET is sent: true when a fresh response was copied into response. Otherwise the validators of a
+        // stale entry that the request headers do not set already are added to validators.
+        bool lookup(const std::string& key, const Headers& headers, Headers& validators, Response& response);
+
+        // After a request was sent: stores a cacheable GET response, turns a 304 into the stored response it
+        // revalidated, and drops the entry a successful unsafe method changed
+        CacheStatus update(const std::string& key, const std::string& method, const Headers& headers, Response& response);
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::size_t getBytes() const;
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            Response response;
+            // request header values the response varies on
+            std::vector<std::pair<std::string, std::string>> vary;
+            std::chrono::steady_clock::time_point stored;
+            std::chrono::seconds initialAge{ 0 };
+            std::chrono::seconds lifetime{ 0 };
+            // the response may only be used after revalidating it
+            bool noCache = false;
+            std::size_t bytes = 0;
+        };
+
+        std::size_t m_maxEntries;
+        std::size_t m_maxBytes;
+        std::size_t m_bytes = 0;
+        // parallel steps of a virtual user share its cache
+        mutable std::mutex m_mutex;
+        // most recently used first
+        std::list<Entry> m_entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;
+
+        static void refresh(Entry& entry);
+        static bool varies(const Entry& entry, const Headers& headers);
+        void erase(std::string_view key);
+    };
+} // namespace zaplet::http
+
+#endif // RESPONSE_CACHE_H
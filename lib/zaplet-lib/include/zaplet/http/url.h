@@ -0,0 +1,33 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef URL_H
+#define URL_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace zaplet::http
+{
+    struct Url
+    {
+        std::string scheme;
+        std::string host;
+        int port = 80;
+        // path with the query string, always starting with '/'
+        std::string path = "/";
+        // address to connect to instead of resolving host; the host still names the server for TLS and Host
+        std::string address;
+
+        // Accepts http://host[:port][/path][?query] and https://...
+        static std::optional<Url> parse(std::string_view url);
+
+        [[nodiscard]] bool isDefaultPort() const;
+        // Appends scheme://host[:port] without the path
+        void appendOrigin(std::string& out) const;
+    };
+} // namespace zaplet::http
+
+#endif // URL_H
@@ -5,17 +5,18 @@
 #ifndef HTTPUTILS_H
 #define HTTPUTILS_H
 
+#include "zaplet/http/headers.h"
 #include "zaplet/logging/logger.h"
 
-#include <map>
 #include <string>
 #include <vector>
 
 namespace zaplet::http
 {
-    inline std::map<std::string, std::string> headersVectorToMap(const std::vector<std::string>& headersVector)
+    // "Name: value" arguments, as curl takes them; a repeated name sends every value
+    inline Headers parseHeaders(const std::vector<std::string>& headersVector)
     {
-        std::map<std::string, std::string> headerMap;
+        Headers headers;
         for (const auto& header : headersVector)
         {
             auto colonPos = header.find(':');
@@ -26,7 +27,7 @@ namespace zaplet::http
 
                 value.erase(0, value.find_first_not_of(" \t"));
 
-                headerMap[key] = value;
+                headers.add(key, value);
                 LOG_DEBUG_FMT("Header: {}={}", key, value);
             }
             else
@@ -35,7 +36,7 @@ namespace zaplet::http
             }
         }
 
-        return headerMap;
+        return headers;
     }
 }
 
@@ -13,6 +13,7 @@
 #include <mutex>
 #include <string>
 #include <format>
+#include <utility>
 
 namespace zaplet::logging
 {
@@ -40,6 +41,16 @@ namespace zaplet::logging
         void error(const std::string& msg) const;
         void fatal(const std::string& msg) const;
 
+        // Formats the message only when the level is written, so disabled logging costs no allocation
+        template <typename... Args>
+        void log(spdlog::level::level_enum level, std::format_string<Args...> format, Args&&... args) const
+        {
+            if (m_logger->should_log(level))
+            {
+                m_logger->log(level, std::format(format, std::forward<Args>(args)...));
+            }
+        }
+
         void flush() const;
     private:
         Logger();
@@ -68,12 +79,12 @@ namespace zaplet::logging
 #define LOG_ERROR(msg) zaplet::logging::Logger::getInstance().error(msg)
 #define LOG_FATAL(msg) zaplet::logging::Logger::getInstance().fatal(msg)
 
-#define LOG_TRACE_FMT(msg, ...) zaplet::logging::Logger::getInstance().trace(std::format(msg, __VA_ARGS__))
-#define LOG_DEBUG_FMT(msg, ...) zaplet::logging::Logger::getInstance().debug(std::format(msg, __VA_ARGS__))
-#define LOG_INFO_FMT(msg, ...) zaplet::logging::Logger::getInstance().info(std::format(msg, __VA_ARGS__))
-#define LOG_WARNING_FMT(msg, ...) zaplet::logging::Logger::getInstance().warning(std::format(msg, __VA_ARGS__))
-#define LOG_ERROR_FMT(msg, ...) zaplet::logging::Logger::getInstance().error(std::format(msg, __VA_ARGS__))
-#define LOG_FATAL_FMT(msg, ...) zaplet::logging::Logger::getInstance().fatal(std::format(msg, __VA_ARGS__))
+#define LOG_TRACE_FMT(msg, ...) zaplet::logging::Logger::getInstance().log(spdlog::level::trace, msg, __VA_ARGS__)
+#define LOG_DEBUG_FMT(msg, ...) zaplet::logging::Logger::getInstance().log(spdlog::level::debug, msg, __VA_ARGS__)
+#define LOG_INFO_FMT(msg, ...) zaplet::logging::Logger::getInstance().log(spdlog::level::info, msg, __VA_ARGS__)
+#define LOG_WARNING_FMT(msg, ...) zaplet::logging::Logger::getInstance().log(spdlog::level::warn, msg, __VA_ARGS__)
+#define LOG_ERROR_FMT(msg, ...) zaplet::logging::Logger::getInstance().log(spdlog::level::err, msg, __VA_ARGS__)
+#define LOG_FATAL_FMT(msg, ...) zaplet::logging::Logger::getInstance().log(spdlog::level::critical, msg, __VA_ARGS__)
 } // namespace zaplet::logging
 
 #endif // LOGGER_H
@@ -0,0 +1,128 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace zaplet::scenario
+{
+    // A bounded multi-producer multi-consumer queue after Dmitry Vyukov. Every cell carries a sequence number telling
+    // whether it is free for the producer or filled for the consumer of the current lap, so pushing and popping each
+    // take one compare-and-swap on their end of the ring and never a lock.
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        // capacity is rounded up to a power of two
+        explicit BoundedQueue(std::size_t capacity)
+            : m_capacity(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+            , m_cells(std::make_unique<Cell[]>(m_capacity))
+        {
+            for (std::size_t i = 0; i < m_capacity; ++i)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~BoundedQueue() = default;
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        // false when the queue is full; value is left untouched then
+        bool tryPush(T& value)
+        {
+            std::size_t position = m_tail.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = m_cells[position & (m_capacity - 1)];
+                std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+
+                if (lag == 0)
+                {
+                    if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = std::move(value);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (lag < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // false when the queue is empty
+        bool tryPop(T& value)
+        {
+            std::size_t position = m_head.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell& cell = m_cells[position & (m_capacity - 1)];
+                std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto lag = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+                if (lag == 0)
+                {
+                    if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        value = std::move(cell.value);
+                        cell.sequence.store(position + m_capacity, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (lag < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Only a snapshot while producers and consumers are running
+        [[nodiscard]] std::size_t size() const
+        {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        [[nodiscard]] std::size_t capacity() const
+        {
+            return m_capacity;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence{ 0 };
+            T value{};
+        };
+
+        std::size_t m_capacity;
+        std::unique_ptr<Cell[]> m_cells;
+        // producers and consumers each keep to their own cache line
+        alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+        alignas(64) std::atomic<std::size_t> m_head{ 0 };
+    };
+} // namespace zaplet::scenario
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,64 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef BURST_BARRIER_H
+#define BURST_BARRIER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+
+namespace zaplet::scenario
+{
+    // Holds the virtual users of a burst back until all of them have their request ready, then lets them go at once.
+    // Early arrivals sleep; once the last one is in they are woken to spin on a single atomic, and only when all of
+    // them spin is it stored, so they leave within microseconds of each other instead of being woken one by one.
+    class BurstBarrier
+    {
+    public:
+        struct Release
+        {
+            // starts at 1 and counts the releases of the barrier
+            std::uint64_t round = 0;
+            std::chrono::steady_clock::time_point time;
+        };
+
+        // At least interval passes between two releases
+        BurstBarrier(std::size_t participants, std::chrono::milliseconds interval);
+        ~BurstBarrier() = default;
+
+        BurstBarrier(const BurstBarrier&) = delete;
+        BurstBarrier& operator=(const BurstBarrier&) = delete;
+
+        // Waits for the other participants; nothing once abort was requested
+        [[nodiscard]] std::optional<Release> arrive(const std::stop_token& abort);
+        // A participant that plays no more rounds; the others are released without it
+        void leave(const std::stop_token& abort);
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable_any m_wakeUp;
+        std::size_t m_participants;
+        std::size_t m_arrived = 0;
+        // the round whose participants were woken up to spin
+        std::uint64_t m_armed = 0;
+        std::chrono::milliseconds m_interval;
+        std::chrono::steady_clock::time_point m_lastRelease;
+
+        alignas(64) std::atomic<std::size_t> m_spinning{ 0 };
+        alignas(64) std::atomic<std::uint64_t> m_round{ 0 };
+        // written by the releasing participant before it publishes the round
+        std::chrono::steady_clock::time_point m_releaseTime;
+
+        // Run by whoever completes a round, without the lock, while waiting participants are asleep
+        Release release(std::uint64_t round, std::size_t waiting, const std::stop_token& abort);
+    };
+} // namespace zaplet::scenario
+
+#endif // BURST_BARRIER_H
@@ -0,0 +1,92 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef CONDITION_H
+#define CONDITION_H
+
+#include "zaplet/scenario/json_path.h"
+#include "zaplet/scenario/pattern.h"
+#include "zaplet/scenario/response_document.h"
+#include "zaplet/scenario/variables.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // A step condition parsed once into an expression tree, e.g.
+    // exists(token) && (status() == 200 || header("X-Retry") == "true") && !(json("$.items[0].name") matches "^tmp-")
+    class Condition
+    {
+    public:
+        enum class NodeKind
+        {
+            Literal,
+            Variable,
+            Not,
+            And,
+            Or,
+            Compare,
+            Function
+        };
+
+        enum class CompareOp
+        {
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+            Contains,
+            Matches
+        };
+
+        enum class Function
+        {
+            Exists,
+            Len,
+            Status,
+            Header,
+            Body,
+            Json
+        };
+
+        struct Node
+        {
+            NodeKind kind = NodeKind::Literal;
+            JsonPath::Literal literal;
+            VariableSlot slot = 0;
+            CompareOp op = CompareOp::Equal;
+            Function function = Function::Exists;
+            // operand indices in the node list; a function argument is stored in left
+            std::size_t left = 0;
+            std::size_t right = 0;
+            bool hasArgument = false;
+            std::string argument;
+            JsonPath path;
+            Pattern pattern;
+        };
+
+        Condition() = default;
+        ~Condition() = default;
+
+        static Condition compile(std::string_view expression, VariableTable& table);
+
+        // response is the last response received by the virtual user, or nullptr before the first request
+        bool evaluate(const VariableFrame& frame, ResponseDocument* response) const;
+
+        [[nodiscard]] const std::string& getSource() const;
+        [[nodiscard]] const std::vector<Node>& getNodes() const;
+
+    private:
+        std::string m_source;
+        std::vector<Node> m_nodes;
+        std::size_t m_root = 0;
+    };
+} // namespace zaplet::scenario
+
+#endif // CONDITION_H
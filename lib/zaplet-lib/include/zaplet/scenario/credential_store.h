@@ -0,0 +1,60 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef CREDENTIAL_STORE_H
+#define CREDENTIAL_STORE_H
+
+#include "zaplet/scenario/variables.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Variables a login step extracted, valid until they expire
+    struct Credential
+    {
+        std::vector<std::pair<VariableSlot, std::string>> values;
+        std::chrono::steady_clock::time_point expires = std::chrono::steady_clock::time_point::max();
+    };
+
+    // A fixed pool of credentials shared by all virtual users of a program. Every entry lives on its own cache line;
+    // readers take an immutable snapshot of it, and only the one virtual user holding the claim of an entry replaces it.
+    class CredentialStore
+    {
+    public:
+        explicit CredentialStore(std::size_t size);
+        ~CredentialStore() = default;
+
+        CredentialStore(const CredentialStore&) = delete;
+        CredentialStore& operator=(const CredentialStore&) = delete;
+
+        // The current credential of an entry, or null before the first one is published
+        [[nodiscard]] std::shared_ptr<const Credential> lease(std::size_t entry) const;
+
+        // Grants the right to renew an entry to one virtual user at a time; publish or release hands it back
+        bool claim(std::size_t entry);
+        void publish(std::size_t entry, std::shared_ptr<const Credential> credential);
+        void release(std::size_t entry);
+
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        struct alignas(64) Entry
+        {
+            std::atomic<std::shared_ptr<const Credential>> credential;
+            std::atomic<bool> claimed{ false };
+        };
+
+        std::unique_ptr<Entry[]> m_entries;
+        std::size_t m_size;
+    };
+} // namespace zaplet::scenario
+
+#endif // CREDENTIAL_STORE_H
@@ -0,0 +1,120 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef DATA_FEED_H
+#define DATA_FEED_H
+
+#include "zaplet/scenario/random.h"
+#include "zaplet/scenario/scenario.h"
+#include "zaplet/scenario/variables.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // A read-only memory mapping of a whole file
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] std::string_view getView() const;
+
+    private:
+        const char* m_data = nullptr;
+        std::size_t m_size = 0;
+#if defined(_WIN32)
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+
+    class DataCursor;
+
+    // A data file mapped into memory and shared by all virtual users. Nothing is indexed up front: cursors find
+    // record boundaries as they go. Shared modes hand out byte ranges of the file through a single atomic counter,
+    // unique cursors stride over ranges of their own.
+    class DataFeed
+    {
+    public:
+        DataFeed(const DataSource& source, VariableTable& table);
+        ~DataFeed() = default;
+
+        DataFeed(const DataFeed&) = delete;
+        DataFeed& operator=(const DataFeed&) = delete;
+
+        // A cursor for one virtual user out of virtualUsers
+        [[nodiscard]] DataCursor createCursor(std::size_t virtualUser, std::size_t virtualUsers) const;
+
+        [[nodiscard]] const std::string& getFile() const;
+        [[nodiscard]] DataMode getMode() const;
+        [[nodiscard]] const std::vector<std::string>& getColumns() const;
+        // variable slots bound to each column
+        [[nodiscard]] const std::vector<std::vector<VariableSlot>>& getBindings() const;
+
+    private:
+        friend class DataCursor;
+
+        std::string m_file;
+        bool m_ndjson = false;
+        DataMode m_mode = DataMode::Sequential;
+        char m_delimiter = ',';
+        MappedFile m_mapping;
+        // records, without the header line
+        std::string_view m_records;
+        std::vector<std::string> m_columns;
+        std::vector<std::vector<VariableSlot>> m_bindings;
+
+        std::size_t m_chunkSize = 0;
+        std::size_t m_chunkCount = 0;
+        mutable std::atomic<std::uint64_t> m_claims{ 0 };
+
+        // Start of the first record that begins at or after offset
+        [[nodiscard]] std::size_t recordStart(std::size_t offset) const;
+        // End of the record starting at offset, excluding the line break
+        [[nodiscard]] std::size_t recordEnd(std::size_t offset) const;
+    };
+
+    // Per virtual user position in a data feed; reading a record never takes a lock
+    class DataCursor
+    {
+    public:
+        DataCursor(const DataFeed& feed, std::size_t virtualUser, std::size_t virtualUsers);
+
+        // Binds the next record to the frame; false once a sequential or unique feed is exhausted
+        bool next(VariableFrame& frame);
+
+        [[nodiscard]] const DataFeed& getFeed() const;
+
+    private:
+        const DataFeed* m_feed;
+        std::size_t m_virtualUser;
+        std::size_t m_virtualUsers;
+        std::size_t m_position = 0;
+        std::size_t m_claimEnd = 0;
+        // the next range a unique cursor reads, and the size of its ranges, small enough for every cursor to get some
+        std::size_t m_nextRange;
+        std::size_t m_rangeSize;
+        Random m_random;
+        std::string m_field;
+
+        // Moves to the next range of the file the cursor reads; false once there is none
+        bool claim();
+        [[nodiscard]] bool findRecord(std::string_view& record);
+        void bindCsv(std::string_view record, VariableFrame& frame);
+        bool bindJson(std::string_view record, VariableFrame& frame);
+    };
+} // namespace zaplet::scenario
+
+#endif // DATA_FEED_H
@@ -0,0 +1,60 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+#include "zaplet/scenario/scenario.h"
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Which top-level steps of a scenario must finish before others start, derived from the variables each step
+    // reads and writes plus explicit depends_on hints. Steps on the same level can run concurrently.
+    class DependencyGraph
+    {
+    public:
+        struct Edge
+        {
+            std::size_t from = 0;
+            // the shared variable, "depends_on" or "barrier"
+            std::string reason;
+        };
+
+        struct Node
+        {
+            std::string name;
+            std::set<std::string> reads;
+            std::set<std::string> writes;
+            std::vector<Edge> dependencies;
+            // set for steps that cannot share a level: loops, parallel groups and conditions on the last response
+            std::string barrier;
+            std::size_t level = 0;
+        };
+
+        DependencyGraph() = default;
+        ~DependencyGraph() = default;
+
+        static DependencyGraph build(const Scenario& scenario);
+
+        [[nodiscard]] const std::vector<Node>& getNodes() const;
+        // step indices grouped by level, in execution order
+        [[nodiscard]] const std::vector<std::vector<std::size_t>>& getLevels() const;
+
+        [[nodiscard]] std::string dump() const;
+        // Graphviz representation
+        [[nodiscard]] std::string toDot() const;
+
+    private:
+        std::string m_name;
+        std::vector<Node> m_nodes;
+        std::vector<std::vector<std::size_t>> m_levels;
+    };
+} // namespace zaplet::scenario
+
+#endif // DEPENDENCY_GRAPH_H
@@ -0,0 +1,50 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef EXTRACTOR_H
+#define EXTRACTOR_H
+
+#include "zaplet/scenario/json_path.h"
+#include "zaplet/scenario/pattern.h"
+#include "zaplet/scenario/response_document.h"
+
+#include <string>
+
+namespace zaplet::scenario
+{
+    // A compiled `variables:` rule: $.json.path, header.Name, status_code, body or regex:pattern
+    class Extractor
+    {
+    public:
+        enum class Kind
+        {
+            JsonPath,
+            Header,
+            StatusCode,
+            Body,
+            Regex
+        };
+
+        Extractor() = default;
+        ~Extractor() = default;
+
+        static Extractor compile(const std::string& rule);
+
+        bool extract(ResponseDocument& document, std::string& out) const;
+
+        [[nodiscard]] Kind getKind() const;
+        [[nodiscard]] const std::string& getRule() const;
+        [[nodiscard]] const JsonPath& getPath() const;
+        [[nodiscard]] const Pattern& getPattern() const;
+
+    private:
+        Kind m_kind = Kind::Body;
+        std::string m_rule;
+        std::string m_argument;
+        JsonPath m_path;
+        Pattern m_pattern;
+    };
+} // namespace zaplet::scenario
+
+#endif // EXTRACTOR_H
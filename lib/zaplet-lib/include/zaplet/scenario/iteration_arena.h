@@ -0,0 +1,48 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef ITERATION_ARENA_H
+#define ITERATION_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace zaplet::scenario
+{
+    // Scratch memory of one virtual user for the duration of one iteration. Allocations bump a pointer through a
+    // buffer the arena keeps between iterations and deallocations do nothing; reset() takes everything back at once.
+    // When an iteration outgrew the buffer, reset() replaces it with one holding all of it, so a steady run stops
+    // touching the global heap after its first iterations. Not thread-safe: every thread needs its own arena.
+    class IterationArena : public std::pmr::memory_resource
+    {
+    public:
+        explicit IterationArena(std::size_t initialBytes = 4096);
+        ~IterationArena() override = default;
+
+        IterationArena(const IterationArena&) = delete;
+        IterationArena& operator=(const IterationArena&) = delete;
+
+        // Every container allocated from the arena must have released its memory before
+        void reset();
+
+        // bytes handed out since the last reset
+        [[nodiscard]] std::size_t getUsed() const;
+        [[nodiscard]] std::size_t getCapacity() const;
+
+    private:
+        std::unique_ptr<std::byte[]> m_buffer;
+        std::size_t m_capacity;
+        std::size_t m_used = 0;
+        // taking over whatever does not fit the buffer until the next reset
+        std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+} // namespace zaplet::scenario
+
+#endif // ITERATION_ARENA_H
@@ -0,0 +1,91 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef JSON_PATH_H
+#define JSON_PATH_H
+
+#include <nlohmann/json_fwd.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Supported syntax: $.a.b, $['a'], $.items[0], $.items[-1], $.items[*], $.*,
+    // $.items[?(@.id == 5)], $.items[?(@.name != 'x')], $.items[?(@.flag)]
+    class JsonPath
+    {
+    public:
+        struct Literal
+        {
+            enum class Type
+            {
+                Null,
+                Boolean,
+                Number,
+                String
+            };
+
+            Type type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string string;
+        };
+
+        enum class FilterOp
+        {
+            Exists,
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual
+        };
+
+        struct Filter
+        {
+            std::vector<std::string> fields;
+            FilterOp op = FilterOp::Exists;
+            Literal literal;
+        };
+
+        enum class StepKind
+        {
+            Field,
+            Index,
+            Wildcard,
+            Filter
+        };
+
+        struct Step
+        {
+            StepKind kind = StepKind::Field;
+            std::string field;
+            std::int64_t index = 0;
+            Filter filter;
+        };
+
+        JsonPath() = default;
+        ~JsonPath() = default;
+
+        static JsonPath compile(std::string_view expression);
+
+        const nlohmann::json* selectFirst(const nlohmann::json& root) const;
+        void select(const nlohmann::json& root, std::vector<const nlohmann::json*>& out) const;
+
+        [[nodiscard]] bool isDefinite() const;
+        [[nodiscard]] const std::string& getExpression() const;
+        [[nodiscard]] const std::vector<Step>& getSteps() const;
+
+    private:
+        std::string m_expression;
+        std::vector<Step> m_steps;
+        bool m_definite = true;
+    };
+} // namespace zaplet::scenario
+
+#endif // JSON_PATH_H
@@ -0,0 +1,47 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include "zaplet/scenario/json_path.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Resolves a set of definite JSON paths with a SAX pass over the body, without building a DOM,
+    // and stops reading as soon as every path has been found
+    class JsonStreamSelector
+    {
+    public:
+        struct Key
+        {
+            bool isIndex = false;
+            std::size_t index = 0;
+            std::string field;
+        };
+
+        JsonStreamSelector() = default;
+        ~JsonStreamSelector() = default;
+
+        // Only paths made of fields and non-negative indices can be resolved in a single forward pass
+        static bool supports(const JsonPath& path);
+
+        std::size_t addPath(const JsonPath& path);
+        [[nodiscard]] std::size_t size() const;
+
+        // Returns false when the text is not valid JSON up to the point where all paths were resolved
+        bool select(std::string_view text, std::vector<std::optional<std::string>>& results) const;
+
+    private:
+        std::vector<std::vector<Key>> m_paths;
+    };
+} // namespace zaplet::scenario
+
+#endif // JSON_STREAM_H
@@ -0,0 +1,150 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "zaplet/http/response.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Request and iteration statistics. Each player and parallel lane fills its own instance without any
+    // synchronisation; instances are merged once the virtual users have finished.
+    class Metrics
+    {
+    public:
+        // Requests sent to one node of a target group
+        struct TargetStats
+        {
+            std::string label;
+            std::uint64_t requests = 0;
+            std::uint64_t failed = 0;
+            std::uint64_t latencyTotal = 0;
+            std::uint64_t latencyMax = 0;
+        };
+
+        // Stages of handling a response: the request thread extracts what the following steps read, a worker of the
+        // response pipeline extracts, validates and prints the rest
+        enum class Stage
+        {
+            Respond,
+            Process
+        };
+
+        struct StageStats
+        {
+            std::uint64_t jobs = 0;
+            std::chrono::nanoseconds serviceTotal{ 0 };
+            std::chrono::nanoseconds serviceMax{ 0 };
+            // time spent in the queue in front of the stage, and how many jobs were queued when each one arrived
+            std::chrono::nanoseconds waitTotal{ 0 };
+            std::uint64_t depthTotal = 0;
+            std::uint64_t depthMax = 0;
+            // jobs the request thread ran itself because the queue was full
+            std::uint64_t overflows = 0;
+        };
+
+        // How the HTTP cache of the virtual users served one step
+        struct HttpCacheStats
+        {
+            std::string step;
+            std::uint64_t hits = 0;
+            std::uint64_t revalidations = 0;
+            std::uint64_t misses = 0;
+        };
+
+        Metrics() = default;
+        ~Metrics() = default;
+
+        void recordRequest(std::chrono::milliseconds latency, bool success);
+        // index numbers the steps of the program, so that lanes and virtual users merge them by position; the stats of
+        // different programs are merged by step name
+        void recordHttpCache(std::size_t index, const std::string& step, http::CacheStatus status);
+        void recordIteration(bool success);
+        // Time a request waited for its rate limit, which is not part of its latency
+        void recordRateLimitWait(std::chrono::nanoseconds wait);
+        void recordRateLimitSkip();
+        // A step whose cached variables were replayed instead of sending it
+        void recordCacheHit();
+        // A request sent by a burst; offset is how long after the release of its round it went out
+        void recordBurst(std::uint64_t round, std::chrono::nanoseconds offset, std::chrono::milliseconds latency);
+        // A request sent to a target group node; index numbers the nodes of all groups of the program
+        void recordTarget(std::size_t index, const std::string& label, std::chrono::milliseconds latency, bool success);
+        void recordStage(Stage stage, std::chrono::nanoseconds service, std::chrono::nanoseconds wait = std::chrono::nanoseconds(0));
+        // The queue in front of a stage as a job arrived at it
+        void recordQueue(Stage stage, std::size_t depth, bool overflow);
+        // Requests recorded as successful whose validation failed afterwards, off the request thread
+        void recordLateFailures(std::uint64_t count);
+        void merge(const Metrics& other);
+        void reset();
+
+        [[nodiscard]] std::uint64_t getRequests() const;
+        [[nodiscard]] std::uint64_t getFailedRequests() const;
+        [[nodiscard]] std::uint64_t getIterations() const;
+        [[nodiscard]] std::uint64_t getFailedIterations() const;
+        [[nodiscard]] double getMeanLatency() const;
+        [[nodiscard]] std::uint64_t getMaxLatency() const;
+        // Latency in milliseconds below which the given fraction of requests fall, within about 3%
+        [[nodiscard]] std::uint64_t getLatencyPercentile(double fraction) const;
+        [[nodiscard]] std::uint64_t getRateLimitWaits() const;
+        [[nodiscard]] std::chrono::nanoseconds getRateLimitWaitTime() const;
+        [[nodiscard]] std::uint64_t getRateLimitSkips() const;
+        [[nodiscard]] std::uint64_t getCacheHits() const;
+        // The largest spread of send times within one burst round
+        [[nodiscard]] std::chrono::nanoseconds getMaxSendSkew() const;
+        // indexed by node, nodes no request was sent to having no label; merged from several programs, one per label
+        [[nodiscard]] const std::vector<TargetStats>& getTargets() const;
+        [[nodiscard]] const std::vector<HttpCacheStats>& getHttpCache() const;
+        [[nodiscard]] const StageStats& getStage(Stage stage) const;
+
+        // A short multi-line report; elapsed is the wall time of the run, used for throughput
+        [[nodiscard]] std::string format(const std::string& title, std::chrono::milliseconds elapsed) const;
+
+    private:
+        struct BurstSend
+        {
+            std::uint64_t round = 0;
+            std::chrono::nanoseconds offset{ 0 };
+            std::uint64_t latency = 0;
+        };
+
+        // Log-linear histogram: exact below SUB_BUCKETS ms, then SUB_BUCKETS buckets per power of two
+        static constexpr std::size_t SUB_BUCKET_BITS = 5;
+        static constexpr std::size_t SUB_BUCKETS = std::size_t{ 1 } << SUB_BUCKET_BITS;
+        static constexpr std::size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+        std::uint64_t m_requests = 0;
+        std::uint64_t m_failedRequests = 0;
+        std::uint64_t m_iterations = 0;
+        std::uint64_t m_failedIterations = 0;
+        std::uint64_t m_latencyTotal = 0;
+        std::uint64_t m_latencyMax = 0;
+        std::array<std::uint64_t, BUCKET_COUNT> m_histogram{};
+        std::uint64_t m_rateLimitWaits = 0;
+        std::chrono::nanoseconds m_rateLimitWaitTime{ 0 };
+        std::chrono::nanoseconds m_rateLimitWaitMax{ 0 };
+        std::uint64_t m_rateLimitSkips = 0;
+        std::uint64_t m_cacheHits = 0;
+        // few enough to keep them all: one per virtual user and round
+        std::vector<BurstSend> m_bursts;
+        std::vector<TargetStats> m_targets;
+        std::vector<HttpCacheStats> m_httpCache;
+        std::array<StageStats, 2> m_stages{};
+
+        // Send time spread of every round
+        [[nodiscard]] std::vector<std::chrono::nanoseconds> sendSkews() const;
+
+        static std::size_t bucketOf(std::uint64_t value);
+        static std::uint64_t bucketValue(std::size_t bucket);
+    };
+} // namespace zaplet::scenario
+
+#endif // METRICS_H
@@ -0,0 +1,39 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef MIX_H
+#define MIX_H
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    struct MixEntry
+    {
+        std::string file;
+        // share of the mix virtual users
+        double weight = 0.0;
+        // a fixed number of virtual users instead of a weight
+        std::optional<std::size_t> virtualUsers;
+    };
+
+    // Several scenario files played together in one run, for a blend of traffic
+    struct Mix
+    {
+        std::string name;
+        std::string description;
+        std::optional<std::size_t> virtualUsers;
+        std::optional<std::chrono::milliseconds> duration;
+        std::vector<MixEntry> entries;
+
+        // Virtual users of each entry: fixed entries first, the rest split by weight with at least one each
+        [[nodiscard]] std::vector<std::size_t> allocate(std::size_t total) const;
+    };
+} // namespace zaplet::scenario
+
+#endif // MIX_H
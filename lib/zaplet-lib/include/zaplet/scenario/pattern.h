@@ -0,0 +1,50 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace re2
+{
+    class RE2;
+} // namespace re2
+
+namespace zaplet::scenario
+{
+    // A user regular expression compiled once with RE2, which matches in linear time.
+    // Named groups use the (?P<name>...) syntax.
+    class Pattern
+    {
+    public:
+        Pattern() = default;
+        ~Pattern() = default;
+
+        static Pattern compile(const std::string& pattern);
+
+        // groups[0] is the whole match; groups that did not participate are empty views with a null data pointer
+        bool search(std::string_view text, std::vector<std::string_view>& groups) const;
+        bool fullMatch(std::string_view text, std::vector<std::string_view>& groups) const;
+        [[nodiscard]] bool contains(std::string_view text) const;
+
+        [[nodiscard]] const std::string& getSource() const;
+        [[nodiscard]] std::size_t getGroupCount() const;
+        [[nodiscard]] const std::vector<std::pair<std::string, std::size_t>>& getNamedGroups() const;
+
+    private:
+        std::string m_source;
+        std::shared_ptr<const re2::RE2> m_regex;
+        std::vector<std::pair<std::string, std::size_t>> m_namedGroups;
+
+        bool match(std::string_view text, bool anchored, std::vector<std::string_view>& groups) const;
+    };
+} // namespace zaplet::scenario
+
+#endif // PATTERN_H
@@ -7,36 +7,207 @@
 
 #include "zaplet/http/client.h"
 #include "zaplet/output/formatter.h"
+#include "zaplet/scenario/burst_barrier.h"
+#include "zaplet/scenario/condition.h"
+#include "zaplet/scenario/data_feed.h"
+#include "zaplet/scenario/iteration_arena.h"
+#include "zaplet/scenario/metrics.h"
+#include "zaplet/scenario/program.h"
+#include "zaplet/scenario/response_document.h"
+#include "zaplet/scenario/response_pipeline.h"
 #include "zaplet/scenario/scenario.h"
+#include "zaplet/scenario/variables.h"
 
-#include <map>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <memory_resource>
+#include <stop_token>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace zaplet::scenario
 {
     class Player
     {
     public:
+        // Values the run-scope setup extracted, published once before the virtual users start and never modified
+        using SharedVariables = std::shared_ptr<const std::vector<std::pair<VariableSlot, std::string>>>;
+
         Player(std::shared_ptr<http::Client> client, std::shared_ptr<output::Formatter> formatter);
         ~Player() = default;
 
         bool play(const Scenario& scenario);
+        bool play(std::shared_ptr<const Program> program);
         bool playFile(const std::string& filePath);
 
+        // Which of the concurrently running virtual users this player is; data feeds use it to split records
+        void setVirtualUser(std::size_t index, std::size_t count);
+
+        // Virtual users of a burst program meet at this barrier before every iteration; without one they play it unsynchronised
+        void setBurstBarrier(std::shared_ptr<BurstBarrier> barrier);
+
+        // Once drain is requested no new iteration starts; once abort is requested the running one stops before its next step
+        void setStopTokens(std::stop_token drain, std::stop_token abort);
+
+        // Responses of the main phase are formatted, logged and partly extracted and validated by the pipeline
+        // workers; without one the player does all of it before sending the next request
+        void setPipeline(std::shared_ptr<ResponsePipeline> pipeline);
+
+        // Statistics of the last play, including the requests of parallel steps
+        [[nodiscard]] const Metrics& getMetrics() const;
+
+        // Run-scope phases: a runner plays the setup once, hands its variables to every virtual user and plays
+        // the teardown on the same player after all of them finished. Without shared variables play() runs both itself.
+        bool runSetup(std::shared_ptr<const Program> program);
+        bool runTeardown();
+        [[nodiscard]] SharedVariables getSharedVariables() const;
+        void setSharedVariables(SharedVariables variables);
+
     private:
+        enum class BranchState
+        {
+            Idle,
+            Busy,
+            Stop
+        };
+
+        // Scratch state of one in-flight request; parallel steps each get their own
+        struct Lane
+        {
+            using Writes = std::pmr::vector<std::pair<VariableSlot, std::pmr::string>>;
+
+            Lane() = default;
+            // Stops the worker once it finished its branch
+            ~Lane();
+
+            // scratch of the current iteration, allocated only by the thread running the lane
+            IterationArena arena;
+            std::string buffer;
+            std::string extracted;
+            std::vector<std::optional<std::string>> streamed;
+            std::vector<std::string_view> groups;
+            // shared with the pipeline job of the response, and replaced rather than overwritten once handed to one
+            std::shared_ptr<http::Response> response = std::make_shared<http::Response>();
+            bool handedOff = false;
+            std::optional<ResponseDocument> document;
+            // parallel steps collect their variables here until the group joins
+            bool deferred = false;
+            Writes writes{ &arena };
+            bool success = true;
+            // seeds the template function generator of the worker thread that sends the step
+            std::uint64_t seed = 0;
+            // drawn before the group fans out, so the workers never touch the think time generator
+            std::chrono::milliseconds delay{ 0 };
+            // node of the target group the rendered request goes to, held until its response arrived
+            std::optional<std::size_t> node;
+            Metrics metrics;
+            // parallel lanes past the first send their branches from a thread started at their first fan-out and kept
+            // for the rest of the play; Busy hands it a branch, Idle hands it back
+            std::atomic<BranchState> state{ BranchState::Idle };
+            std::jthread worker;
+        };
+
+        struct LoopState
+        {
+            using Items = std::pmr::vector<std::pmr::string>;
+
+            explicit LoopState(std::pmr::memory_resource* arena)
+                : items(arena)
+            {
+            }
+
+            std::size_t index = 0;
+            std::size_t count = 0;
+            Items items;
+        };
+
         std::shared_ptr<http::Client> m_client;
         std::shared_ptr<output::Formatter> m_formatter;
-        std::map<std::string, std::string> m_variables;
+        std::shared_ptr<const Program> m_program;
+        std::size_t m_virtualUser = 0;
+        std::size_t m_virtualUsers = 1;
+
+        // Mutable per-player state; the program itself is never modified while running
+        VariableFrame m_frame;
+        std::vector<http::Request> m_requests;
+        std::vector<DataCursor> m_cursors;
+        // set when the program gives every virtual user an HTTP cache; kept for the whole run, as a browser keeps it
+        std::unique_ptr<http::ResponseCache> m_httpCache;
+        // variables of the steps cached per virtual user, replayed until they expire
+        std::vector<std::shared_ptr<const Credential>> m_cached;
+        // lane 0 runs the sequential steps, the others the steps of a parallel group; a deque keeps them in place
+        std::deque<Lane> m_lanes;
+        // foreach items live in the arena of the first lane, so they are declared after the lanes and go first
+        std::vector<LoopState> m_loops;
+        std::vector<std::size_t> m_forked;
+        // the lane holding the last response, available to the conditions of the following steps
+        Lane* m_last = nullptr;
+        Metrics m_metrics;
+        // think times and pacing offsets; kept apart from the template generator so pauses do not shift generated values
+        Random m_random;
+        SharedVariables m_sharedVariables;
+        std::shared_ptr<BurstBarrier> m_burst;
+        std::shared_ptr<ResponsePipeline> m_pipeline;
+        std::shared_ptr<ResponsePipeline::Sink> m_sink;
+        std::stop_token m_drain;
+        std::stop_token m_abort;
+        // setup and teardown requests are left out of the metrics
+        bool m_recording = true;
+
+        void prepare(std::shared_ptr<const Program> program);
+        bool runPhase(Program::Phase phase);
+        bool runSection(const Program::Section& section);
+        // Hands the scratch memory of the last iteration back to the arenas of the lanes
+        void resetScratch();
+        // Sleeps, waking up early when the run is aborted
+        void pause(std::chrono::nanoseconds duration) const;
+        bool bindData();
+        bool executeStep(const Program::StepCode& step, http::Request& request, Lane& lane);
+        // Binds the cached variables of the step; false when it has to be sent, claimed telling whether this
+        // virtual user refreshes the shared entry
+        bool replayCache(const Program::StepCode& step, Lane& lane, bool& claimed);
+        void storeCache(const Program::StepCode& step, const Lane& lane, bool success, bool claimed);
+        // Takes a token from every rate limit of the request; false when one of them skips it
+        bool throttle(const Program::StepCode& step, const http::Request& request, Lane& lane);
+        bool takeToken(const Program::RateLimitCode& limit, Lane& lane);
+        // Stores the response of the step sent in the lane
+        void receive(Lane& lane, http::Response response);
+        // Extracts, validates and records the response in the lane
+        bool completeStep(const Program::StepCode& step, Lane& lane);
+        // Counts the late validation failures of the responses the pipeline finished, first waiting for all of them
+        // when wait is set; false when one failed
+        bool collectPipeline(bool wait);
+        // Hands the node of the request back to its group, recording it unless the request was never sent
+        void releaseTarget(const Program::StepCode& step, Lane& lane, std::optional<bool> success);
+        // An iteration whose first request is sent together with the other virtual users of the burst
+        bool runBurst();
+        bool sendBurst(const Program::StepCode& step, http::Request& request, Lane& lane);
+        bool executeParallel(const Program::StepCode& group);
+        // Sends the index-th forked step of the current parallel group in its lane
+        void runBranch(std::size_t index);
+        // The loop of the worker thread of a parallel lane
+        void serveBranches(std::size_t index);
+
+        bool leaseCredential(std::size_t stepIndex);
+        bool renewCredential(std::size_t stepIndex, std::size_t entry, const Credential* current);
+        void bindCredential(const Credential& credential);
 
-        bool executeStep(const Step& step);
+        bool startLoop(std::size_t loopIndex);
+        void bindLoopItem(std::size_t loopIndex);
 
-        std::string replaceVariables(const std::string& input);
-        http::Request replaceVariablesInRequest(const http::Request& request);
+        const http::Request& renderRequest(const Program::StepCode& step, http::Request& request, Lane& lane);
 
-        void extractVariables(const Step& step, const http::Response& response);
-        bool evaluateCondition(const std::optional<std::string>& condition);
-        bool validateResponse(const Step& step, const http::Response& actualResponse) const;
+        // liveOnly leaves the extractions nothing reads to the pipeline
+        void extractVariables(const Program::StepCode& step, ResponseDocument& document, Lane& lane, bool liveOnly);
+        void assign(Lane& lane, VariableSlot slot, std::string_view value);
+        bool evaluateCondition(const Condition& condition);
     };
 } // namespace zaplet::scenario
 
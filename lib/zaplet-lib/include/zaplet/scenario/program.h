@@ -0,0 +1,258 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "zaplet/http/url.h"
+#include "zaplet/scenario/condition.h"
+#include "zaplet/scenario/credential_store.h"
+#include "zaplet/scenario/data_feed.h"
+#include "zaplet/scenario/extractor.h"
+#include "zaplet/scenario/json_stream.h"
+#include "zaplet/scenario/pattern.h"
+#include "zaplet/scenario/scenario.h"
+#include "zaplet/scenario/target_group.h"
+#include "zaplet/scenario/template.h"
+#include "zaplet/scenario/token_bucket.h"
+#include "zaplet/scenario/validator.h"
+#include "zaplet/scenario/variables.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // A scenario lowered once into immutable step code and a flat instruction list.
+    // Everything a virtual user changes while running lives in its VariableFrame and request buffers.
+    class Program
+    {
+    public:
+        using StringId = std::size_t;
+
+        enum class OpCode
+        {
+            // sleep for the step delay
+            Delay,
+            // evaluate the step condition and jump to target when it is false
+            Branch,
+            // render, send, extract and validate the step
+            Request,
+            // start a loop, binding its first item, or jump to target when it has none
+            Loop,
+            // advance a loop and jump back to target while items remain
+            Next,
+            // send the parallel steps of a group concurrently and wait for all of them
+            Fork,
+            // bind a pooled credential, sending the step only when none is valid
+            Lease
+        };
+
+        enum class Phase
+        {
+            Setup,
+            Main,
+            Teardown
+        };
+
+        // The range of the code one phase runs, from begin up to end
+        struct Section
+        {
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            PhaseScope scope = PhaseScope::Run;
+        };
+
+        struct Instruction
+        {
+            OpCode op = OpCode::Request;
+            // loop index for Loop and Next, step index otherwise
+            std::size_t operand = 0;
+            std::size_t target = 0;
+        };
+
+        struct LoopCode
+        {
+            std::size_t step = 0;
+            int count = 0;
+            // foreach source, rendered and parsed as a JSON array when the loop starts
+            std::optional<Template> items;
+            VariableSlot indexSlot = 0;
+            VariableSlot itemSlot = 0;
+        };
+
+        struct CredentialCode
+        {
+            std::shared_ptr<CredentialStore> store;
+            // variables published with a credential: everything the login and refresh steps extract
+            std::vector<VariableSlot> slots;
+            std::optional<std::chrono::milliseconds> ttl;
+            std::optional<VariableSlot> expiresIn;
+            std::chrono::milliseconds refreshBefore{ 0 };
+            std::optional<std::size_t> refresh;
+        };
+
+        struct CacheCode
+        {
+            // the one entry all virtual users replay, for the global scope; virtual users keep their own otherwise
+            std::shared_ptr<CredentialStore> shared;
+            // every variable the step extracts
+            std::vector<VariableSlot> slots;
+            std::optional<std::chrono::milliseconds> ttl;
+        };
+
+        struct RateLimitCode
+        {
+            std::shared_ptr<TokenBucket> bucket;
+            RateLimitAction action = RateLimitAction::Wait;
+            // set for the limits of the scenario, which apply to every request whose URL it matches
+            std::optional<Pattern> match;
+        };
+
+        struct TargetCode
+        {
+            std::shared_ptr<TargetGroup> group;
+            // consistent hashing key
+            std::optional<Template> key;
+            // index of the first node of the group among the nodes of all groups
+            std::size_t firstNode = 0;
+        };
+
+        struct Extraction
+        {
+            VariableSlot slot = 0;
+            Extractor extractor;
+            // regex capture group index for each variable the rule assigns
+            std::vector<std::pair<VariableSlot, std::size_t>> groups;
+            // false when nothing reads the variables it assigns; a response pipeline then runs it off the request thread
+            bool live = true;
+        };
+
+        struct StepCode
+        {
+            StringId name = 0;
+            std::string description;
+            StringId method = 0;
+            int timeout = 30;
+            std::optional<ThinkTime> delay;
+            // set when the scheme, host and port are constant; url then renders only the path
+            std::optional<http::Url> origin;
+            Template url;
+            std::vector<std::pair<StringId, Template>> headers;
+            std::optional<Template> body;
+            std::vector<std::pair<StringId, Template>> queryParams;
+            std::vector<Extraction> extractions;
+            std::vector<Extraction> streamedExtractions;
+            JsonStreamSelector jsonStream;
+            std::optional<Condition> condition;
+            std::optional<ResponseValidator> validator;
+            // indices of the concurrently sent steps when this step is a parallel group
+            std::vector<std::size_t> parallel;
+            // index of the credential pool this login step fills
+            std::optional<std::size_t> credential;
+            // the step is only sent on demand, to refresh a credential
+            bool refresh = false;
+            // index of the cache replaying the variables of the step
+            std::optional<std::size_t> cache;
+            // index of the rate limit of the step itself
+            std::optional<std::size_t> rateLimit;
+            // index of the target group picking the origin of each request; url then renders only the path
+            std::optional<std::size_t> target;
+            // the run goes on whatever the validator finds and no credential or cache waits for it, so a response
+            // pipeline may validate after the next step was sent
+            bool lateValidation = false;
+        };
+
+        Program() = default;
+        ~Program() = default;
+
+        Program(Program&&) noexcept = default;
+        Program& operator=(Program&&) noexcept = default;
+
+        static Program compile(const Scenario& scenario);
+
+        // A frame with every slot the program uses, holding the environment values
+        [[nodiscard]] VariableFrame createFrame() const;
+
+        [[nodiscard]] const std::string& getName() const;
+        [[nodiscard]] const std::string& getDescription() const;
+        [[nodiscard]] std::optional<int> getRepeatCount() const;
+        [[nodiscard]] bool getContinueOnError() const;
+        [[nodiscard]] std::size_t getVirtualUsers() const;
+        // seed of the template function generators; drawn at random when the scenario sets none
+        [[nodiscard]] std::uint64_t getSeed() const;
+        [[nodiscard]] std::optional<std::chrono::milliseconds> getDuration() const;
+        [[nodiscard]] const ThinkTime& getThinkTime() const;
+        [[nodiscard]] std::optional<std::chrono::milliseconds> getPacing() const;
+        [[nodiscard]] const std::optional<BurstPolicy>& getBurst() const;
+        [[nodiscard]] const std::optional<HttpCachePolicy>& getHttpCache() const;
+
+        [[nodiscard]] const VariableTable& getTable() const;
+        [[nodiscard]] const std::string& getString(StringId id) const;
+        [[nodiscard]] const std::vector<StepCode>& getSteps() const;
+        [[nodiscard]] const std::vector<Instruction>& getCode() const;
+        [[nodiscard]] const std::vector<LoopCode>& getLoops() const;
+        [[nodiscard]] const std::vector<std::shared_ptr<const DataFeed>>& getData() const;
+        [[nodiscard]] const std::vector<CredentialCode>& getCredentials() const;
+        [[nodiscard]] const std::vector<CacheCode>& getCaches() const;
+        [[nodiscard]] const std::vector<RateLimitCode>& getRateLimits() const;
+        [[nodiscard]] const std::vector<TargetCode>& getTargets() const;
+        // the largest number of steps any parallel group sends at once
+        [[nodiscard]] std::size_t getParallelWidth() const;
+        [[nodiscard]] const Section& getSection(Phase phase) const;
+        // slots the setup phase extracts into, handed from the setup run to every virtual user
+        [[nodiscard]] const std::vector<VariableSlot>& getSharedSlots() const;
+
+        // Human readable listing of slots, strings, steps and instructions
+        [[nodiscard]] std::string dump() const;
+
+    private:
+        std::string m_name;
+        std::string m_description;
+        std::optional<int> m_repeatCount;
+        bool m_continueOnError = false;
+        std::size_t m_virtualUsers = 1;
+        std::uint64_t m_seed = 0;
+        std::optional<std::chrono::milliseconds> m_duration;
+        ThinkTime m_thinkTime;
+        std::optional<std::chrono::milliseconds> m_pacing;
+        std::optional<BurstPolicy> m_burst;
+        std::optional<HttpCachePolicy> m_httpCache;
+
+        VariableTable m_table;
+        std::vector<std::pair<VariableSlot, std::string>> m_initialValues;
+        Template::Constants m_constants;
+        std::vector<std::string> m_strings;
+        std::vector<StepCode> m_steps;
+        std::vector<Instruction> m_code;
+        std::vector<LoopCode> m_loops;
+        std::vector<std::shared_ptr<const DataFeed>> m_data;
+        std::vector<CredentialCode> m_credentials;
+        std::vector<CacheCode> m_caches;
+        std::vector<RateLimitCode> m_rateLimits;
+        std::vector<TargetCode> m_targets;
+        std::size_t m_parallelWidth = 0;
+        Section m_setup;
+        Section m_main;
+        Section m_teardown;
+        std::vector<VariableSlot> m_sharedSlots;
+
+        StringId intern(const std::string& value);
+        StepCode compileStep(const Step& step, std::vector<std::pair<std::string, Extractor>>& extractors, bool jsonStreaming);
+        void collectSlots(std::size_t stepIndex, std::vector<VariableSlot>& slots) const;
+        // Whether any template, condition or published variable list reads each slot
+        [[nodiscard]] std::vector<bool> collectReads() const;
+        void compileCredentials(const std::vector<std::pair<std::size_t, const Step*>>& steps);
+        void compileCaches(const std::vector<std::pair<std::size_t, const Step*>>& steps);
+        void emitStep(std::size_t stepIndex, const Step& step);
+    };
+} // namespace zaplet::scenario
+
+#endif // PROGRAM_H
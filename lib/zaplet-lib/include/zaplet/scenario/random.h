@@ -0,0 +1,40 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <array>
+#include <cstdint>
+
+namespace zaplet::scenario
+{
+    // xoshiro256** generator used by template functions. Every thread owns one, seeded from the run seed
+    // and the virtual user, so a run with the same seed produces the same values.
+    class Random
+    {
+    public:
+        Random();
+        explicit Random(std::uint64_t seed);
+
+        // The generator of the calling thread; seeded from std::random_device until seed() is called
+        static Random& local();
+
+        // Combines a seed with a stream number into an independent seed
+        static std::uint64_t mix(std::uint64_t seed, std::uint64_t stream);
+
+        void seed(std::uint64_t seed);
+
+        std::uint64_t next();
+        // Uniform in [0, bound)
+        std::uint64_t below(std::uint64_t bound);
+        // Uniform in [0, 1)
+        double uniform();
+
+    private:
+        std::array<std::uint64_t, 4> m_state{};
+    };
+} // namespace zaplet::scenario
+
+#endif // RANDOM_H
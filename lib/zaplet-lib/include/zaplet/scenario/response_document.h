@@ -0,0 +1,38 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef RESPONSE_DOCUMENT_H
+#define RESPONSE_DOCUMENT_H
+
+#include "zaplet/http/response.h"
+
+#include <nlohmann/json_fwd.hpp>
+
+#include <memory>
+
+namespace zaplet::scenario
+{
+    // A response together with its body parsed as JSON at most once, shared by all extractors and validators of a step
+    class ResponseDocument
+    {
+    public:
+        explicit ResponseDocument(const http::Response& response);
+        ~ResponseDocument();
+
+        ResponseDocument(const ResponseDocument&) = delete;
+        ResponseDocument& operator=(const ResponseDocument&) = delete;
+
+        [[nodiscard]] const http::Response& getResponse() const;
+
+        // nullptr when the body is not valid JSON
+        const nlohmann::json* getJson();
+
+    private:
+        const http::Response& m_response;
+        std::unique_ptr<nlohmann::json> m_json;
+        bool m_parsed = false;
+    };
+} // namespace zaplet::scenario
+
+#endif // RESPONSE_DOCUMENT_H
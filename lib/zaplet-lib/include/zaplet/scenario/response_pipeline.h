@@ -0,0 +1,87 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef RESPONSE_PIPELINE_H
+#define RESPONSE_PIPELINE_H
+
+#include "zaplet/http/response.h"
+#include "zaplet/output/formatter.h"
+#include "zaplet/scenario/bounded_queue.h"
+#include "zaplet/scenario/metrics.h"
+#include "zaplet/scenario/program.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Post-processing of responses on a pool of workers shared by all virtual users. A request thread only extracts
+    // the variables the following steps read and hands the response over through a bounded lock-free queue; the
+    // workers run the remaining extractions, late validations and the formatting and logging of the response.
+    class ResponsePipeline
+    {
+    public:
+        // What the jobs of one virtual user report back. The virtual user waits for pending to drop to zero before
+        // its program or steps may go away, and before reading the statistics.
+        struct Sink
+        {
+            std::atomic<std::size_t> pending{ 0 };
+            // late validations that failed and are not yet counted by the virtual user
+            std::atomic<std::uint64_t> failed{ 0 };
+            std::mutex mutex;
+            Metrics metrics;
+        };
+
+        struct Job
+        {
+            const Program* program = nullptr;
+            const Program::StepCode* step = nullptr;
+            const output::Formatter* formatter = nullptr;
+            // shared, as a worker still wakes the virtual user up after its last job finished
+            std::shared_ptr<Sink> sink;
+            // shared with the lane that received it, which keeps it for the conditions of the following steps
+            std::shared_ptr<const http::Response> response;
+            // the extractions nothing reads still run, for their debug log
+            bool extract = false;
+            bool validate = false;
+            std::chrono::steady_clock::time_point queued;
+            std::size_t depth = 0;
+        };
+
+        // capacity bounds the responses waiting for a worker
+        ResponsePipeline(std::size_t workers, std::size_t capacity);
+        // Finishes the queued jobs before returning
+        ~ResponsePipeline();
+
+        ResponsePipeline(const ResponsePipeline&) = delete;
+        ResponsePipeline& operator=(const ResponsePipeline&) = delete;
+
+        // Queues the job, or runs it on the calling thread when the queue is full, so a slow worker pool slows the
+        // virtual users down instead of growing without bound
+        void submit(Job& job);
+
+        // Blocks until every job of the sink has finished
+        static void await(Sink& sink);
+
+        [[nodiscard]] std::size_t getWorkers() const;
+
+    private:
+        BoundedQueue<Job> m_queue;
+        // bumped after every push and on shutdown; idle workers wait for it to change
+        std::atomic<std::uint32_t> m_signal{ 0 };
+        std::atomic<bool> m_stopping{ false };
+        std::vector<std::jthread> m_workers;
+
+        void work();
+        static void process(Job& job, bool inlined);
+    };
+} // namespace zaplet::scenario
+
+#endif // RESPONSE_PIPELINE_H
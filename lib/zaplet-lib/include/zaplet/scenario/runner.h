@@ -0,0 +1,78 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include "zaplet/http/client.h"
+#include "zaplet/output/formatter.h"
+#include "zaplet/scenario/metrics.h"
+#include "zaplet/scenario/program.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // Runs compiled programs with several virtual users, one player and one thread each. All players share
+    // the HTTP client; players of the same flow also share its program.
+    class Runner
+    {
+    public:
+        // One scenario of a run and the virtual users playing it
+        struct Flow
+        {
+            std::string name;
+            std::shared_ptr<const Program> program;
+            std::size_t virtualUsers = 1;
+            // filled by run() from the players of the flow
+            Metrics metrics;
+        };
+
+        Runner(std::shared_ptr<http::Client> client, std::shared_ptr<output::Formatter> formatter);
+        ~Runner() = default;
+
+        // Returns true when every virtual user completed without errors
+        bool run(std::shared_ptr<const Program> program, std::size_t virtualUsers);
+        // Plays all flows at the same time
+        bool run(std::vector<Flow>& flows);
+
+        [[nodiscard]] std::chrono::milliseconds getElapsed() const;
+
+        // Drains the run once it lasted this long; defaults to the longest duration of the flows
+        void setDuration(const std::optional<std::chrono::milliseconds>& duration);
+        // How long a draining run waits for running iterations before abandoning them
+        void setGracePeriod(std::chrono::milliseconds gracePeriod);
+        // Threads formatting, logging and late validating the responses of all virtual users; with none, the default,
+        // every virtual user does it itself before its next request and prints its responses in order
+        void setPipelineWorkers(std::size_t workers);
+
+        // The first call drains the run: no virtual user starts a new iteration. The second one abandons the running
+        // iterations at once. Only stores to a lock-free atomic, so it may be called from a signal handler.
+        void requestStop();
+
+    private:
+        std::shared_ptr<http::Client> m_client;
+        std::shared_ptr<output::Formatter> m_formatter;
+        std::chrono::milliseconds m_elapsed{ 0 };
+        std::optional<std::chrono::milliseconds> m_duration;
+        std::chrono::milliseconds m_gracePeriod{ 30000 };
+        std::size_t m_pipelineWorkers = 0;
+        std::atomic<int> m_stopRequests{ 0 };
+
+        // Plays a run-scope phase on a thread of its own and aborts it on the next stop request, as setup and
+        // teardown run outside the supervision of the virtual users
+        bool supervise(std::string_view phase, const std::function<bool()>& play, std::stop_source& abort);
+    };
+} // namespace zaplet::scenario
+
+#endif // RUNNER_H
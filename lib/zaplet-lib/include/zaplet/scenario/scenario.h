@@ -7,8 +7,11 @@
 
 #include "zaplet/http/request.h"
 #include "zaplet/http/response.h"
+#include "zaplet/scenario/think_time.h"
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <string>
@@ -16,15 +19,185 @@
 
 namespace zaplet::scenario
 {
+    // Checks applied to a header value or to a value selected by a JSON path; JSON literals are kept as JSON text
+    struct ValueMatcher
+    {
+        bool exists = true;
+        std::optional<std::string> type;
+        std::optional<std::string> equals;
+        std::optional<std::string> pattern;
+        std::optional<double> min;
+        std::optional<double> max;
+        std::optional<std::size_t> length;
+        std::optional<std::size_t> minLength;
+        std::optional<std::size_t> maxLength;
+    };
+
+    struct ResponseExpectation
+    {
+        int statusCode = 0;
+        std::map<std::string, ValueMatcher> headers;
+        // the whole body, compared structurally when both sides are JSON
+        std::optional<std::string> body;
+        // a JSON document the response body must contain
+        std::optional<std::string> json;
+        std::map<std::string, ValueMatcher> fields;
+        std::optional<std::chrono::milliseconds> maxLatency;
+        std::optional<std::size_t> minSize;
+        std::optional<std::size_t> maxSize;
+    };
+
+    enum class DataMode
+    {
+        // every record is used once, shared by all virtual users in file order
+        Sequential,
+        // each iteration picks a record at random
+        Random,
+        // virtual users take disjoint records, each record is used once
+        Unique,
+        // like sequential, starting over at the end of the file
+        Circular
+    };
+
+    // A CSV or NDJSON file whose records are bound to variables, one record per iteration
+    struct DataSource
+    {
+        std::string file;
+        // "csv" or "ndjson"; every record is one line, so quoted CSV fields cannot contain line breaks
+        std::string format = "csv";
+        DataMode mode = DataMode::Sequential;
+        char delimiter = ',';
+        bool header = true;
+        // column names when the file has no header line
+        std::vector<std::string> columns;
+        // variable name to column name; every column binds a variable of the same name when empty
+        std::map<std::string, std::string> variables;
+    };
+
+    // How often setup and teardown steps run: once for the whole run, or once by every virtual user
+    enum class PhaseScope
+    {
+        Run,
+        VirtualUser
+    };
+
+    // Turns a login step into a pool of credentials: the variables it extracts are published with an expiry
+    // and leased by every virtual user instead of logging in again
+    struct CredentialPolicy
+    {
+        // number of distinct credentials; virtual users share them round robin
+        std::size_t pool = 1;
+        // lifetime of a credential; it never expires when neither ttl nor expiresIn is set
+        std::optional<std::chrono::milliseconds> ttl;
+        // variable holding the lifetime in seconds, as returned by the login
+        std::optional<std::string> expiresIn;
+        // a credential this close to its expiry is renewed by the next virtual user leasing it
+        std::chrono::milliseconds refreshBefore{ 60000 };
+        // step sent instead of the login to renew a credential that has not expired yet
+        std::optional<std::string> refresh;
+    };
+
+    // Who shares the variables a cached step extracted
+    enum class CacheScope
+    {
+        // every virtual user sends the step once and replays its own variables
+        VirtualUser,
+        // the variables one virtual user extracted are replayed by all of them
+        Global
+    };
+
+    // Replays the variables a step extracted instead of sending it again, until they expire
+    struct CachePolicy
+    {
+        CacheScope scope = CacheScope::VirtualUser;
+        // the variables never expire when not set
+        std::optional<std::chrono::milliseconds> ttl;
+    };
+
+    // What a request does when its rate limit has no token left
+    enum class RateLimitAction
+    {
+        // waits for the next token, in the order the requests arrived
+        Wait,
+        // is not sent; the step counts as skipped
+        Skip
+    };
+
+    // A cap on the requests of a step, or of every request whose URL matches, shared by all virtual users
+    struct RateLimit
+    {
+        // requests per second
+        double rate = 0.0;
+        // requests allowed at once after a quiet period
+        std::size_t burst = 1;
+        RateLimitAction action = RateLimitAction::Wait;
+        // regular expression searched in the URL with its query parameters; only for the rate limits of a scenario
+        std::optional<std::string> match;
+    };
+
+    // How a step picks the node of a target group for each request
+    enum class BalanceMode
+    {
+        RoundRobin,
+        // the node with the fewest requests in flight from all virtual users
+        LeastOutstanding,
+        // the node a key maps to, so that requests with the same key stay on one node
+        ConsistentHash
+    };
+
+    // The nodes of a cluster, hit directly instead of through one address
+    struct TargetDefinition
+    {
+        // base URLs of the nodes, without a query string
+        std::vector<std::string> urls;
+        // expand the host name of each URL to a node per address
+        bool resolve = false;
+        BalanceMode balance = BalanceMode::RoundRobin;
+        // template of the consistent hashing key, such as ${user_id}
+        std::optional<std::string> key;
+    };
+
+    // Plays the scenario as synchronised bursts: every virtual user prepares the request of the first step and
+    // all of them send it at the same moment, once per round
+    struct BurstPolicy
+    {
+        int rounds = 1;
+        // shortest time from one release to the next
+        std::chrono::milliseconds interval{ 0 };
+    };
+
+    // Bounds of the private HTTP cache every virtual user keeps, as browsers and mobile clients do
+    struct HttpCachePolicy
+    {
+        std::size_t maxEntries = 1024;
+        std::size_t maxBytes = std::size_t{ 16 } << 20;
+    };
+
     struct Step
     {
         std::string name;
         std::string description;
         http::Request request;
-        std::optional<http::Response> expectedResponse;
+        // the request body came from body_json and holds a JSON document with typed placeholders
+        bool bodyJson = false;
+        std::optional<ResponseExpectation> expectedResponse;
         std::map<std::string, std::string> variables;
         std::optional<std::string> condition;
-        std::optional<std::chrono::milliseconds> delay;
+        std::optional<ThinkTime> delay;
+        // run the step this many times, binding ${index}
+        std::optional<int> loop;
+        // run the step once per element of a JSON array, binding ${index} and the item variable
+        std::optional<std::string> foreach;
+        std::string itemVariable = "item";
+        // sub-steps sent concurrently; a step with parallel sub-steps has no request of its own
+        std::vector<Step> parallel;
+        // names of earlier steps that must finish first when steps are parallelised automatically
+        std::vector<std::string> dependsOn;
+        std::optional<CredentialPolicy> credentials;
+        std::optional<CachePolicy> cache;
+        std::optional<RateLimit> rateLimit;
+        // target group the request goes to; its url is then a path on the picked node
+        std::optional<std::string> target;
     };
 
     class Scenario
@@ -53,6 +226,54 @@ namespace zaplet::scenario
         [[nodiscard]] bool getContinueOnError() const;
         void setContinueOnError(bool continue_);
 
+        [[nodiscard]] bool getJsonStreaming() const;
+        void setJsonStreaming(bool streaming);
+
+        [[nodiscard]] bool getAutoParallel() const;
+        void setAutoParallel(bool autoParallel);
+
+        [[nodiscard]] const std::vector<DataSource>& getData() const;
+        void setData(const std::vector<DataSource>& data);
+
+        [[nodiscard]] std::size_t getVirtualUsers() const;
+        void setVirtualUsers(std::size_t virtualUsers);
+
+        [[nodiscard]] std::optional<std::uint64_t> getSeed() const;
+        void setSeed(const std::optional<std::uint64_t>& seed);
+
+        // pause between the iterations of a virtual user
+        [[nodiscard]] const ThinkTime& getThinkTime() const;
+        void setThinkTime(const ThinkTime& thinkTime);
+
+        // a fixed interval from the start of one iteration to the start of the next; replaces the think time
+        [[nodiscard]] std::optional<std::chrono::milliseconds> getPacing() const;
+        void setPacing(const std::optional<std::chrono::milliseconds>& pacing);
+
+        // virtual users start no new iteration once the scenario has run this long
+        [[nodiscard]] std::optional<std::chrono::milliseconds> getDuration() const;
+        void setDuration(const std::optional<std::chrono::milliseconds>& duration);
+
+        [[nodiscard]] const std::map<std::string, TargetDefinition>& getTargets() const;
+        void setTargets(const std::map<std::string, TargetDefinition>& targets);
+
+        // limits applied to every request whose URL matches them
+        [[nodiscard]] const std::vector<RateLimit>& getRateLimits() const;
+        void setRateLimits(const std::vector<RateLimit>& rateLimits);
+
+        [[nodiscard]] const std::optional<BurstPolicy>& getBurst() const;
+        void setBurst(const std::optional<BurstPolicy>& burst);
+
+        [[nodiscard]] const std::optional<HttpCachePolicy>& getHttpCache() const;
+        void setHttpCache(const std::optional<HttpCachePolicy>& httpCache);
+
+        [[nodiscard]] const std::vector<Step>& getSetup() const;
+        void setSetup(const std::vector<Step>& steps, PhaseScope scope);
+        [[nodiscard]] PhaseScope getSetupScope() const;
+
+        [[nodiscard]] const std::vector<Step>& getTeardown() const;
+        void setTeardown(const std::vector<Step>& steps, PhaseScope scope);
+        [[nodiscard]] PhaseScope getTeardownScope() const;
+
     private:
         std::string m_name;
         std::string m_description;
@@ -60,6 +281,22 @@ namespace zaplet::scenario
         std::map<std::string, std::string> m_env;
         std::optional<int> m_repeatCount;
         bool m_continueOnError{ false };
+        bool m_jsonStreaming{ true };
+        bool m_autoParallel{ false };
+        std::vector<DataSource> m_data;
+        std::size_t m_virtualUsers{ 1 };
+        std::optional<std::uint64_t> m_seed;
+        std::optional<std::chrono::milliseconds> m_duration;
+        ThinkTime m_thinkTime{ ThinkTime::constant(std::chrono::milliseconds(100)) };
+        std::optional<std::chrono::milliseconds> m_pacing;
+        std::map<std::string, TargetDefinition> m_targets;
+        std::vector<RateLimit> m_rateLimits;
+        std::optional<BurstPolicy> m_burst;
+        std::optional<HttpCachePolicy> m_httpCache;
+        std::vector<Step> m_setup;
+        PhaseScope m_setupScope{ PhaseScope::Run };
+        std::vector<Step> m_teardown;
+        PhaseScope m_teardownScope{ PhaseScope::Run };
     };
 } // namespace zaplet::scenario
 
@@ -0,0 +1,68 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef TARGET_GROUP_H
+#define TARGET_GROUP_H
+
+#include "zaplet/http/url.h"
+#include "zaplet/scenario/scenario.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // The nodes of a cluster that steps send to directly, shared by all virtual users. Picking a node touches only
+    // atomics: a counter for round robin, and one cache line of outstanding requests per node for least outstanding.
+    class TargetGroup
+    {
+    public:
+        struct Node
+        {
+            http::Url origin;
+            // Host header for a node resolved from a name, which keeps the name the server expects
+            std::string host;
+            // how the node is reported in metrics
+            std::string label;
+        };
+
+        TargetGroup(std::string name, std::vector<Node> nodes, BalanceMode balance);
+        ~TargetGroup() = default;
+
+        TargetGroup(const TargetGroup&) = delete;
+        TargetGroup& operator=(const TargetGroup&) = delete;
+
+        // The node of a URL, or one node per address of its host name when resolve is set, which connect to their
+        // address but keep the name for TLS
+        static std::vector<Node> expand(const std::string& url, bool resolve);
+
+        // Picks the node of the next request; the key is only used by consistent hashing. Every acquire is
+        // followed by a release once the response arrived.
+        [[nodiscard]] std::size_t acquire(std::string_view key);
+        void release(std::size_t node);
+
+        [[nodiscard]] const std::string& getName() const;
+        [[nodiscard]] const std::vector<Node>& getNodes() const;
+        [[nodiscard]] BalanceMode getBalance() const;
+
+    private:
+        struct alignas(64) Counter
+        {
+            std::atomic<std::int64_t> value{ 0 };
+        };
+
+        std::string m_name;
+        std::vector<Node> m_nodes;
+        BalanceMode m_balance;
+        std::unique_ptr<Counter[]> m_outstanding;
+        alignas(64) std::atomic<std::uint64_t> m_next{ 0 };
+    };
+} // namespace zaplet::scenario
+
+#endif // TARGET_GROUP_H
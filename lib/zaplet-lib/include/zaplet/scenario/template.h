@@ -0,0 +1,119 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include "zaplet/scenario/variables.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // A string with ${name} placeholders and ${function(...)} calls, split once into literal, slot and call segments
+    class Template
+    {
+    public:
+        enum class SegmentKind
+        {
+            Literal,
+            Variable,
+            Function
+        };
+
+        enum class Function
+        {
+            Uuid,
+            RandInt,
+            RandStr,
+            NowMs,
+            Seq,
+            FakerEmail,
+            Base64,
+            HmacSha256
+        };
+
+        // How a variable or call value is written into the output
+        enum class Encoding
+        {
+            Text,
+            // escaped as the contents of a JSON string
+            JsonString,
+            // checked and written as a bare JSON value, or null when the value does not fit the type
+            JsonInteger,
+            JsonNumber,
+            JsonBoolean,
+            // written as is, the value must already be JSON
+            JsonRaw
+        };
+
+        struct Segment
+        {
+            SegmentKind kind = SegmentKind::Literal;
+            std::size_t offset = 0;
+            std::size_t length = 0;
+            VariableSlot slot = 0;
+            // index into getCalls() for function segments
+            std::size_t call = 0;
+            Encoding encoding = Encoding::Text;
+        };
+
+        struct Argument
+        {
+            bool variable = false;
+            VariableSlot slot = 0;
+            std::string value;
+        };
+
+        struct Call
+        {
+            Function function = Function::Uuid;
+            std::vector<Argument> arguments;
+            // bounds of rand_int, or the length of rand_str in high
+            std::int64_t low = 0;
+            std::int64_t high = 0;
+        };
+
+        Template() = default;
+        ~Template() = default;
+
+        using Constants = std::map<std::string, std::string, std::less<>>;
+
+        static Template compile(std::string_view source, VariableTable& table);
+        // Placeholders naming a constant are replaced by its value at compile time, and so are base64() and
+        // hmac_sha256() calls whose arguments are all constant
+        static Template compile(std::string_view source, VariableTable& table, const Constants& constants);
+
+        // Compiles a JSON document whose strings may hold placeholders. A string that is exactly ${name:int}, ${name:number},
+        // ${name:bool} or ${name:json} is replaced by the bare value; placeholders anywhere else are JSON-escaped.
+        static Template compileJson(std::string_view json, VariableTable& table, const Constants& constants);
+
+        void render(const VariableFrame& frame, std::string& out) const;
+        [[nodiscard]] std::string render(const VariableFrame& frame) const;
+
+        [[nodiscard]] const std::string& getSource() const;
+        [[nodiscard]] const std::vector<Segment>& getSegments() const;
+        [[nodiscard]] const std::vector<Call>& getCalls() const;
+        [[nodiscard]] bool isLiteral() const;
+
+    private:
+        std::string m_source;
+        std::vector<Segment> m_segments;
+        std::vector<Call> m_calls;
+        std::size_t m_literalLength = 0;
+
+        // Offsets refer to m_source, which holds the source with constants already substituted
+        void appendLiteral(std::string_view text);
+        void appendJsonString(const Template& part);
+        // The name of the variable of a segment, without its type
+        [[nodiscard]] std::string_view variableName(const Segment& segment) const;
+    };
+} // namespace zaplet::scenario
+
+#endif // TEMPLATE_H
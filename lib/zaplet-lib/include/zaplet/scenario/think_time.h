@@ -0,0 +1,46 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef THINK_TIME_H
+#define THINK_TIME_H
+
+#include "zaplet/scenario/random.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace zaplet::scenario
+{
+    enum class Distribution
+    {
+        Constant,
+        Uniform,
+        Exponential,
+        Normal,
+        Pareto
+    };
+
+    // A pause drawn from a distribution, so virtual users do not fire in lockstep. All values are milliseconds.
+    struct ThinkTime
+    {
+        Distribution distribution = Distribution::Constant;
+        // the constant pause, or the mean of the exponential and normal distributions
+        double mean = 0.0;
+        // the lower bound of the uniform distribution and the scale of the Pareto one; no sample is shorter
+        double min = 0.0;
+        // the upper bound of the uniform distribution; caps the other distributions when set
+        std::optional<double> max;
+        double stddev = 0.0;
+        // tail index of the Pareto distribution
+        double shape = 1.0;
+
+        static ThinkTime constant(std::chrono::milliseconds value);
+
+        [[nodiscard]] std::chrono::milliseconds sample(Random& random) const;
+        [[nodiscard]] std::string describe() const;
+    };
+} // namespace zaplet::scenario
+
+#endif // THINK_TIME_H
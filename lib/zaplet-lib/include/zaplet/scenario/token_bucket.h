@@ -0,0 +1,51 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace zaplet::scenario
+{
+    // A token bucket shared by all virtual users. It is kept as the time the bucket is next empty rather than as a
+    // token count (the generic cell rate algorithm), so taking a token is a compare-and-swap on a single atomic,
+    // without a lock or a refill thread.
+    class TokenBucket
+    {
+    public:
+        // rate in tokens per second; burst tokens can be taken at once from a full bucket
+        TokenBucket(double rate, std::size_t burst);
+        ~TokenBucket() = default;
+
+        TokenBucket(const TokenBucket&) = delete;
+        TokenBucket& operator=(const TokenBucket&) = delete;
+
+        // Reserves the next token, returning how long the caller has to wait before using it. Waiting callers are
+        // served in the order they reserved.
+        [[nodiscard]] std::chrono::nanoseconds reserve();
+        // Takes a token only when one is available right away
+        [[nodiscard]] bool tryTake();
+
+        [[nodiscard]] double getRate() const;
+        [[nodiscard]] std::size_t getBurst() const;
+
+    private:
+        double m_rate;
+        std::size_t m_burst;
+        // time between two tokens, and how far ahead of now the bucket may be drawn, in nanoseconds
+        std::int64_t m_interval;
+        std::int64_t m_tolerance;
+
+        // the time at which the bucket is drawn down to empty, in nanoseconds of the steady clock
+        alignas(64) std::atomic<std::int64_t> m_empty{ 0 };
+
+        [[nodiscard]] static std::int64_t now();
+    };
+} // namespace zaplet::scenario
+
+#endif // TOKEN_BUCKET_H
@@ -0,0 +1,43 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+#include "zaplet/scenario/response_document.h"
+#include "zaplet/scenario/scenario.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    // An expected_response compiled once into a flat list of checks run against the shared parse of each response
+    class ResponseValidator
+    {
+    public:
+        ResponseValidator();
+        ~ResponseValidator();
+
+        ResponseValidator(ResponseValidator&& other) noexcept;
+        ResponseValidator& operator=(ResponseValidator&& other) noexcept;
+
+        static ResponseValidator compile(const ResponseExpectation& expectation);
+
+        // Runs every check and logs each failure
+        bool validate(ResponseDocument& document) const;
+
+        // Whether any check reads the parsed body
+        [[nodiscard]] bool needsDocument() const;
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        struct Check;
+
+        std::vector<Check> m_checks;
+        bool m_needsDocument = false;
+    };
+} // namespace zaplet::scenario
+
+#endif // VALIDATOR_H
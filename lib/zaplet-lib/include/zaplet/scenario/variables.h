@@ -0,0 +1,57 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#ifndef VARIABLES_H
+#define VARIABLES_H
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    using VariableSlot = std::size_t;
+
+    // Maps variable names to dense slot indices, filled while a scenario is compiled
+    class VariableTable
+    {
+    public:
+        VariableTable() = default;
+        ~VariableTable() = default;
+
+        VariableSlot intern(std::string_view name);
+        [[nodiscard]] std::optional<VariableSlot> find(std::string_view name) const;
+
+        [[nodiscard]] const std::string& getName(VariableSlot slot) const;
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        std::vector<std::string> m_names;
+        std::map<std::string, VariableSlot, std::less<>> m_slots;
+    };
+
+    // Per virtual user variable values; re-assigning a slot reuses its string capacity
+    class VariableFrame
+    {
+    public:
+        VariableFrame() = default;
+        explicit VariableFrame(std::size_t size);
+        ~VariableFrame() = default;
+
+        [[nodiscard]] bool has(VariableSlot slot) const;
+        [[nodiscard]] const std::string& get(VariableSlot slot) const;
+        void set(VariableSlot slot, std::string_view value);
+        void unset(VariableSlot slot);
+
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        std::vector<std::optional<std::string>> m_values;
+    };
+} // namespace zaplet::scenario
+
+#endif // VARIABLES_H
@@ -6,10 +6,12 @@
 #define YAML_PARSER_H
 
 #include "zaplet/logging/logger.h"
+#include "zaplet/scenario/mix.h"
 #include "zaplet/scenario/scenario.h"
 
 #include <yaml-cpp/yaml.h>
 
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <string>
@@ -25,11 +27,29 @@ namespace zaplet::scenario
         Scenario parseFile(const std::string& filePath) const;
         Scenario parseString(const std::string& yamlContent) const;
 
+        // A mix file lists scenario files under 'scenarios' instead of having steps
+        static bool isMixFile(const std::string& filePath);
+        Mix parseMixFile(const std::string& filePath) const;
+
+        // A duration such as "90s", "10m", "1h30m" or "500ms"; a plain number counts seconds
+        static std::chrono::milliseconds parseDuration(const std::string& value);
+
     private:
         Scenario parseScenario(const YAML::Node& node) const;
         Step parseStep(const YAML::Node& node) const;
+        std::vector<Step> parsePhase(const YAML::Node& node, const std::string& phase, PhaseScope& scope) const;
         http::Request parseRequest(const YAML::Node& node) const;
-        http::Response parseResponse(const YAML::Node& node) const;
+        ResponseExpectation parseExpectation(const YAML::Node& node) const;
+        ValueMatcher parseMatcher(const YAML::Node& node, const std::string& context) const;
+        DataSource parseDataSource(const YAML::Node& node) const;
+        ThinkTime parseThinkTime(const YAML::Node& node, const std::string& context) const;
+        BurstPolicy parseBurst(const YAML::Node& node) const;
+        std::optional<HttpCachePolicy> parseHttpCache(const YAML::Node& node) const;
+        TargetDefinition parseTargets(const YAML::Node& node, const std::string& name) const;
+        RateLimit parseRateLimit(const YAML::Node& node, const std::string& context) const;
+        static double parseRate(const std::string& value, const std::string& context);
+        CachePolicy parseCache(const YAML::Node& node, const std::string& stepName) const;
+        CredentialPolicy parseCredentials(const YAML::Node& node, const std::string& stepName) const;
     };
 } // namespace zaplet::scenario
 
@@ -17,8 +17,10 @@
 
 // http
 #include "zaplet/http/client.h"
+#include "zaplet/http/headers.h"
 #include "zaplet/http/request.h"
 #include "zaplet/http/response.h"
+#include "zaplet/http/url.h"
 #include "zaplet/http/utils.h"
 
 // output
@@ -27,7 +29,23 @@
 
 // scenario
 #include "zaplet/scenario/scenario.h"
+#include "zaplet/scenario/variables.h"
+#include "zaplet/scenario/random.h"
+#include "zaplet/scenario/template.h"
+#include "zaplet/scenario/json_path.h"
+#include "zaplet/scenario/json_stream.h"
+#include "zaplet/scenario/pattern.h"
+#include "zaplet/scenario/response_document.h"
+#include "zaplet/scenario/extractor.h"
+#include "zaplet/scenario/condition.h"
+#include "zaplet/scenario/validator.h"
+#include "zaplet/scenario/data_feed.h"
+#include "zaplet/scenario/mix.h"
 #include "zaplet/scenario/yaml_parser.h"
+#include "zaplet/scenario/dependency_graph.h"
+#include "zaplet/scenario/program.h"
+#include "zaplet/scenario/metrics.h"
 #include "zaplet/scenario/player.h"
+#include "zaplet/scenario/runner.h"
 
 #endif // ZAPLET_H
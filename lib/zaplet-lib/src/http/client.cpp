@@ -10,41 +10,107 @@
 
 #include <chrono>
 #include <format>
-#include <regex>
+#include <optional>
+#include <utility>
 
 namespace zaplet::http
 {
-    Response Client::execute(const Request& request)
+    Response Client::execute(const Request& request, ResponseCache* cache)
     {
-        Response response;
+        PreparedRequest prepared = prepare(request, cache);
+        return send(prepared);
+    }
+
+    PreparedRequest Client::prepare(const Request& request, ResponseCache* cache)
+    {
+        PreparedRequest prepared;
+        prepared.request = &request;
 
         try
         {
-            std::string scheme;
-            std::string host;
-            std::string path;
-            int port;
-
-            if (!parseUrl(request.getUrl(), scheme, host, port, path))
+            // Scenario steps pass the URL already split; anything else is parsed here
+            std::optional<Url> parsed;
+            if (!request.getTarget().has_value())
             {
-                response.setError("Invalid URL: " + request.getUrl());
-                return response;
+                parsed = Url::parse(request.getUrl());
+                if (!parsed.has_value())
+                {
+                    prepared.error = "Invalid URL: " + request.getUrl();
+                    return prepared;
+                }
             }
 
-            auto client = createClient(request.getUrl());
-            if (!client)
+            const Url* url = request.getTarget().has_value() ? &request.getTarget().value() : &parsed.value();
+
+            prepared.path = url->path;
+            appendQuery(prepared.path, request.getQueryParams());
+            url->appendOrigin(prepared.origin);
+
+            for (const auto& [name, value] : request.getHeaders())
             {
-                response.setError("Failed to create HTTP client");
-                return response;
+                prepared.headers.emplace(name, value);
             }
 
-            client->setConnectionTimeout(std::chrono::seconds(request.getTimeout()));
+            if (cache != nullptr)
+            {
+                prepared.cache = cache;
+                prepared.cacheKey = prepared.origin;
+                prepared.cacheKey += prepared.path;
 
-            httplib::Headers headers;
-            for (const auto& [name, value] : request.getHeaders())
+                Response cached;
+                Headers validators;
+                if (request.getMethod() == "GET" && cache->lookup(prepared.cacheKey, request.getHeaders(), validators, cached))
+                {
+                    cached.setCacheStatus(CacheStatus::Hit);
+                    prepared.cached = std::move(cached);
+                    return prepared;
+                }
+                for (const auto& [name, value] : validators)
+                {
+                    prepared.headers.emplace(name, value);
+                }
+            }
+
+            if (!url->address.empty())
+            {
+                prepared.origin.push_back('@');
+                prepared.origin.append(url->address);
+            }
+            prepared.client = acquireClient(*url, prepared.origin);
+            if (!prepared.client)
             {
-                headers.emplace(name, value);
+                prepared.error = "Failed to create HTTP client";
+                return prepared;
             }
+            prepared.client->setConnectionTimeout(std::chrono::seconds(request.getTimeout()));
+        } catch (const std::exception& e)
+        {
+            prepared.error = std::format("Exception during HTTP request: {}", e.what());
+            LOG_ERROR_FMT("Exception during HTTP request: {}", e.what());
+        }
+
+        return prepared;
+    }
+
+    Response Client::send(PreparedRequest& prepared)
+    {
+        Response response;
+        if (!prepared.error.empty())
+        {
+            response.setError(prepared.error);
+            return response;
+        }
+        if (prepared.cached.has_value())
+        {
+            return prepared.cached.value();
+        }
+
+        try
+        {
+            const Request& request = *prepared.request;
+            IClientWrapper* client = prepared.client.get();
+            const std::string& path = prepared.path;
+            const httplib::Headers& headers = prepared.headers;
 
             auto startTime = std::chrono::steady_clock::now();
 
@@ -114,14 +180,19 @@ namespace zaplet::http
             {
                 response.setStatusCode(result->status);
 
-                std::map<std::string, std::string> responseHeaders;
                 for (const auto& [name, value] : result->headers)
                 {
-                    responseHeaders[name] = value;
+                    response.addHeader(name, value);
                 }
-                response.setHeaders(responseHeaders);
 
-                response.setBody(result->body);
+                response.setBody(std::move(result->body));
+                // only after a response, as the connection of a failed request may be broken
+                releaseClient(prepared);
+
+                if (prepared.cache != nullptr)
+                {
+                    response.setCacheStatus(prepared.cache->update(prepared.cacheKey, request.getMethod(), request.getHeaders(), response));
+                }
             }
             else
             {
@@ -138,58 +209,74 @@ namespace zaplet::http
         return response;
     }
 
-    std::unique_ptr<IClientWrapper> Client::createClient(const std::string& url)
+    std::unique_ptr<IClientWrapper> Client::acquireClient(const Url& url, const std::string& origin)
     {
-        std::string scheme;
-        std::string host;
-        std::string path;
-        int port;
+        {
+            std::lock_guard lock(m_poolMutex);
+            auto idle = m_idle.find(origin);
+            if (idle != m_idle.end() && !idle->second.empty())
+            {
+                auto client = std::move(idle->second.back());
+                idle->second.pop_back();
+                return client;
+            }
+        }
 
-        if (!parseUrl(url, scheme, host, port, path))
+        auto client = createClient(url);
+        if (client)
         {
-            LOG_ERROR_FMT("Failed to parse URL: {}", url);
-            return nullptr;
+            client->setKeepAlive(true);
+            if (!url.address.empty())
+            {
+                client->setAddress(url.host, url.address);
+            }
         }
+        return client;
+    }
 
-        if (scheme == "http")
+    void Client::releaseClient(PreparedRequest& prepared)
+    {
+        std::lock_guard lock(m_poolMutex);
+        auto idle = m_idle.find(prepared.origin);
+        if (idle == m_idle.end())
         {
-            return std::make_unique<ClientWrapper>(host, port);
+            idle = m_idle.emplace(prepared.origin, std::vector<std::unique_ptr<IClientWrapper>>()).first;
         }
-        else if (scheme == "https")
+        idle->second.push_back(std::move(prepared.client));
+    }
+
+    std::unique_ptr<IClientWrapper> Client::createClient(const Url& url)
+    {
+        if (url.scheme == "http")
+        {
+            return std::make_unique<ClientWrapper>(url.host, url.port);
+        }
+        else if (url.scheme == "https")
         {
-            return std::make_unique<SSLClientWrapper>(host, port);
+            return std::make_unique<SSLClientWrapper>(url.host, url.port);
         }
         else
         {
-            LOG_ERROR_FMT("Unsupported scheme: {}", scheme);
+            LOG_ERROR_FMT("Unsupported scheme: {}", url.scheme);
             return nullptr;
         }
     }
 
-    bool Client::parseUrl(const std::string& url, std::string& scheme, std::string& host, int& port, std::string& path)
+    void Client::appendQuery(std::string& path, const std::map<std::string, std::string>& params)
     {
-        std::regex urlRegex(R"(^(http|https)://([^/:]+)(?::(\d+))?(/.*)?$)");
-        std::smatch matches;
-
-        if (std::regex_match(url, matches, urlRegex))
+        if (params.empty())
         {
-            scheme = matches[1].str();
-            host = matches[2].str();
-
-            if (matches[3].length() > 0)
-            {
-                port = std::stoi(matches[3].str());
-            }
-            else
-            {
-                port = (scheme == "https") ? 443 : 80;
-            }
-
-            path = matches[4].matched ? matches[4].str() : "/";
-
-            return true;
+            return;
         }
 
-        return false;
+        char separator = path.find('?') == std::string::npos ? '?' : '&';
+        for (const auto& [name, value] : params)
+        {
+            path.push_back(separator);
+            path.append(httplib::detail::encode_query_param(name));
+            path.push_back('=');
+            path.append(httplib::detail::encode_query_param(value));
+            separator = '&';
+        }
     }
 } // namespace zaplet::http
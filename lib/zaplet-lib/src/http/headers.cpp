@@ -0,0 +1,204 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/http/headers.h"
+
+#include <algorithm>
+
+namespace zaplet::http
+{
+    namespace
+    {
+        char toLower(char c)
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+    } // namespace
+
+    bool equalsIgnoreCase(std::string_view left, std::string_view right)
+    {
+        return std::ranges::equal(left, right, [](char a, char b) { return toLower(a) == toLower(b); });
+    }
+
+    Headers::Headers(std::initializer_list<std::pair<std::string_view, std::string_view>> fields)
+    {
+        for (const auto& [name, value] : fields)
+        {
+            add(name, value);
+        }
+    }
+
+    Headers::Headers(const Headers& other)
+    {
+        for (std::size_t i = 0; i < other.m_size; ++i)
+        {
+            const Entry& source = other.entry(i);
+            append(source.hash, source.field.name, source.field.value);
+        }
+    }
+
+    Headers& Headers::operator=(const Headers& other)
+    {
+        if (this != &other)
+        {
+            m_size = 0;
+            for (std::size_t i = 0; i < other.m_size; ++i)
+            {
+                const Entry& source = other.entry(i);
+                append(source.hash, source.field.name, source.field.value);
+            }
+        }
+        return *this;
+    }
+
+    Headers::Headers(Headers&& other) noexcept
+        : m_inline(std::move(other.m_inline))
+        , m_overflow(std::move(other.m_overflow))
+        , m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    Headers& Headers::operator=(Headers&& other) noexcept
+    {
+        if (this != &other)
+        {
+            m_inline = std::move(other.m_inline);
+            m_overflow = std::move(other.m_overflow);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    void Headers::add(std::string_view name, std::string_view value)
+    {
+        append(hash(name), name, value);
+    }
+
+    void Headers::set(std::string_view name, std::string_view value)
+    {
+        std::uint32_t nameHash = hash(name);
+        std::size_t index = indexOf(nameHash, name, 0);
+        if (index == m_size)
+        {
+            append(nameHash, name, value);
+            return;
+        }
+
+        entry(index).field.value.assign(value);
+        removeFrom(nameHash, name, index + 1);
+    }
+
+    std::size_t Headers::erase(std::string_view name)
+    {
+        return removeFrom(hash(name), name, 0);
+    }
+
+    void Headers::clear()
+    {
+        m_size = 0;
+    }
+
+    const std::string* Headers::find(std::string_view name) const
+    {
+        std::size_t index = indexOf(hash(name), name, 0);
+        return index < m_size ? &entry(index).field.value : nullptr;
+    }
+
+    bool Headers::contains(std::string_view name) const
+    {
+        return find(name) != nullptr;
+    }
+
+    std::size_t Headers::count(std::string_view name) const
+    {
+        std::uint32_t nameHash = hash(name);
+        std::size_t count = 0;
+        for (std::size_t index = indexOf(nameHash, name, 0); index < m_size; index = indexOf(nameHash, name, index + 1))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    std::size_t Headers::size() const
+    {
+        return m_size;
+    }
+
+    bool Headers::empty() const
+    {
+        return m_size == 0;
+    }
+
+    Headers::const_iterator Headers::begin() const
+    {
+        return { this, 0 };
+    }
+
+    Headers::const_iterator Headers::end() const
+    {
+        return { this, m_size };
+    }
+
+    std::uint32_t Headers::hash(std::string_view name)
+    {
+        // FNV-1a
+        std::uint32_t result = 2166136261u;
+        for (char c : name)
+        {
+            result ^= static_cast<unsigned char>(toLower(c));
+            result *= 16777619u;
+        }
+        return result;
+    }
+
+    std::size_t Headers::indexOf(std::uint32_t hash, std::string_view name, std::size_t from) const
+    {
+        for (std::size_t index = from; index < m_size; ++index)
+        {
+            const Entry& candidate = entry(index);
+            if (candidate.hash == hash && equalsIgnoreCase(candidate.field.name, name))
+            {
+                return index;
+            }
+        }
+        return m_size;
+    }
+
+    void Headers::append(std::uint32_t hash, std::string_view name, std::string_view value)
+    {
+        if (m_size >= INLINE_FIELDS && m_size - INLINE_FIELDS == m_overflow.size())
+        {
+            m_overflow.emplace_back();
+        }
+
+        Entry& target = entry(m_size);
+        target.hash = hash;
+        target.field.name.assign(name);
+        target.field.value.assign(value);
+        ++m_size;
+    }
+
+    std::size_t Headers::removeFrom(std::uint32_t hash, std::string_view name, std::size_t from)
+    {
+        std::size_t kept = from;
+        for (std::size_t index = from; index < m_size; ++index)
+        {
+            Entry& candidate = entry(index);
+            if (candidate.hash == hash && equalsIgnoreCase(candidate.field.name, name))
+            {
+                continue;
+            }
+            if (kept != index)
+            {
+                std::swap(entry(kept), candidate);
+            }
+            ++kept;
+        }
+
+        std::size_t removed = m_size - kept;
+        m_size = kept;
+        return removed;
+    }
+} // namespace zaplet::http
@@ -4,6 +4,8 @@
 
 #include "zaplet/http/request.h"
 
+#include <utility>
+
 namespace zaplet::http
 {
 
@@ -15,6 +17,30 @@ namespace zaplet::http
     void Request::setUrl(const std::string& url)
     {
         m_url = url;
+        m_target.reset();
+    }
+
+    void Request::setUrl(const Url& origin, std::string_view path)
+    {
+        if (!m_target.has_value())
+        {
+            m_target.emplace();
+        }
+
+        m_target->scheme.assign(origin.scheme);
+        m_target->host.assign(origin.host);
+        m_target->port = origin.port;
+        m_target->address.assign(origin.address);
+        m_target->path.assign(path);
+
+        m_url.clear();
+        origin.appendOrigin(m_url);
+        m_url.append(path);
+    }
+
+    const std::optional<Url>& Request::getTarget() const
+    {
+        return m_target;
     }
 
     const std::string& Request::getMethod() const
@@ -27,19 +53,24 @@ namespace zaplet::http
         m_method = method;
     }
 
-    const std::map<std::string, std::string>& Request::getHeaders() const
+    const Headers& Request::getHeaders() const
     {
         return m_headers;
     }
 
-    void Request::setHeaders(const std::map<std::string, std::string>& headers)
+    void Request::setHeaders(Headers headers)
+    {
+        m_headers = std::move(headers);
+    }
+
+    void Request::setHeader(std::string_view name, std::string_view value)
     {
-        m_headers = headers;
+        m_headers.set(name, value);
     }
 
-    void Request::addHeader(const std::string& name, const std::string& value)
+    void Request::addHeader(std::string_view name, std::string_view value)
     {
-        m_headers[name] = value;
+        m_headers.add(name, value);
     }
 
     const std::optional<std::string>& Request::getBody() const
@@ -5,6 +5,7 @@
 #include "zaplet/http/response.h"
 
 #include <iostream>
+#include <utility>
 
 namespace zaplet::http
 {
@@ -18,19 +19,19 @@ namespace zaplet::http
         m_statusCode = statusCode;
     }
 
-    const std::map<std::string, std::string>& Response::getHeaders() const
+    const Headers& Response::getHeaders() const
     {
         return m_headers;
     }
 
-    void Response::setHeaders(const std::map<std::string, std::string>& headers)
+    void Response::setHeaders(Headers headers)
     {
-        m_headers = headers;
+        m_headers = std::move(headers);
     }
 
-    void Response::addHeader(const std::string& name, const std::string& value)
+    void Response::addHeader(std::string_view name, std::string_view value)
     {
-        m_headers[name] = value;
+        m_headers.add(name, value);
     }
 
     const std::string& Response::getBody() const
@@ -38,9 +39,9 @@ namespace zaplet::http
         return m_body;
     }
 
-    void Response::setBody(const std::string& body)
+    void Response::setBody(std::string body)
     {
-        m_body = body;
+        m_body = std::move(body);
     }
 
     std::chrono::milliseconds Response::getLatency() const
@@ -73,6 +74,16 @@ namespace zaplet::http
         return m_statusCode >= 200 && m_statusCode < 300 && !hasError();
     }
 
+    CacheStatus Response::getCacheStatus() const
+    {
+        return m_cacheStatus;
+    }
+
+    void Response::setCacheStatus(CacheStatus status)
+    {
+        m_cacheStatus = status;
+    }
+
     void printResponse(const std::string& response, int statusCode)
     {
         if (statusCode >= 100 && statusCode < 300)
@@ -92,4 +103,22 @@ namespace zaplet::http
             LOG_DEBUG("Unhandled status code: " + std::to_string(statusCode) + " | " + response);
         }
     }
+
+    bool isResponsePrinted(int statusCode)
+    {
+        spdlog::level::level_enum level = spdlog::level::debug;
+        if (statusCode >= 100 && statusCode < 300)
+        {
+            level = spdlog::level::info;
+        }
+        else if (statusCode >= 300 && statusCode < 400)
+        {
+            level = spdlog::level::warn;
+        }
+        else if (statusCode >= 400 && statusCode <= 599)
+        {
+            level = spdlog::level::err;
+        }
+        return logging::Logger::getInstance().get()->should_log(level);
+    }
 } // namespace zaplet::http
\ No newline at end of file
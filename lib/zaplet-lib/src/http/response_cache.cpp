@@ -0,0 +1,389 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/http/response_cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace zaplet::http
+{
+    namespace
+    {
+        struct CacheControl
+        {
+            bool noStore = false;
+            bool noCache = false;
+            // public or private, which make a response cacheable without an explicit lifetime
+            bool listed = false;
+            std::optional<std::chrono::seconds> maxAge;
+        };
+
+        std::string_view trim(std::string_view value)
+        {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+            {
+                value.remove_prefix(1);
+            }
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+            {
+                value.remove_suffix(1);
+            }
+            return value;
+        }
+
+        std::string_view findHeader(const Headers& headers, std::string_view name)
+        {
+            const std::string* value = headers.find(name);
+            return value == nullptr ? std::string_view() : std::string_view(*value);
+        }
+
+        std::optional<std::int64_t> parseSeconds(std::string_view value)
+        {
+            std::int64_t seconds = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+            if (value.empty() || ec != std::errc() || end != value.data() + value.size() || seconds < 0)
+            {
+                return std::nullopt;
+            }
+            return seconds;
+        }
+
+        CacheControl parseCacheControl(std::string_view value)
+        {
+            CacheControl control;
+            while (!value.empty())
+            {
+                std::size_t comma = value.find(',');
+                std::string_view directive = trim(value.substr(0, comma));
+                value.remove_prefix(comma == std::string_view::npos ? value.size() : comma + 1);
+
+                std::size_t equals = directive.find('=');
+                std::string_view name = trim(directive.substr(0, equals));
+                std::string_view argument = equals == std::string_view::npos ? std::string_view() : trim(directive.substr(equals + 1));
+                if (argument.size() >= 2 && argument.front() == '"' && argument.back() == '"')
+                {
+                    argument = argument.substr(1, argument.size() - 2);
+                }
+
+                if (equalsIgnoreCase(name, "no-store"))
+                {
+                    control.noStore = true;
+                }
+                else if (equalsIgnoreCase(name, "no-cache"))
+                {
+                    control.noCache = true;
+                }
+                else if (equalsIgnoreCase(name, "public") || equalsIgnoreCase(name, "private"))
+                {
+                    control.listed = true;
+                }
+                else if (equalsIgnoreCase(name, "max-age"))
+                {
+                    // an invalid max-age makes the response stale
+                    control.maxAge = std::chrono::seconds(parseSeconds(argument).value_or(0));
+                }
+            }
+            return control;
+        }
+
+        // IMF-fixdate, such as Sun, 06 Nov 1994 08:49:37 GMT; the obsolete formats are treated as invalid
+        std::optional<std::chrono::system_clock::time_point> parseDate(std::string_view value)
+        {
+            static constexpr std::string_view MONTHS = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+            std::size_t comma = value.find(", ");
+            if (comma == std::string_view::npos)
+            {
+                return std::nullopt;
+            }
+            value.remove_prefix(comma + 2);
+            if (value.size() != 24 || value[2] != ' ' || value[6] != ' ' || value[11] != ' ' || value[14] != ':' || value[17] != ':' ||
+                value.substr(20) != " GMT")
+            {
+                return std::nullopt;
+            }
+
+            auto number = [value](std::size_t offset, std::size_t length)
+            {
+                int result = -1;
+                std::from_chars(value.data() + offset, value.data() + offset + length, result);
+                return result;
+            };
+            std::size_t month = MONTHS.find(value.substr(3, 3));
+            if (month == std::string_view::npos || month % 3 != 0)
+            {
+                return std::nullopt;
+            }
+
+            std::chrono::year_month_day date{ std::chrono::year(number(7, 4)),
+                                              std::chrono::month(static_cast<unsigned>(month / 3 + 1)),
+                                              std::chrono::day(static_cast<unsigned>(number(0, 2))) };
+            int hours = number(12, 2);
+            int minutes = number(15, 2);
+            int seconds = number(18, 2);
+            if (!date.ok() || number(7, 4) < 0 || hours < 0 || hours > 23 || minutes < 0 || minutes > 59 || seconds < 0 || seconds > 60)
+            {
+                return std::nullopt;
+            }
+
+            return std::chrono::sys_days(date) + std::chrono::hours(hours) + std::chrono::minutes(minutes) + std::chrono::seconds(seconds);
+        }
+
+        // Status codes a cache may store without an explicit lifetime
+        bool heuristicallyCacheable(int statusCode)
+        {
+            switch (statusCode)
+            {
+            case 200:
+            case 203:
+            case 204:
+            case 300:
+            case 301:
+            case 308:
+            case 404:
+            case 405:
+            case 410:
+            case 414:
+            case 501:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        std::size_t measure(const std::string& key, const Response& response)
+        {
+            std::size_t bytes = key.size() + response.getBody().size();
+            for (const auto& [name, value] : response.getHeaders())
+            {
+                bytes += name.size() + value.size();
+            }
+            return bytes;
+        }
+    } // namespace
+
+    ResponseCache::ResponseCache(std::size_t maxEntries, std::size_t maxBytes)
+        : m_maxEntries(maxEntries)
+        , m_maxBytes(maxBytes)
+    {
+    }
+
+    bool ResponseCache::lookup(const std::string& key, const Headers& headers, Headers& validators, Response& response)
+    {
+        CacheControl requestControl = parseCacheControl(findHeader(headers, "Cache-Control"));
+        if (requestControl.noStore)
+        {
+            return false;
+        }
+
+        std::lock_guard lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it == m_index.end() || varies(*it->second, headers))
+        {
+            return false;
+        }
+
+        Entry& entry = *it->second;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+        auto age = entry.initialAge + std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - entry.stored);
+        bool fresh = !entry.noCache && !requestControl.noCache && age < entry.lifetime &&
+                     (!requestControl.maxAge.has_value() || age <= requestControl.maxAge.value());
+        if (fresh)
+        {
+            response = entry.response;
+            return true;
+        }
+
+        std::string_view etag = findHeader(entry.response.getHeaders(), "ETag");
+        if (!etag.empty() && !headers.contains("If-None-Match"))
+        {
+            validators.add("If-None-Match", etag);
+        }
+        std::string_view lastModified = findHeader(entry.response.getHeaders(), "Last-Modified");
+        if (!lastModified.empty() && !headers.contains("If-Modified-Since"))
+        {
+            validators.add("If-Modified-Since", lastModified);
+        }
+        return false;
+    }
+
+    CacheStatus ResponseCache::update(const std::string& key,
+                                      const std::string& method,
+                                      const Headers& headers,
+                                      Response& response)
+    {
+        if (response.hasError())
+        {
+            return CacheStatus::None;
+        }
+
+        if (method != "GET")
+        {
+            // A successful unsafe method changes the resource, so what was cached for it is no longer valid
+            if (method != "HEAD" && method != "OPTIONS" && response.getStatusCode() < 400)
+            {
+                std::lock_guard lock(m_mutex);
+                erase(key);
+            }
+            return CacheStatus::None;
+        }
+
+        std::lock_guard lock(m_mutex);
+        if (response.getStatusCode() == 304)
+        {
+            auto it = m_index.find(key);
+            if (it == m_index.end() || varies(*it->second, headers))
+            {
+                return CacheStatus::Miss;
+            }
+
+            // The headers of a 304 replace the stored ones of the same name
+            Entry& entry = *it->second;
+            Headers merged = entry.response.getHeaders();
+            for (const auto& [name, value] : response.getHeaders())
+            {
+                if (!equalsIgnoreCase(name, "Content-Length"))
+                {
+                    merged.erase(name);
+                }
+            }
+            for (const auto& [name, value] : response.getHeaders())
+            {
+                if (!equalsIgnoreCase(name, "Content-Length"))
+                {
+                    merged.add(name, value);
+                }
+            }
+            entry.response.setHeaders(std::move(merged));
+            refresh(entry);
+
+            m_bytes -= entry.bytes;
+            entry.bytes = measure(entry.key, entry.response);
+            m_bytes += entry.bytes;
+
+            auto latency = response.getLatency();
+            response = entry.response;
+            response.setLatency(latency);
+            return CacheStatus::Revalidated;
+        }
+
+        // Whatever is stored is replaced by the new response, even when that one cannot be stored itself
+        erase(key);
+
+        const auto& responseHeaders = response.getHeaders();
+        CacheControl requestControl = parseCacheControl(findHeader(headers, "Cache-Control"));
+        CacheControl control = parseCacheControl(findHeader(responseHeaders, "Cache-Control"));
+        std::string_view vary = findHeader(responseHeaders, "Vary");
+        bool explicitLifetime = control.maxAge.has_value() || control.listed || !findHeader(responseHeaders, "Expires").empty();
+        if (requestControl.noStore || control.noStore || vary.find('*') != std::string_view::npos ||
+            (!explicitLifetime && !heuristicallyCacheable(response.getStatusCode())))
+        {
+            return CacheStatus::Miss;
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.response = response;
+        entry.response.setLatency(std::chrono::milliseconds(0));
+        while (!vary.empty())
+        {
+            std::size_t comma = vary.find(',');
+            std::string name(trim(vary.substr(0, comma)));
+            vary.remove_prefix(comma == std::string_view::npos ? vary.size() : comma + 1);
+            if (!name.empty())
+            {
+                entry.vary.emplace_back(name, std::string(findHeader(headers, name)));
+            }
+        }
+        refresh(entry);
+
+        // Neither fresh nor revalidatable, so it could never be used
+        bool validators = !findHeader(responseHeaders, "ETag").empty() || !findHeader(responseHeaders, "Last-Modified").empty();
+        entry.bytes = measure(entry.key, entry.response);
+        if ((entry.lifetime <= entry.initialAge && !validators) || entry.bytes > m_maxBytes)
+        {
+            return CacheStatus::Miss;
+        }
+
+        m_bytes += entry.bytes;
+        m_entries.push_front(std::move(entry));
+        m_index.emplace(m_entries.front().key, m_entries.begin());
+        while (m_entries.size() > m_maxEntries || m_bytes > m_maxBytes)
+        {
+            erase(m_entries.back().key);
+        }
+        return CacheStatus::Miss;
+    }
+
+    std::size_t ResponseCache::size() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_entries.size();
+    }
+
+    std::size_t ResponseCache::getBytes() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_bytes;
+    }
+
+    void ResponseCache::refresh(Entry& entry)
+    {
+        const auto& headers = entry.response.getHeaders();
+        CacheControl control = parseCacheControl(findHeader(headers, "Cache-Control"));
+        auto now = std::chrono::system_clock::now();
+        auto date = parseDate(findHeader(headers, "Date")).value_or(now);
+
+        std::chrono::seconds lifetime{ 0 };
+        std::string_view expires = findHeader(headers, "Expires");
+        if (control.maxAge.has_value())
+        {
+            lifetime = control.maxAge.value();
+        }
+        else if (!expires.empty())
+        {
+            // an invalid Expires means the response has already expired
+            auto at = parseDate(expires);
+            lifetime = at.has_value() ? std::chrono::duration_cast<std::chrono::seconds>(at.value() - date) : lifetime;
+        }
+        else if (auto lastModified = parseDate(findHeader(headers, "Last-Modified"));
+                 lastModified.has_value() && heuristicallyCacheable(entry.response.getStatusCode()))
+        {
+            // the usual heuristic: a tenth of the time since the last modification
+            lifetime = std::chrono::duration_cast<std::chrono::seconds>(date - lastModified.value()) / 10;
+        }
+
+        auto apparentAge = std::max(std::chrono::duration_cast<std::chrono::seconds>(now - date), std::chrono::seconds(0));
+        auto ageValue = std::chrono::seconds(parseSeconds(findHeader(headers, "Age")).value_or(0));
+
+        entry.lifetime = std::max(lifetime, std::chrono::seconds(0));
+        entry.initialAge = std::max(apparentAge, ageValue);
+        entry.stored = std::chrono::steady_clock::now();
+        entry.noCache = control.noCache;
+    }
+
+    bool ResponseCache::varies(const Entry& entry, const Headers& headers)
+    {
+        return std::ranges::any_of(entry.vary, [&headers](const auto& field) { return findHeader(headers, field.first) != field.second; });
+    }
+
+    void ResponseCache::erase(std::string_view key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+        {
+            return;
+        }
+
+        auto entry = it->second;
+        m_bytes -= entry->bytes;
+        m_index.erase(it);
+        m_entries.erase(entry);
+    }
+} // namespace zaplet::http
@@ -0,0 +1,76 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/http/url.h"
+
+#include <charconv>
+
+namespace zaplet::http
+{
+    std::optional<Url> Url::parse(std::string_view url)
+    {
+        Url result;
+
+        std::size_t schemeEnd = url.find("://");
+        if (schemeEnd == std::string_view::npos)
+        {
+            return std::nullopt;
+        }
+
+        std::string_view scheme = url.substr(0, schemeEnd);
+        if (scheme != "http" && scheme != "https")
+        {
+            return std::nullopt;
+        }
+
+        result.scheme = std::string(scheme);
+        result.port = scheme == "https" ? 443 : 80;
+
+        std::string_view rest = url.substr(schemeEnd + 3);
+        std::size_t authorityEnd = rest.find_first_of("/?");
+        std::string_view authority = rest.substr(0, authorityEnd);
+
+        std::size_t colon = authority.find(':');
+        std::string_view host = authority.substr(0, colon);
+        if (host.empty())
+        {
+            return std::nullopt;
+        }
+
+        if (colon != std::string_view::npos)
+        {
+            std::string_view port = authority.substr(colon + 1);
+            auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), result.port);
+            if (port.empty() || ec != std::errc() || ptr != port.data() + port.size() || result.port <= 0 || result.port > 65535)
+            {
+                return std::nullopt;
+            }
+        }
+
+        result.host = std::string(host);
+
+        if (authorityEnd != std::string_view::npos)
+        {
+            std::string_view path = rest.substr(authorityEnd);
+            result.path = path.front() == '/' ? std::string(path) : "/" + std::string(path);
+        }
+
+        return result;
+    }
+
+    bool Url::isDefaultPort() const
+    {
+        return port == (scheme == "https" ? 443 : 80);
+    }
+
+    void Url::appendOrigin(std::string& out) const
+    {
+        out.append(scheme).append("://").append(host);
+        if (!isDefaultPort())
+        {
+            out.push_back(':');
+            out.append(std::to_string(port));
+        }
+    }
+} // namespace zaplet::http
@@ -21,11 +21,24 @@ namespace zaplet::output
         nlohmann::json headers;
         for (const auto& [name, value] : response.getHeaders())
         {
-            headers[name] = value;
+            // a repeated header such as Set-Cookie lists all its values
+            if (!headers.contains(name))
+            {
+                headers[name] = value;
+            }
+            else if (headers[name].is_array())
+            {
+                headers[name].push_back(value);
+            }
+            else
+            {
+                headers[name] = nlohmann::json::array({ headers[name], value });
+            }
         }
         jsonResponse["headers"] = headers;
 
-        if (response.getHeaders().count("Content-Type") > 0 && response.getHeaders().at("Content-Type").find("application/json") != std::string::npos)
+        const std::string* contentType = response.getHeaders().find("Content-Type");
+        if (contentType != nullptr && contentType->find("application/json") != std::string::npos)
         {
             try
             {
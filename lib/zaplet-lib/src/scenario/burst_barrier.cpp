@@ -0,0 +1,135 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/burst_barrier.h"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // How many spins pass between two looks at the abort request
+        constexpr std::uint32_t SPINS_PER_CHECK = 1024;
+
+        void relax()
+        {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+            _mm_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+    } // namespace
+
+    BurstBarrier::BurstBarrier(std::size_t participants, std::chrono::milliseconds interval)
+        : m_participants(std::max<std::size_t>(participants, 1))
+        , m_interval(interval)
+    {
+    }
+
+    std::optional<BurstBarrier::Release> BurstBarrier::arrive(const std::stop_token& abort)
+    {
+        std::uint64_t round = 0;
+        {
+            std::unique_lock lock(m_mutex);
+            round = m_round.load(std::memory_order_relaxed);
+
+            if (++m_arrived == m_participants)
+            {
+                std::size_t waiting = m_arrived - 1;
+                m_arrived = 0;
+                lock.unlock();
+
+                Release result = release(round, waiting, abort);
+                if (abort.stop_requested())
+                {
+                    return std::nullopt;
+                }
+                return result;
+            }
+
+            if (!m_wakeUp.wait(lock, abort, [this, round]() { return m_armed > round; }))
+            {
+                return std::nullopt;
+            }
+        }
+
+        m_spinning.fetch_add(1, std::memory_order_release);
+        for (std::uint32_t spins = 1; m_round.load(std::memory_order_acquire) == round; ++spins)
+        {
+            if (spins % SPINS_PER_CHECK == 0)
+            {
+                if (abort.stop_requested())
+                {
+                    return std::nullopt;
+                }
+                // lets the participants still being woken up run when there are more of them than cores
+                std::this_thread::yield();
+            }
+            relax();
+        }
+
+        return Release{ round + 1, m_releaseTime };
+    }
+
+    void BurstBarrier::leave(const std::stop_token& abort)
+    {
+        std::unique_lock lock(m_mutex);
+        --m_participants;
+
+        if (m_arrived > 0 && m_arrived == m_participants)
+        {
+            std::uint64_t round = m_round.load(std::memory_order_relaxed);
+            std::size_t waiting = m_arrived;
+            m_arrived = 0;
+            lock.unlock();
+
+            (void)release(round, waiting, abort);
+        }
+    }
+
+    BurstBarrier::Release BurstBarrier::release(std::uint64_t round, std::size_t waiting, const std::stop_token& abort)
+    {
+        std::unique_lock lock(m_mutex);
+
+        // Everyone else sleeps until the interval since the previous release is over
+        if (m_interval.count() > 0 && m_lastRelease != std::chrono::steady_clock::time_point())
+        {
+            m_wakeUp.wait_until(lock, abort, m_lastRelease + m_interval, []() { return false; });
+        }
+
+        m_armed = round + 1;
+        lock.unlock();
+        m_wakeUp.notify_all();
+
+        for (std::uint32_t spins = 1; m_spinning.load(std::memory_order_acquire) < waiting; ++spins)
+        {
+            if (spins % SPINS_PER_CHECK == 0)
+            {
+                if (abort.stop_requested())
+                {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+            relax();
+        }
+        m_spinning.store(0, std::memory_order_relaxed);
+
+        auto now = std::chrono::steady_clock::now();
+        lock.lock();
+        m_lastRelease = now;
+        lock.unlock();
+
+        m_releaseTime = now;
+        m_round.store(round + 1, std::memory_order_release);
+        return Release{ round + 1, now };
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,775 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/condition.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // Operands are views into the frame, the response or the expression tree, so evaluation never allocates
+        struct Value
+        {
+            enum class Type
+            {
+                Null,
+                Boolean,
+                Number,
+                String,
+                Json
+            };
+
+            Type type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string_view string;
+            const nlohmann::json* json = nullptr;
+        };
+
+        Value makeBoolean(bool boolean)
+        {
+            Value value;
+            value.type = Value::Type::Boolean;
+            value.boolean = boolean;
+            return value;
+        }
+
+        Value makeNumber(double number)
+        {
+            Value value;
+            value.type = Value::Type::Number;
+            value.number = number;
+            return value;
+        }
+
+        Value makeString(std::string_view string)
+        {
+            Value value;
+            value.type = Value::Type::String;
+            value.string = string;
+            return value;
+        }
+
+        Value fromJson(const nlohmann::json& node)
+        {
+            if (node.is_null())
+            {
+                return {};
+            }
+            if (node.is_boolean())
+            {
+                return makeBoolean(node.get<bool>());
+            }
+            if (node.is_number())
+            {
+                return makeNumber(node.get<double>());
+            }
+            if (node.is_string())
+            {
+                return makeString(node.get_ref<const std::string&>());
+            }
+
+            Value value;
+            value.type = Value::Type::Json;
+            value.json = &node;
+            return value;
+        }
+
+        Value fromLiteral(const JsonPath::Literal& literal)
+        {
+            switch (literal.type)
+            {
+            case JsonPath::Literal::Type::Boolean:
+                return makeBoolean(literal.boolean);
+            case JsonPath::Literal::Type::Number:
+                return makeNumber(literal.number);
+            case JsonPath::Literal::Type::String:
+                return makeString(literal.string);
+            case JsonPath::Literal::Type::Null:
+                break;
+            }
+
+            return {};
+        }
+
+        std::optional<double> toNumber(const Value& value)
+        {
+            if (value.type == Value::Type::Number)
+            {
+                return value.number;
+            }
+
+            if (value.type == Value::Type::String && !value.string.empty())
+            {
+                double number = 0.0;
+                const char* end = value.string.data() + value.string.size();
+                auto [ptr, ec] = std::from_chars(value.string.data(), end, number);
+                if (ec == std::errc() && ptr == end)
+                {
+                    return number;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        bool isTruthy(const Value& value)
+        {
+            switch (value.type)
+            {
+            case Value::Type::Null:
+                return false;
+            case Value::Type::Boolean:
+                return value.boolean;
+            case Value::Type::Number:
+                return value.number != 0.0;
+            case Value::Type::String:
+                return !value.string.empty() && value.string != "false";
+            case Value::Type::Json:
+                return !value.json->empty();
+            }
+
+            return false;
+        }
+
+        bool equals(const Value& left, const Value& right)
+        {
+            if (left.type == Value::Type::Null || right.type == Value::Type::Null)
+            {
+                return left.type == right.type;
+            }
+
+            if (left.type == Value::Type::Json || right.type == Value::Type::Json)
+            {
+                return left.type == right.type && *left.json == *right.json;
+            }
+
+            if (left.type == Value::Type::Boolean || right.type == Value::Type::Boolean)
+            {
+                if (left.type == right.type)
+                {
+                    return left.boolean == right.boolean;
+                }
+
+                const Value& boolean = left.type == Value::Type::Boolean ? left : right;
+                const Value& other = left.type == Value::Type::Boolean ? right : left;
+                return other.type == Value::Type::String && other.string == (boolean.boolean ? "true" : "false");
+            }
+
+            if (left.type == Value::Type::String && right.type == Value::Type::String)
+            {
+                return left.string == right.string;
+            }
+
+            // A number against a number or against a string holding one, e.g. an extracted "200" == 200
+            auto leftNumber = toNumber(left);
+            auto rightNumber = toNumber(right);
+            return leftNumber.has_value() && rightNumber.has_value() && *leftNumber == *rightNumber;
+        }
+
+        // Returns <0, 0 or >0, or nullopt when the operands are not ordered
+        std::optional<int> compare(const Value& left, const Value& right)
+        {
+            auto leftNumber = toNumber(left);
+            auto rightNumber = toNumber(right);
+            if (leftNumber.has_value() && rightNumber.has_value())
+            {
+                return *leftNumber < *rightNumber ? -1 : (*leftNumber > *rightNumber ? 1 : 0);
+            }
+
+            if (left.type == Value::Type::String && right.type == Value::Type::String)
+            {
+                return left.string.compare(right.string);
+            }
+
+            return std::nullopt;
+        }
+
+        bool contains(const Value& haystack, const Value& needle)
+        {
+            if (haystack.type == Value::Type::String)
+            {
+                return needle.type == Value::Type::String && haystack.string.find(needle.string) != std::string_view::npos;
+            }
+
+            if (haystack.type != Value::Type::Json)
+            {
+                return false;
+            }
+
+            if (haystack.json->is_object())
+            {
+                return needle.type == Value::Type::String && haystack.json->find(needle.string) != haystack.json->end();
+            }
+
+            return std::any_of(
+                haystack.json->begin(),
+                haystack.json->end(),
+                [&needle](const nlohmann::json& item) { return equals(fromJson(item), needle); });
+        }
+
+        bool isNameChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+        }
+
+        class ConditionParser
+        {
+        public:
+            ConditionParser(std::string_view expression, std::vector<Condition::Node>& nodes, VariableTable& table)
+                : m_expression(expression)
+                , m_nodes(nodes)
+                , m_table(table)
+            {
+            }
+
+            std::size_t parse()
+            {
+                std::size_t root = parseOr();
+
+                skipSpaces();
+                if (!atEnd())
+                {
+                    fail("unexpected input");
+                }
+
+                return root;
+            }
+
+        private:
+            std::string_view m_expression;
+            std::vector<Condition::Node>& m_nodes;
+            VariableTable& m_table;
+            std::size_t m_pos = 0;
+
+            [[nodiscard]] bool atEnd() const
+            {
+                return m_pos >= m_expression.size();
+            }
+
+            [[nodiscard]] char peek() const
+            {
+                return atEnd() ? '\0' : m_expression[m_pos];
+            }
+
+            void skipSpaces()
+            {
+                while (!atEnd() && std::isspace(static_cast<unsigned char>(peek())))
+                {
+                    ++m_pos;
+                }
+            }
+
+            bool consume(std::string_view token)
+            {
+                skipSpaces();
+                if (m_expression.substr(m_pos).starts_with(token))
+                {
+                    m_pos += token.size();
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Like consume(), but a word operator must not run into a following name
+            bool consumeWord(std::string_view word)
+            {
+                skipSpaces();
+                std::size_t end = m_pos + word.size();
+                if (m_expression.substr(m_pos).starts_with(word) && (end >= m_expression.size() || !isNameChar(m_expression[end])))
+                {
+                    m_pos = end;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void expect(std::string_view token)
+            {
+                if (!consume(token))
+                {
+                    fail(std::format("expected '{}'", token));
+                }
+            }
+
+            std::size_t add(Condition::Node node)
+            {
+                m_nodes.push_back(std::move(node));
+                return m_nodes.size() - 1;
+            }
+
+            std::size_t addBinary(Condition::NodeKind kind, std::size_t left, std::size_t right)
+            {
+                Condition::Node node;
+                node.kind = kind;
+                node.left = left;
+                node.right = right;
+                return add(std::move(node));
+            }
+
+            std::size_t parseOr()
+            {
+                std::size_t left = parseAnd();
+                while (consume("||"))
+                {
+                    left = addBinary(Condition::NodeKind::Or, left, parseAnd());
+                }
+
+                return left;
+            }
+
+            std::size_t parseAnd()
+            {
+                std::size_t left = parseComparison();
+                while (consume("&&"))
+                {
+                    left = addBinary(Condition::NodeKind::And, left, parseComparison());
+                }
+
+                return left;
+            }
+
+            std::optional<Condition::CompareOp> parseOperator()
+            {
+                if (consume("=="))
+                {
+                    return Condition::CompareOp::Equal;
+                }
+                if (consume("!="))
+                {
+                    return Condition::CompareOp::NotEqual;
+                }
+                if (consume("<="))
+                {
+                    return Condition::CompareOp::LessEqual;
+                }
+                if (consume(">="))
+                {
+                    return Condition::CompareOp::GreaterEqual;
+                }
+                if (consume("<"))
+                {
+                    return Condition::CompareOp::Less;
+                }
+                if (consume(">"))
+                {
+                    return Condition::CompareOp::Greater;
+                }
+                if (consumeWord("contains"))
+                {
+                    return Condition::CompareOp::Contains;
+                }
+                if (consumeWord("matches"))
+                {
+                    return Condition::CompareOp::Matches;
+                }
+
+                return std::nullopt;
+            }
+
+            std::size_t parseComparison()
+            {
+                std::size_t left = parseUnary();
+
+                auto op = parseOperator();
+                if (!op.has_value())
+                {
+                    return left;
+                }
+
+                std::size_t patternPos = m_pos;
+                std::size_t right = parseUnary();
+
+                Condition::Node node;
+                node.kind = Condition::NodeKind::Compare;
+                node.op = *op;
+                node.left = left;
+                node.right = right;
+
+                if (*op == Condition::CompareOp::Matches)
+                {
+                    const auto& pattern = m_nodes[right];
+                    if (pattern.kind != Condition::NodeKind::Literal || pattern.literal.type != JsonPath::Literal::Type::String)
+                    {
+                        m_pos = patternPos;
+                        fail("'matches' expects a quoted regular expression");
+                    }
+                    node.pattern = Pattern::compile(pattern.literal.string);
+                }
+
+                return add(std::move(node));
+            }
+
+            std::size_t parseUnary()
+            {
+                if (consume("!"))
+                {
+                    Condition::Node node;
+                    node.kind = Condition::NodeKind::Not;
+                    node.left = parseUnary();
+                    return add(std::move(node));
+                }
+
+                return parsePrimary();
+            }
+
+            std::size_t parsePrimary()
+            {
+                skipSpaces();
+
+                if (consume("("))
+                {
+                    std::size_t inner = parseOr();
+                    expect(")");
+                    return inner;
+                }
+
+                if (consume("${"))
+                {
+                    std::string name = parseName();
+                    expect("}");
+                    return addVariable(name);
+                }
+
+                char c = peek();
+                if (c == '"' || c == '\'')
+                {
+                    std::string text = parseQuoted();
+
+                    // "${name}" is kept as a reference for conditions written before the expression language
+                    if (text.size() > 3 && text.starts_with("${") && text.ends_with('}') &&
+                        std::all_of(text.begin() + 2, text.end() - 1, isNameChar))
+                    {
+                        return addVariable(text.substr(2, text.size() - 3));
+                    }
+
+                    Condition::Node node;
+                    node.literal.type = JsonPath::Literal::Type::String;
+                    node.literal.string = std::move(text);
+                    return add(std::move(node));
+                }
+
+                if (c == '-' || c == '+' || std::isdigit(static_cast<unsigned char>(c)))
+                {
+                    Condition::Node node;
+                    node.literal.type = JsonPath::Literal::Type::Number;
+
+                    const char* begin = m_expression.data() + m_pos + (c == '+' ? 1 : 0);
+                    auto [ptr, ec] = std::from_chars(begin, m_expression.data() + m_expression.size(), node.literal.number);
+                    if (ec != std::errc() || ptr == begin)
+                    {
+                        fail("expected number");
+                    }
+
+                    m_pos = static_cast<std::size_t>(ptr - m_expression.data());
+                    return add(std::move(node));
+                }
+
+                std::string name = parseName();
+
+                if (name == "true" || name == "false")
+                {
+                    Condition::Node node;
+                    node.literal.type = JsonPath::Literal::Type::Boolean;
+                    node.literal.boolean = name == "true";
+                    return add(std::move(node));
+                }
+                if (name == "null")
+                {
+                    return add(Condition::Node{});
+                }
+
+                if (consume("("))
+                {
+                    return parseFunction(name);
+                }
+
+                return addVariable(name);
+            }
+
+            std::size_t parseFunction(const std::string& name)
+            {
+                Condition::Node node;
+                node.kind = Condition::NodeKind::Function;
+
+                if (name == "exists" || name == "len")
+                {
+                    node.function = name == "exists" ? Condition::Function::Exists : Condition::Function::Len;
+                    node.left = parseOr();
+                    node.hasArgument = true;
+                }
+                else if (name == "header" || name == "json")
+                {
+                    skipSpaces();
+                    if (peek() != '"' && peek() != '\'')
+                    {
+                        fail(std::format("{}() expects a quoted argument", name));
+                    }
+
+                    node.argument = parseQuoted();
+                    if (name == "json")
+                    {
+                        node.function = Condition::Function::Json;
+                        node.path = JsonPath::compile(node.argument);
+                    }
+                    else
+                    {
+                        node.function = Condition::Function::Header;
+                    }
+                }
+                else if (name == "status")
+                {
+                    node.function = Condition::Function::Status;
+                }
+                else if (name == "body")
+                {
+                    node.function = Condition::Function::Body;
+                }
+                else
+                {
+                    fail(std::format("unknown function '{}'", name));
+                }
+
+                expect(")");
+                return add(std::move(node));
+            }
+
+            std::size_t addVariable(const std::string& name)
+            {
+                Condition::Node node;
+                node.kind = Condition::NodeKind::Variable;
+                node.slot = m_table.intern(name);
+                return add(std::move(node));
+            }
+
+            std::string parseName()
+            {
+                skipSpaces();
+
+                std::size_t start = m_pos;
+                while (!atEnd() && isNameChar(peek()))
+                {
+                    ++m_pos;
+                }
+
+                if (start == m_pos)
+                {
+                    fail("expected operand");
+                }
+
+                return std::string(m_expression.substr(start, m_pos - start));
+            }
+
+            std::string parseQuoted()
+            {
+                char quote = peek();
+                ++m_pos;
+
+                std::string result;
+                while (!atEnd() && peek() != quote)
+                {
+                    if (peek() == '\\' && m_pos + 1 < m_expression.size())
+                    {
+                        ++m_pos;
+                    }
+                    result.push_back(peek());
+                    ++m_pos;
+                }
+
+                if (atEnd())
+                {
+                    fail("unterminated string");
+                }
+
+                ++m_pos;
+                return result;
+            }
+
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::runtime_error(std::format("Invalid condition '{}' at position {}: {}", m_expression, m_pos, message));
+            }
+        };
+
+        class Evaluator
+        {
+        public:
+            Evaluator(const std::vector<Condition::Node>& nodes, const VariableFrame& frame, ResponseDocument* response)
+                : m_nodes(nodes)
+                , m_frame(frame)
+                , m_response(response)
+            {
+            }
+
+            Value evaluate(std::size_t index) const
+            {
+                const Condition::Node& node = m_nodes[index];
+
+                switch (node.kind)
+                {
+                case Condition::NodeKind::Literal:
+                    return fromLiteral(node.literal);
+                case Condition::NodeKind::Variable:
+                    return m_frame.has(node.slot) ? makeString(m_frame.get(node.slot)) : Value{};
+                case Condition::NodeKind::Not:
+                    return makeBoolean(!isTruthy(evaluate(node.left)));
+                case Condition::NodeKind::And:
+                    return makeBoolean(isTruthy(evaluate(node.left)) && isTruthy(evaluate(node.right)));
+                case Condition::NodeKind::Or:
+                    return makeBoolean(isTruthy(evaluate(node.left)) || isTruthy(evaluate(node.right)));
+                case Condition::NodeKind::Compare:
+                    return makeBoolean(evaluateCompare(node));
+                case Condition::NodeKind::Function:
+                    return evaluateFunction(node);
+                }
+
+                return {};
+            }
+
+        private:
+            const std::vector<Condition::Node>& m_nodes;
+            const VariableFrame& m_frame;
+            ResponseDocument* m_response;
+
+            bool evaluateCompare(const Condition::Node& node) const
+            {
+                Value left = evaluate(node.left);
+
+                if (node.op == Condition::CompareOp::Matches)
+                {
+                    return left.type == Value::Type::String && node.pattern.contains(left.string);
+                }
+
+                Value right = evaluate(node.right);
+
+                switch (node.op)
+                {
+                case Condition::CompareOp::Equal:
+                    return equals(left, right);
+                case Condition::CompareOp::NotEqual:
+                    return !equals(left, right);
+                case Condition::CompareOp::Contains:
+                    return contains(left, right);
+                default:
+                    break;
+                }
+
+                auto order = compare(left, right);
+                if (!order.has_value())
+                {
+                    return false;
+                }
+
+                switch (node.op)
+                {
+                case Condition::CompareOp::Less:
+                    return *order < 0;
+                case Condition::CompareOp::LessEqual:
+                    return *order <= 0;
+                case Condition::CompareOp::Greater:
+                    return *order > 0;
+                case Condition::CompareOp::GreaterEqual:
+                    return *order >= 0;
+                default:
+                    return false;
+                }
+            }
+
+            Value evaluateFunction(const Condition::Node& node) const
+            {
+                switch (node.function)
+                {
+                case Condition::Function::Exists:
+                    return makeBoolean(evaluate(node.left).type != Value::Type::Null);
+                case Condition::Function::Len:
+                    {
+                        Value value = evaluate(node.left);
+                        if (value.type == Value::Type::String)
+                        {
+                            return makeNumber(static_cast<double>(value.string.size()));
+                        }
+                        if (value.type == Value::Type::Json)
+                        {
+                            return makeNumber(static_cast<double>(value.json->size()));
+                        }
+                        return value.type == Value::Type::Null ? makeNumber(0.0) : Value{};
+                    }
+                default:
+                    break;
+                }
+
+                if (m_response == nullptr)
+                {
+                    return {};
+                }
+
+                const http::Response& response = m_response->getResponse();
+
+                switch (node.function)
+                {
+                case Condition::Function::Status:
+                    return makeNumber(static_cast<double>(response.getStatusCode()));
+                case Condition::Function::Body:
+                    return makeString(response.getBody());
+                case Condition::Function::Header:
+                    {
+                        const std::string* value = response.getHeaders().find(node.argument);
+                        return value != nullptr ? makeString(*value) : Value{};
+                    }
+                case Condition::Function::Json:
+                    {
+                        const nlohmann::json* root = m_response->getJson();
+                        const nlohmann::json* selected = root != nullptr ? node.path.selectFirst(*root) : nullptr;
+                        return selected != nullptr ? fromJson(*selected) : Value{};
+                    }
+                default:
+                    return {};
+                }
+            }
+        };
+    } // namespace
+
+    Condition Condition::compile(std::string_view expression, VariableTable& table)
+    {
+        Condition condition;
+        condition.m_source = std::string(expression);
+
+        ConditionParser parser(expression, condition.m_nodes, table);
+        condition.m_root = parser.parse();
+
+        return condition;
+    }
+
+    bool Condition::evaluate(const VariableFrame& frame, ResponseDocument* response) const
+    {
+        if (m_nodes.empty())
+        {
+            return true;
+        }
+
+        Evaluator evaluator(m_nodes, frame, response);
+        return isTruthy(evaluator.evaluate(m_root));
+    }
+
+    const std::string& Condition::getSource() const
+    {
+        return m_source;
+    }
+
+    const std::vector<Condition::Node>& Condition::getNodes() const
+    {
+        return m_nodes;
+    }
+} // namespace zaplet::scenario
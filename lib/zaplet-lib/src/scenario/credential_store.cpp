@@ -0,0 +1,41 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/credential_store.h"
+
+namespace zaplet::scenario
+{
+    CredentialStore::CredentialStore(std::size_t size)
+        : m_entries(std::make_unique<Entry[]>(size))
+        , m_size(size)
+    {
+    }
+
+    std::shared_ptr<const Credential> CredentialStore::lease(std::size_t entry) const
+    {
+        return m_entries[entry % m_size].credential.load(std::memory_order_acquire);
+    }
+
+    bool CredentialStore::claim(std::size_t entry)
+    {
+        std::atomic<bool>& claimed = m_entries[entry % m_size].claimed;
+        return !claimed.load(std::memory_order_relaxed) && !claimed.exchange(true, std::memory_order_acquire);
+    }
+
+    void CredentialStore::publish(std::size_t entry, std::shared_ptr<const Credential> credential)
+    {
+        m_entries[entry % m_size].credential.store(std::move(credential), std::memory_order_release);
+        release(entry);
+    }
+
+    void CredentialStore::release(std::size_t entry)
+    {
+        m_entries[entry % m_size].claimed.store(false, std::memory_order_release);
+    }
+
+    std::size_t CredentialStore::size() const
+    {
+        return m_size;
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,561 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/data_feed.h"
+
+#include "zaplet/logging/logger.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // Reads the CSV field starting at pos and moves pos past its delimiter; false when the line has no more fields.
+        // Quoted fields are unescaped into scratch, others are returned as views into the line.
+        bool nextField(std::string_view line, std::size_t& pos, char delimiter, std::string& scratch, std::string_view& value)
+        {
+            if (pos > line.size())
+            {
+                return false;
+            }
+
+            if (pos < line.size() && line[pos] == '"')
+            {
+                scratch.clear();
+                ++pos;
+                while (pos < line.size())
+                {
+                    char c = line[pos++];
+                    if (c != '"')
+                    {
+                        scratch.push_back(c);
+                    }
+                    else if (pos < line.size() && line[pos] == '"')
+                    {
+                        scratch.push_back('"');
+                        ++pos;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                std::size_t next = line.find(delimiter, pos);
+                pos = next == std::string_view::npos ? line.size() + 1 : next + 1;
+                value = scratch;
+                return true;
+            }
+
+            std::size_t next = line.find(delimiter, pos);
+            std::size_t end = next == std::string_view::npos ? line.size() : next;
+            value = line.substr(pos, end - pos);
+            pos = end + 1;
+            return true;
+        }
+
+        // True when a quoted field of the line is not closed before the line ends
+        bool hasOpenQuote(std::string_view line, char delimiter)
+        {
+            for (std::size_t pos = 0; pos < line.size();)
+            {
+                if (line[pos] != '"')
+                {
+                    std::size_t next = line.find(delimiter, pos);
+                    pos = next == std::string_view::npos ? line.size() : next + 1;
+                    continue;
+                }
+
+                ++pos;
+                while (true)
+                {
+                    std::size_t quote = line.find('"', pos);
+                    if (quote == std::string_view::npos)
+                    {
+                        return true;
+                    }
+                    pos = quote + 1;
+                    if (pos < line.size() && line[pos] == '"')
+                    {
+                        ++pos;
+                        continue;
+                    }
+                    break;
+                }
+
+                std::size_t next = line.find(delimiter, pos);
+                pos = next == std::string_view::npos ? line.size() : next + 1;
+            }
+            return false;
+        }
+
+        constexpr std::size_t MAX_MALFORMED_RECORDS = 1024;
+    } // namespace
+
+    MappedFile::MappedFile(const std::string& path)
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error(std::format("Failed to open data file '{}': error {}", path, GetLastError()));
+        }
+        m_file = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            throw std::runtime_error(std::format("Failed to read the size of data file '{}': error {}", path, GetLastError()));
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+
+        if (m_size > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (view == nullptr)
+            {
+                DWORD error = GetLastError();
+                if (mapping != nullptr)
+                {
+                    CloseHandle(mapping);
+                }
+                CloseHandle(file);
+                throw std::runtime_error(std::format("Failed to map data file '{}': error {}", path, error));
+            }
+            m_mapping = mapping;
+            m_data = static_cast<const char*>(view);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error(std::format("Failed to open data file '{}': {}", path, std::strerror(errno)));
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0)
+        {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error(std::format("Failed to read the size of data file '{}': {}", path, std::strerror(error)));
+        }
+        m_size = static_cast<std::size_t>(info.st_size);
+
+        if (m_size > 0)
+        {
+            void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (data == MAP_FAILED)
+            {
+                throw std::runtime_error(std::format("Failed to map data file '{}': {}", path, std::strerror(error)));
+            }
+            m_data = static_cast<const char*>(data);
+        }
+        else
+        {
+            ::close(fd);
+        }
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+#if defined(_WIN32)
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != nullptr)
+        {
+            CloseHandle(m_file);
+        }
+#else
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    std::string_view MappedFile::getView() const
+    {
+        return { m_data, m_size };
+    }
+
+    DataFeed::DataFeed(const DataSource& source, VariableTable& table)
+        : m_file(source.file)
+        , m_ndjson(source.format == "ndjson")
+        , m_mode(source.mode)
+        , m_delimiter(source.delimiter)
+        , m_mapping(source.file)
+    {
+        m_records = m_mapping.getView();
+        if (m_records.starts_with("\xEF\xBB\xBF"))
+        {
+            m_records.remove_prefix(3);
+        }
+
+        // Records are found by their line breaks, so a quoted field must not contain one
+        if (!m_ndjson)
+        {
+            std::size_t line = 1;
+            for (std::size_t offset = 0; offset < m_records.size(); ++line)
+            {
+                std::size_t lineBreak = m_records.find('\n', offset);
+                std::size_t end = lineBreak == std::string_view::npos ? m_records.size() : lineBreak;
+                if (hasOpenQuote(m_records.substr(offset, end - offset), m_delimiter))
+                {
+                    throw std::runtime_error(
+                        std::format("Line {} of data file '{}' has an unterminated quoted field, quoted fields cannot contain line breaks",
+                                    line,
+                                    m_file));
+                }
+                offset = end + 1;
+            }
+        }
+
+        if (!m_ndjson && source.header)
+        {
+            std::size_t headerEnd = recordEnd(0);
+            std::string_view header = m_records.substr(0, headerEnd);
+
+            std::string scratch;
+            std::string_view name;
+            for (std::size_t pos = 0; nextField(header, pos, m_delimiter, scratch, name);)
+            {
+                m_columns.emplace_back(name);
+            }
+            m_records.remove_prefix(recordStart(headerEnd + 1));
+        }
+
+        if (!source.columns.empty())
+        {
+            m_columns = source.columns;
+        }
+
+        std::size_t first = 0;
+        while (first < m_records.size() && first == recordEnd(first))
+        {
+            first = recordStart(first + 1);
+        }
+        if (first >= m_records.size())
+        {
+            throw std::runtime_error(std::format("Data file '{}' has no records", m_file));
+        }
+
+        if (m_ndjson && m_columns.empty())
+        {
+            auto object = nlohmann::json::parse(m_records.substr(first, recordEnd(first) - first), nullptr, false);
+            if (!object.is_object())
+            {
+                throw std::runtime_error(std::format("First record of data file '{}' is not a JSON object", m_file));
+            }
+            for (const auto& [key, value] : object.items())
+            {
+                m_columns.push_back(key);
+            }
+        }
+
+        if (m_columns.empty())
+        {
+            throw std::runtime_error(std::format("Data file '{}' has no columns, enable header or list the columns", m_file));
+        }
+
+        m_bindings.resize(m_columns.size());
+        if (source.variables.empty())
+        {
+            for (std::size_t column = 0; column < m_columns.size(); ++column)
+            {
+                m_bindings[column].push_back(table.intern(m_columns[column]));
+            }
+        }
+        else
+        {
+            for (const auto& [variable, columnName] : source.variables)
+            {
+                auto it = std::find(m_columns.begin(), m_columns.end(), columnName);
+                if (it == m_columns.end())
+                {
+                    throw std::runtime_error(std::format("Data file '{}' has no column '{}'", m_file, columnName));
+                }
+                m_bindings[static_cast<std::size_t>(it - m_columns.begin())].push_back(table.intern(variable));
+            }
+        }
+
+        // Small files still get split into several ranges so that every virtual user gets records
+        m_chunkSize = std::clamp<std::size_t>(m_records.size() / 4096, 64, 64 * 1024);
+        m_chunkCount = (m_records.size() + m_chunkSize - 1) / m_chunkSize;
+
+        LOG_DEBUG_FMT("Mapped data file '{}': {} bytes, {} columns, {} ranges", m_file, m_records.size(), m_columns.size(), m_chunkCount);
+    }
+
+    DataCursor DataFeed::createCursor(std::size_t virtualUser, std::size_t virtualUsers) const
+    {
+        return DataCursor(*this, virtualUser, virtualUsers);
+    }
+
+    const std::string& DataFeed::getFile() const
+    {
+        return m_file;
+    }
+
+    DataMode DataFeed::getMode() const
+    {
+        return m_mode;
+    }
+
+    const std::vector<std::string>& DataFeed::getColumns() const
+    {
+        return m_columns;
+    }
+
+    const std::vector<std::vector<VariableSlot>>& DataFeed::getBindings() const
+    {
+        return m_bindings;
+    }
+
+    std::size_t DataFeed::recordStart(std::size_t offset) const
+    {
+        if (offset == 0 || offset >= m_records.size())
+        {
+            return std::min(offset, m_records.size());
+        }
+
+        if (m_records[offset - 1] == '\n')
+        {
+            return offset;
+        }
+
+        std::size_t lineBreak = m_records.find('\n', offset);
+        return lineBreak == std::string_view::npos ? m_records.size() : lineBreak + 1;
+    }
+
+    std::size_t DataFeed::recordEnd(std::size_t offset) const
+    {
+        std::size_t lineBreak = m_records.find('\n', offset);
+        std::size_t end = lineBreak == std::string_view::npos ? m_records.size() : lineBreak;
+        if (end > offset && m_records[end - 1] == '\r')
+        {
+            --end;
+        }
+        return end;
+    }
+
+    DataCursor::DataCursor(const DataFeed& feed, std::size_t virtualUser, std::size_t virtualUsers)
+        : m_feed(&feed)
+        , m_virtualUser(virtualUser)
+        , m_virtualUsers(std::max<std::size_t>(virtualUsers, 1))
+        , m_nextRange(virtualUser)
+        , m_rangeSize(std::clamp<std::size_t>(feed.m_records.size() / m_virtualUsers, 1, feed.m_chunkSize))
+        , m_random(Random::local().next())
+    {
+    }
+
+    bool DataCursor::next(VariableFrame& frame)
+    {
+        std::string_view record;
+        for (std::size_t malformed = 0; malformed < MAX_MALFORMED_RECORDS; ++malformed)
+        {
+            if (!findRecord(record))
+            {
+                return false;
+            }
+
+            if (!m_feed->m_ndjson)
+            {
+                bindCsv(record, frame);
+                return true;
+            }
+
+            if (bindJson(record, frame))
+            {
+                return true;
+            }
+
+            LOG_WARNING_FMT("Skipping a record of '{}' that is not a JSON object", m_feed->m_file);
+        }
+
+        LOG_ERROR_FMT("Too many malformed records in '{}'", m_feed->m_file);
+        return false;
+    }
+
+    const DataFeed& DataCursor::getFeed() const
+    {
+        return *m_feed;
+    }
+
+    bool DataCursor::claim()
+    {
+        const DataFeed& feed = *m_feed;
+
+        // Virtual user k of n owns ranges k, k + n, k + 2n, ..., which needs no counter shared with the others
+        if (feed.m_mode == DataMode::Unique)
+        {
+            std::size_t start = m_nextRange * m_rangeSize;
+            if (start >= feed.m_records.size())
+            {
+                return false;
+            }
+            m_nextRange += m_virtualUsers;
+            m_claimEnd = std::min(start + m_rangeSize, feed.m_records.size());
+            m_position = feed.recordStart(start);
+            return true;
+        }
+
+        std::uint64_t claim = feed.m_claims.fetch_add(1, std::memory_order_relaxed);
+        if (feed.m_mode == DataMode::Sequential && claim >= feed.m_chunkCount)
+        {
+            return false;
+        }
+
+        std::size_t start = static_cast<std::size_t>(claim % feed.m_chunkCount) * feed.m_chunkSize;
+        m_claimEnd = std::min(start + feed.m_chunkSize, feed.m_records.size());
+        m_position = feed.recordStart(start);
+        return true;
+    }
+
+    bool DataCursor::findRecord(std::string_view& record)
+    {
+        const DataFeed& feed = *m_feed;
+        const std::size_t size = feed.m_records.size();
+
+        switch (feed.m_mode)
+        {
+        case DataMode::Sequential:
+        case DataMode::Circular:
+        case DataMode::Unique:
+            // Records whose first byte lies in the claimed range belong to this cursor
+            while (true)
+            {
+                while (m_position < m_claimEnd)
+                {
+                    std::size_t end = feed.recordEnd(m_position);
+                    std::size_t start = m_position;
+                    m_position = feed.recordStart(end + 1);
+                    if (end > start)
+                    {
+                        record = feed.m_records.substr(start, end - start);
+                        return true;
+                    }
+                }
+
+                if (!claim())
+                {
+                    return false;
+                }
+            }
+        case DataMode::Random:
+            // A random byte offset lands in a record; its successor is taken, wrapping at the end of the file
+            {
+                std::size_t position = feed.recordStart(static_cast<std::size_t>(m_random.below(size)));
+                for (std::size_t scanned = 0; scanned <= size; ++scanned)
+                {
+                    if (position >= size)
+                    {
+                        position = 0;
+                    }
+
+                    std::size_t end = feed.recordEnd(position);
+                    if (end > position)
+                    {
+                        record = feed.m_records.substr(position, end - position);
+                        return true;
+                    }
+                    position = feed.recordStart(end + 1);
+                }
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    void DataCursor::bindCsv(std::string_view record, VariableFrame& frame)
+    {
+        const auto& bindings = m_feed->m_bindings;
+
+        std::size_t pos = 0;
+        std::string_view value;
+        for (const auto& slots : bindings)
+        {
+            bool present = nextField(record, pos, m_feed->m_delimiter, m_field, value);
+            for (VariableSlot slot : slots)
+            {
+                if (present)
+                {
+                    frame.set(slot, value);
+                }
+                else
+                {
+                    frame.unset(slot);
+                }
+            }
+        }
+    }
+
+    bool DataCursor::bindJson(std::string_view record, VariableFrame& frame)
+    {
+        auto object = nlohmann::json::parse(record, nullptr, false);
+        if (!object.is_object())
+        {
+            return false;
+        }
+
+        const auto& columns = m_feed->m_columns;
+        const auto& bindings = m_feed->m_bindings;
+        for (std::size_t column = 0; column < columns.size(); ++column)
+        {
+            if (bindings[column].empty())
+            {
+                continue;
+            }
+
+            auto it = object.find(columns[column]);
+            if (it != object.end() && !it->is_string())
+            {
+                m_field = it->dump();
+            }
+
+            for (VariableSlot slot : bindings[column])
+            {
+                if (it == object.end())
+                {
+                    frame.unset(slot);
+                }
+                else
+                {
+                    frame.set(slot, it->is_string() ? std::string_view(it->get_ref<const std::string&>()) : std::string_view(m_field));
+                }
+            }
+        }
+
+        return true;
+    }
+} // namespace zaplet::scenario
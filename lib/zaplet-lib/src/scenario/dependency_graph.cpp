@@ -0,0 +1,322 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/dependency_graph.h"
+
+#include "zaplet/scenario/condition.h"
+#include "zaplet/scenario/extractor.h"
+#include "zaplet/scenario/template.h"
+#include "zaplet/scenario/variables.h"
+
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        void collectTemplate(const std::string& source, VariableTable& table, std::set<std::string>& reads, bool json = false)
+        {
+            Template value = json ? Template::compileJson(source, table, {}) : Template::compile(source, table);
+            for (const auto& segment : value.getSegments())
+            {
+                if (segment.kind == Template::SegmentKind::Variable)
+                {
+                    reads.insert(table.getName(segment.slot));
+                }
+            }
+            for (const auto& call : value.getCalls())
+            {
+                for (const auto& argument : call.arguments)
+                {
+                    if (argument.variable)
+                    {
+                        reads.insert(table.getName(argument.slot));
+                    }
+                }
+            }
+        }
+
+        // Returns whether the condition looks at the last response rather than only at variables
+        bool collectCondition(const std::string& source, VariableTable& table, std::set<std::string>& reads)
+        {
+            Condition condition = Condition::compile(source, table);
+
+            bool readsResponse = false;
+            for (const auto& node : condition.getNodes())
+            {
+                if (node.kind == Condition::NodeKind::Variable)
+                {
+                    reads.insert(table.getName(node.slot));
+                }
+                else if (node.kind == Condition::NodeKind::Function && node.function != Condition::Function::Exists &&
+                         node.function != Condition::Function::Len)
+                {
+                    readsResponse = true;
+                }
+            }
+
+            return readsResponse;
+        }
+
+        void collectStep(const Step& step, VariableTable& table, DependencyGraph::Node& node)
+        {
+            if (step.condition.has_value() && !step.condition->empty() && collectCondition(step.condition.value(), table, node.reads))
+            {
+                node.barrier = "response condition";
+            }
+
+            if (!step.parallel.empty())
+            {
+                for (const auto& branch : step.parallel)
+                {
+                    collectStep(branch, table, node);
+                }
+                node.barrier = "parallel";
+                return;
+            }
+
+            collectTemplate(step.request.getUrl(), table, node.reads);
+            for (const auto& [name, value] : step.request.getHeaders())
+            {
+                collectTemplate(value, table, node.reads);
+            }
+            if (step.request.getBody().has_value())
+            {
+                collectTemplate(step.request.getBody().value(), table, node.reads, step.bodyJson);
+            }
+            for (const auto& [name, value] : step.request.getQueryParams())
+            {
+                collectTemplate(value, table, node.reads);
+            }
+
+            for (const auto& [varName, extractionRule] : step.variables)
+            {
+                node.writes.insert(varName);
+
+                Extractor extractor = Extractor::compile(extractionRule);
+                if (extractor.getKind() == Extractor::Kind::Regex)
+                {
+                    for (const auto& [groupName, groupIndex] : extractor.getPattern().getNamedGroups())
+                    {
+                        node.writes.insert(groupName);
+                    }
+                }
+            }
+
+            if (step.foreach.has_value())
+            {
+                collectTemplate(step.foreach.value(), table, node.reads);
+                node.writes.insert(step.itemVariable);
+            }
+            if (step.loop.has_value() || step.foreach.has_value())
+            {
+                node.writes.insert("index");
+                node.barrier = step.loop.has_value() ? "loop" : "foreach";
+            }
+            if (step.credentials.has_value())
+            {
+                node.barrier = "credentials";
+            }
+        }
+
+        void addDependency(DependencyGraph::Node& node, std::size_t from, const std::string& reason)
+        {
+            auto it = std::find_if(node.dependencies.begin(),
+                                   node.dependencies.end(),
+                                   [from](const DependencyGraph::Edge& edge) { return edge.from == from; });
+
+            if (it == node.dependencies.end())
+            {
+                node.dependencies.push_back({ from, reason });
+            }
+            else if (it->reason.find(reason) == std::string::npos)
+            {
+                it->reason += ", " + reason;
+            }
+        }
+
+        std::string escape(const std::string& value)
+        {
+            std::string result;
+            for (char c : value)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    result.push_back('\\');
+                }
+                result.push_back(c);
+            }
+            return result;
+        }
+    } // namespace
+
+    DependencyGraph DependencyGraph::build(const Scenario& scenario)
+    {
+        DependencyGraph graph;
+        graph.m_name = scenario.getName();
+
+        VariableTable table;
+        for (const auto& step : scenario.getSteps())
+        {
+            Node& node = graph.m_nodes.emplace_back();
+            node.name = step.name;
+            collectStep(step, table, node);
+        }
+
+        // A condition on the last response needs the previous step to be the last one that finished
+        for (std::size_t index = 1; index < graph.m_nodes.size(); ++index)
+        {
+            if (graph.m_nodes[index].barrier == "response condition" && graph.m_nodes[index - 1].barrier.empty())
+            {
+                graph.m_nodes[index - 1].barrier = "response read by next step";
+            }
+        }
+
+        // Steps after a barrier only need an edge to the barrier; everything before it is ordered through it
+        std::size_t segmentStart = 0;
+        std::optional<std::size_t> lastBarrier;
+
+        for (std::size_t index = 0; index < graph.m_nodes.size(); ++index)
+        {
+            Node& node = graph.m_nodes[index];
+            const Step& step = scenario.getSteps()[index];
+
+            if (lastBarrier.has_value())
+            {
+                addDependency(node, lastBarrier.value(), "barrier");
+            }
+
+            for (std::size_t earlier = segmentStart; earlier < index; ++earlier)
+            {
+                const Node& other = graph.m_nodes[earlier];
+
+                if (!node.barrier.empty())
+                {
+                    addDependency(node, earlier, "barrier");
+                    continue;
+                }
+
+                // read after write, write after read and write after write all keep their order
+                for (const auto& name : node.reads)
+                {
+                    if (other.writes.contains(name))
+                    {
+                        addDependency(node, earlier, name);
+                    }
+                }
+                for (const auto& name : node.writes)
+                {
+                    if (other.reads.contains(name) || other.writes.contains(name))
+                    {
+                        addDependency(node, earlier, name);
+                    }
+                }
+            }
+
+            for (const auto& dependency : step.dependsOn)
+            {
+                auto it = std::find_if(graph.m_nodes.rbegin() + static_cast<std::ptrdiff_t>(graph.m_nodes.size() - index),
+                                       graph.m_nodes.rend(),
+                                       [&dependency](const Node& other) { return other.name == dependency; });
+                if (it == graph.m_nodes.rend())
+                {
+                    throw std::runtime_error(std::format("Step '{}' depends on '{}', which is not an earlier step", step.name, dependency));
+                }
+
+                addDependency(node, static_cast<std::size_t>(graph.m_nodes.rend() - it - 1), "depends_on");
+            }
+
+            for (const auto& edge : node.dependencies)
+            {
+                node.level = std::max(node.level, graph.m_nodes[edge.from].level + 1);
+            }
+
+            if (!node.barrier.empty())
+            {
+                lastBarrier = index;
+                segmentStart = index + 1;
+            }
+        }
+
+        for (std::size_t index = 0; index < graph.m_nodes.size(); ++index)
+        {
+            std::size_t level = graph.m_nodes[index].level;
+            if (graph.m_levels.size() <= level)
+            {
+                graph.m_levels.resize(level + 1);
+            }
+            graph.m_levels[level].push_back(index);
+        }
+
+        return graph;
+    }
+
+    const std::vector<DependencyGraph::Node>& DependencyGraph::getNodes() const
+    {
+        return m_nodes;
+    }
+
+    const std::vector<std::vector<std::size_t>>& DependencyGraph::getLevels() const
+    {
+        return m_levels;
+    }
+
+    std::string DependencyGraph::dump() const
+    {
+        std::string out = std::format("dependency graph '{}'\n", m_name);
+        out += std::format("  {} steps on {} levels\n", m_nodes.size(), m_levels.size());
+
+        out += "\nsteps:\n";
+        for (std::size_t index = 0; index < m_nodes.size(); ++index)
+        {
+            const Node& node = m_nodes[index];
+            out += std::format(
+                "  [{}] {} (level {}{})\n", index, node.name, node.level, node.barrier.empty() ? "" : ", barrier: " + node.barrier);
+            for (const auto& edge : node.dependencies)
+            {
+                out += std::format("      after [{}] {} ({})\n", edge.from, m_nodes[edge.from].name, edge.reason);
+            }
+        }
+
+        out += "\nlevels:\n";
+        for (std::size_t level = 0; level < m_levels.size(); ++level)
+        {
+            out += std::format("  {:<4}", level);
+            for (std::size_t i = 0; i < m_levels[level].size(); ++i)
+            {
+                std::size_t index = m_levels[level][i];
+                out += std::format("{}[{}] {}", i == 0 ? "" : ", ", index, m_nodes[index].name);
+            }
+            out += "\n";
+        }
+
+        return out;
+    }
+
+    std::string DependencyGraph::toDot() const
+    {
+        std::string out = std::format("digraph \"{}\" {{\n    rankdir=LR;\n", escape(m_name));
+
+        for (std::size_t index = 0; index < m_nodes.size(); ++index)
+        {
+            const Node& node = m_nodes[index];
+            out += std::format(
+                "    s{} [label=\"{}\"{}];\n", index, escape(node.name), node.barrier.empty() ? "" : ", shape=box, style=bold");
+        }
+
+        for (std::size_t index = 0; index < m_nodes.size(); ++index)
+        {
+            for (const auto& edge : m_nodes[index].dependencies)
+            {
+                out += std::format("    s{} -> s{} [label=\"{}\"];\n", edge.from, index, escape(edge.reason));
+            }
+        }
+
+        out += "}\n";
+        return out;
+    }
+} // namespace zaplet::scenario
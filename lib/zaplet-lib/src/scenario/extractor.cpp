@@ -0,0 +1,153 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/extractor.h"
+
+#include "zaplet/logging/logger.h"
+
+#include <nlohmann/json.hpp>
+
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace zaplet::scenario
+{
+    Extractor Extractor::compile(const std::string& rule)
+    {
+        Extractor extractor;
+        extractor.m_rule = rule;
+
+        if (rule.starts_with("$"))
+        {
+            extractor.m_kind = Kind::JsonPath;
+            extractor.m_path = JsonPath::compile(rule);
+        }
+        else if (rule.starts_with("header."))
+        {
+            extractor.m_kind = Kind::Header;
+            extractor.m_argument = rule.substr(7);
+        }
+        else if (rule == "status_code")
+        {
+            extractor.m_kind = Kind::StatusCode;
+        }
+        else if (rule == "body")
+        {
+            extractor.m_kind = Kind::Body;
+        }
+        else if (rule.starts_with("regex:"))
+        {
+            extractor.m_kind = Kind::Regex;
+            extractor.m_argument = rule.substr(6);
+            extractor.m_pattern = Pattern::compile(extractor.m_argument);
+
+            if (extractor.m_pattern.getGroupCount() == 0)
+            {
+                throw std::runtime_error(std::format("Regex pattern {} has no capture group", extractor.m_argument));
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Unknown variable extraction rule: " + rule);
+        }
+
+        return extractor;
+    }
+
+    bool Extractor::extract(ResponseDocument& document, std::string& out) const
+    {
+        const http::Response& response = document.getResponse();
+
+        switch (m_kind)
+        {
+        case Kind::JsonPath:
+            {
+                const nlohmann::json* json = document.getJson();
+                if (json == nullptr)
+                {
+                    LOG_WARNING_FMT("Failed to parse response as JSON for path {}", m_rule);
+                    return false;
+                }
+
+                if (m_path.isDefinite())
+                {
+                    const nlohmann::json* node = m_path.selectFirst(*json);
+                    if (node == nullptr)
+                    {
+                        LOG_WARNING_FMT("JSON path {} not found in response", m_rule);
+                        return false;
+                    }
+
+                    out = node->is_string() ? node->get_ref<const std::string&>() : node->dump();
+                    return true;
+                }
+
+                std::vector<const nlohmann::json*> nodes;
+                m_path.select(*json, nodes);
+
+                nlohmann::json matches = nlohmann::json::array();
+                for (const auto* node : nodes)
+                {
+                    matches.push_back(*node);
+                }
+
+                out = matches.dump();
+                return true;
+            }
+        case Kind::Header:
+            {
+                const std::string* value = response.getHeaders().find(m_argument);
+                if (value == nullptr)
+                {
+                    LOG_WARNING_FMT("Header {} not found in response", m_argument);
+                    return false;
+                }
+
+                out = *value;
+                return true;
+            }
+        case Kind::StatusCode:
+            out = std::to_string(response.getStatusCode());
+            return true;
+        case Kind::Body:
+            out = response.getBody();
+            return true;
+        case Kind::Regex:
+            {
+                std::vector<std::string_view> groups;
+                if (m_pattern.search(response.getBody(), groups))
+                {
+                    out = groups[1];
+                    return true;
+                }
+
+                LOG_WARNING_FMT("Regex pattern {} did not match", m_argument);
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    Extractor::Kind Extractor::getKind() const
+    {
+        return m_kind;
+    }
+
+    const std::string& Extractor::getRule() const
+    {
+        return m_rule;
+    }
+
+    const JsonPath& Extractor::getPath() const
+    {
+        return m_path;
+    }
+
+    const Pattern& Extractor::getPattern() const
+    {
+        return m_pattern;
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,60 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/iteration_arena.h"
+
+#include <bit>
+
+namespace zaplet::scenario
+{
+    IterationArena::IterationArena(std::size_t initialBytes)
+        : m_buffer(std::make_unique_for_overwrite<std::byte[]>(initialBytes))
+        , m_capacity(initialBytes)
+    {
+        m_resource.emplace(m_buffer.get(), m_capacity, std::pmr::new_delete_resource());
+    }
+
+    void IterationArena::reset()
+    {
+        if (m_used <= m_capacity)
+        {
+            m_resource->release();
+        }
+        else
+        {
+            // headroom for the alignment padding the byte count leaves out
+            m_resource.reset();
+            m_capacity = std::bit_ceil(m_used + m_used / 4);
+            m_buffer = std::make_unique_for_overwrite<std::byte[]>(m_capacity);
+            m_resource.emplace(m_buffer.get(), m_capacity, std::pmr::new_delete_resource());
+        }
+        m_used = 0;
+    }
+
+    std::size_t IterationArena::getUsed() const
+    {
+        return m_used;
+    }
+
+    std::size_t IterationArena::getCapacity() const
+    {
+        return m_capacity;
+    }
+
+    void* IterationArena::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        m_used += bytes;
+        return m_resource->allocate(bytes, alignment);
+    }
+
+    void IterationArena::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+    {
+        m_resource->deallocate(pointer, bytes, alignment);
+    }
+
+    bool IterationArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,517 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/json_path.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        class PathParser
+        {
+        public:
+            explicit PathParser(std::string_view expression)
+                : m_expression(expression)
+            {
+            }
+
+            [[nodiscard]] bool atEnd() const
+            {
+                return m_pos >= m_expression.size();
+            }
+
+            [[nodiscard]] char peek() const
+            {
+                return atEnd() ? '\0' : m_expression[m_pos];
+            }
+
+            bool consume(char c)
+            {
+                if (peek() == c)
+                {
+                    ++m_pos;
+                    return true;
+                }
+
+                return false;
+            }
+
+            bool consume(std::string_view token)
+            {
+                if (m_expression.substr(m_pos).starts_with(token))
+                {
+                    m_pos += token.size();
+                    return true;
+                }
+
+                return false;
+            }
+
+            void expect(char c)
+            {
+                if (!consume(c))
+                {
+                    fail(std::format("expected '{}'", c));
+                }
+            }
+
+            void skipSpaces()
+            {
+                while (!atEnd() && std::isspace(static_cast<unsigned char>(peek())))
+                {
+                    ++m_pos;
+                }
+            }
+
+            std::string parseName()
+            {
+                std::size_t start = m_pos;
+                while (!atEnd())
+                {
+                    char c = peek();
+                    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+                    {
+                        break;
+                    }
+                    ++m_pos;
+                }
+
+                if (start == m_pos)
+                {
+                    fail("expected field name");
+                }
+
+                return std::string(m_expression.substr(start, m_pos - start));
+            }
+
+            std::string parseQuoted()
+            {
+                char quote = peek();
+                ++m_pos;
+
+                std::string result;
+                while (!atEnd() && peek() != quote)
+                {
+                    if (peek() == '\\' && m_pos + 1 < m_expression.size())
+                    {
+                        ++m_pos;
+                    }
+                    result.push_back(peek());
+                    ++m_pos;
+                }
+
+                expect(quote);
+                return result;
+            }
+
+            std::int64_t parseInteger()
+            {
+                std::int64_t value = 0;
+                auto begin = m_expression.data() + m_pos;
+                auto [ptr, ec] = std::from_chars(begin, m_expression.data() + m_expression.size(), value);
+                if (ec != std::errc() || ptr == begin)
+                {
+                    fail("expected array index");
+                }
+
+                m_pos += static_cast<std::size_t>(ptr - begin);
+                return value;
+            }
+
+            JsonPath::Literal parseLiteral()
+            {
+                JsonPath::Literal literal;
+
+                if (peek() == '\'' || peek() == '"')
+                {
+                    literal.type = JsonPath::Literal::Type::String;
+                    literal.string = parseQuoted();
+                }
+                else if (consume("true"))
+                {
+                    literal.type = JsonPath::Literal::Type::Boolean;
+                    literal.boolean = true;
+                }
+                else if (consume("false"))
+                {
+                    literal.type = JsonPath::Literal::Type::Boolean;
+                    literal.boolean = false;
+                }
+                else if (consume("null"))
+                {
+                    literal.type = JsonPath::Literal::Type::Null;
+                }
+                else
+                {
+                    auto begin = m_expression.data() + m_pos;
+                    auto [ptr, ec] = std::from_chars(begin, m_expression.data() + m_expression.size(), literal.number);
+                    if (ec != std::errc() || ptr == begin)
+                    {
+                        fail("expected literal");
+                    }
+
+                    literal.type = JsonPath::Literal::Type::Number;
+                    m_pos += static_cast<std::size_t>(ptr - begin);
+                }
+
+                return literal;
+            }
+
+            JsonPath::Filter parseFilter()
+            {
+                JsonPath::Filter filter;
+
+                expect('(');
+                skipSpaces();
+                expect('@');
+
+                while (true)
+                {
+                    if (consume('.'))
+                    {
+                        filter.fields.push_back(parseName());
+                    }
+                    else if (consume('['))
+                    {
+                        skipSpaces();
+                        if (peek() != '\'' && peek() != '"')
+                        {
+                            fail("expected quoted field name");
+                        }
+                        filter.fields.push_back(parseQuoted());
+                        skipSpaces();
+                        expect(']');
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                skipSpaces();
+
+                if (consume("=="))
+                {
+                    filter.op = JsonPath::FilterOp::Equal;
+                }
+                else if (consume("!="))
+                {
+                    filter.op = JsonPath::FilterOp::NotEqual;
+                }
+                else if (consume("<="))
+                {
+                    filter.op = JsonPath::FilterOp::LessEqual;
+                }
+                else if (consume(">="))
+                {
+                    filter.op = JsonPath::FilterOp::GreaterEqual;
+                }
+                else if (consume('<'))
+                {
+                    filter.op = JsonPath::FilterOp::Less;
+                }
+                else if (consume('>'))
+                {
+                    filter.op = JsonPath::FilterOp::Greater;
+                }
+                else
+                {
+                    filter.op = JsonPath::FilterOp::Exists;
+                }
+
+                if (filter.op != JsonPath::FilterOp::Exists)
+                {
+                    skipSpaces();
+                    filter.literal = parseLiteral();
+                }
+
+                skipSpaces();
+                expect(')');
+
+                return filter;
+            }
+
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::runtime_error(std::format("Invalid JSON path '{}' at position {}: {}", m_expression, m_pos, message));
+            }
+
+        private:
+            std::string_view m_expression;
+            std::size_t m_pos = 0;
+        };
+
+        bool literalEquals(const nlohmann::json& node, const JsonPath::Literal& literal)
+        {
+            switch (literal.type)
+            {
+            case JsonPath::Literal::Type::Null:
+                return node.is_null();
+            case JsonPath::Literal::Type::Boolean:
+                return node.is_boolean() && node.get<bool>() == literal.boolean;
+            case JsonPath::Literal::Type::Number:
+                return node.is_number() && node.get<double>() == literal.number;
+            case JsonPath::Literal::Type::String:
+                return node.is_string() && node.get_ref<const std::string&>() == literal.string;
+            }
+
+            return false;
+        }
+
+        // Returns <0, 0 or >0, or nullopt when the node and the literal are not ordered
+        std::optional<int> literalCompare(const nlohmann::json& node, const JsonPath::Literal& literal)
+        {
+            if (literal.type == JsonPath::Literal::Type::Number && node.is_number())
+            {
+                double value = node.get<double>();
+                return value < literal.number ? -1 : (value > literal.number ? 1 : 0);
+            }
+
+            if (literal.type == JsonPath::Literal::Type::String && node.is_string())
+            {
+                return node.get_ref<const std::string&>().compare(literal.string);
+            }
+
+            return std::nullopt;
+        }
+
+        bool matchesFilter(const nlohmann::json& candidate, const JsonPath::Filter& filter)
+        {
+            const nlohmann::json* current = &candidate;
+            for (const auto& field : filter.fields)
+            {
+                if (!current->is_object())
+                {
+                    return false;
+                }
+
+                auto it = current->find(field);
+                if (it == current->end())
+                {
+                    return false;
+                }
+
+                current = &*it;
+            }
+
+            switch (filter.op)
+            {
+            case JsonPath::FilterOp::Exists:
+                return true;
+            case JsonPath::FilterOp::Equal:
+                return literalEquals(*current, filter.literal);
+            case JsonPath::FilterOp::NotEqual:
+                return !literalEquals(*current, filter.literal);
+            default:
+                break;
+            }
+
+            auto order = literalCompare(*current, filter.literal);
+            if (!order.has_value())
+            {
+                return false;
+            }
+
+            switch (filter.op)
+            {
+            case JsonPath::FilterOp::Less:
+                return *order < 0;
+            case JsonPath::FilterOp::LessEqual:
+                return *order <= 0;
+            case JsonPath::FilterOp::Greater:
+                return *order > 0;
+            case JsonPath::FilterOp::GreaterEqual:
+                return *order >= 0;
+            default:
+                return false;
+            }
+        }
+
+        // Visits every node the path selects; the visitor returns true to stop the walk
+        template<typename Visitor>
+        bool walk(const std::vector<JsonPath::Step>& steps, const nlohmann::json& node, std::size_t stepIndex, Visitor& visit)
+        {
+            if (stepIndex == steps.size())
+            {
+                return visit(node);
+            }
+
+            const auto& step = steps[stepIndex];
+
+            switch (step.kind)
+            {
+            case JsonPath::StepKind::Field:
+                {
+                    if (!node.is_object())
+                    {
+                        return false;
+                    }
+
+                    auto it = node.find(step.field);
+                    return it != node.end() && walk(steps, *it, stepIndex + 1, visit);
+                }
+            case JsonPath::StepKind::Index:
+                {
+                    if (!node.is_array())
+                    {
+                        return false;
+                    }
+
+                    auto size = static_cast<std::int64_t>(node.size());
+                    auto index = step.index < 0 ? size + step.index : step.index;
+                    return index >= 0 && index < size && walk(steps, node[static_cast<std::size_t>(index)], stepIndex + 1, visit);
+                }
+            case JsonPath::StepKind::Wildcard:
+                {
+                    if (node.is_array() || node.is_object())
+                    {
+                        for (const auto& child : node)
+                        {
+                            if (walk(steps, child, stepIndex + 1, visit))
+                            {
+                                return true;
+                            }
+                        }
+                    }
+                    return false;
+                }
+            case JsonPath::StepKind::Filter:
+                {
+                    if (node.is_array() || node.is_object())
+                    {
+                        for (const auto& child : node)
+                        {
+                            if (matchesFilter(child, step.filter) && walk(steps, child, stepIndex + 1, visit))
+                            {
+                                return true;
+                            }
+                        }
+                    }
+                    return false;
+                }
+            }
+
+            return false;
+        }
+    } // namespace
+
+    JsonPath JsonPath::compile(std::string_view expression)
+    {
+        JsonPath path;
+        path.m_expression = std::string(expression);
+
+        PathParser parser(expression);
+        parser.expect('$');
+
+        while (!parser.atEnd())
+        {
+            Step step;
+
+            if (parser.consume('.'))
+            {
+                if (parser.peek() == '.')
+                {
+                    parser.fail("recursive descent is not supported");
+                }
+
+                if (parser.consume('*'))
+                {
+                    step.kind = StepKind::Wildcard;
+                }
+                else
+                {
+                    step.kind = StepKind::Field;
+                    step.field = parser.parseName();
+                }
+            }
+            else if (parser.consume('['))
+            {
+                parser.skipSpaces();
+
+                if (parser.consume('*'))
+                {
+                    step.kind = StepKind::Wildcard;
+                }
+                else if (parser.peek() == '\'' || parser.peek() == '"')
+                {
+                    step.kind = StepKind::Field;
+                    step.field = parser.parseQuoted();
+                }
+                else if (parser.consume('?'))
+                {
+                    step.kind = StepKind::Filter;
+                    step.filter = parser.parseFilter();
+                }
+                else
+                {
+                    step.kind = StepKind::Index;
+                    step.index = parser.parseInteger();
+                }
+
+                parser.skipSpaces();
+                parser.expect(']');
+            }
+            else
+            {
+                parser.fail("expected '.' or '['");
+            }
+
+            if (step.kind == StepKind::Wildcard || step.kind == StepKind::Filter)
+            {
+                path.m_definite = false;
+            }
+
+            path.m_steps.push_back(std::move(step));
+        }
+
+        return path;
+    }
+
+    const nlohmann::json* JsonPath::selectFirst(const nlohmann::json& root) const
+    {
+        const nlohmann::json* result = nullptr;
+        auto visit = [&result](const nlohmann::json& node)
+        {
+            result = &node;
+            return true;
+        };
+
+        walk(m_steps, root, 0, visit);
+        return result;
+    }
+
+    void JsonPath::select(const nlohmann::json& root, std::vector<const nlohmann::json*>& out) const
+    {
+        auto visit = [&out](const nlohmann::json& node)
+        {
+            out.push_back(&node);
+            return false;
+        };
+
+        walk(m_steps, root, 0, visit);
+    }
+
+    bool JsonPath::isDefinite() const
+    {
+        return m_definite;
+    }
+
+    const std::string& JsonPath::getExpression() const
+    {
+        return m_expression;
+    }
+
+    const std::vector<JsonPath::Step>& JsonPath::getSteps() const
+    {
+        return m_steps;
+    }
+} // namespace zaplet::scenario
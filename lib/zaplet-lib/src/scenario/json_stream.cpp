@@ -0,0 +1,387 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/json_stream.h"
+
+#include <nlohmann/json.hpp>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        using Key = JsonStreamSelector::Key;
+
+        class SelectorHandler
+        {
+        public:
+            SelectorHandler(const std::vector<std::vector<Key>>& paths, std::vector<std::optional<std::string>>& results)
+                : m_paths(paths)
+                , m_results(results)
+                , m_remaining(paths.size())
+            {
+                m_rootAlive.reserve(paths.size());
+                for (std::size_t i = 0; i < paths.size(); ++i)
+                {
+                    m_rootAlive.push_back(i);
+                }
+            }
+
+            [[nodiscard]] bool isComplete() const
+            {
+                return m_remaining == 0 && m_captureDepth == 0;
+            }
+
+            bool null()
+            {
+                return scalar(nullptr);
+            }
+
+            bool boolean(bool value)
+            {
+                return scalar(value);
+            }
+
+            bool number_integer(nlohmann::json::number_integer_t value)
+            {
+                return scalar(value);
+            }
+
+            bool number_unsigned(nlohmann::json::number_unsigned_t value)
+            {
+                return scalar(value);
+            }
+
+            bool number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t&)
+            {
+                return scalar(value);
+            }
+
+            bool string(nlohmann::json::string_t& value)
+            {
+                if (m_captureDepth > 0)
+                {
+                    addToCapture(value);
+                }
+
+                if (m_skipDepth > 0)
+                {
+                    return true;
+                }
+
+                std::vector<std::size_t> exact;
+                std::vector<std::size_t> deeper;
+                classify(exact, deeper);
+
+                for (auto id : exact)
+                {
+                    resolve(id, value);
+                }
+
+                return !isComplete();
+            }
+
+            bool binary(nlohmann::json::binary_t&)
+            {
+                return scalar(nullptr);
+            }
+
+            bool start_object(std::size_t)
+            {
+                return startContainer(false);
+            }
+
+            bool key(nlohmann::json::string_t& value)
+            {
+                if (m_captureDepth > 0)
+                {
+                    m_pendingKey = value;
+                }
+
+                if (m_skipDepth == 0 && !m_frames.empty())
+                {
+                    m_frames.back().key = value;
+                }
+
+                return true;
+            }
+
+            bool end_object()
+            {
+                return endContainer();
+            }
+
+            bool start_array(std::size_t)
+            {
+                return startContainer(true);
+            }
+
+            bool end_array()
+            {
+                return endContainer();
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nlohmann::json::exception&)
+            {
+                return false;
+            }
+
+        private:
+            struct Frame
+            {
+                bool isArray = false;
+                std::size_t nextIndex = 0;
+                std::string key;
+                std::vector<std::size_t> alive;
+            };
+
+            const std::vector<std::vector<Key>>& m_paths;
+            std::vector<std::optional<std::string>>& m_results;
+            std::size_t m_remaining;
+
+            std::vector<std::size_t> m_rootAlive;
+            bool m_rootSeen = false;
+            std::vector<Frame> m_frames;
+            std::size_t m_skipDepth = 0;
+
+            struct Capture
+            {
+                std::size_t depth = 0;
+                std::vector<std::size_t> ids;
+            };
+
+            nlohmann::json m_captured;
+            std::vector<nlohmann::json*> m_captureStack;
+            std::vector<Capture> m_captures;
+            std::size_t m_captureDepth = 0;
+            std::string m_pendingKey;
+
+            template<typename T>
+            bool scalar(T&& value)
+            {
+                if (m_captureDepth > 0)
+                {
+                    addToCapture(nlohmann::json(value));
+                }
+
+                if (m_skipDepth > 0)
+                {
+                    return true;
+                }
+
+                std::vector<std::size_t> exact;
+                std::vector<std::size_t> deeper;
+                classify(exact, deeper);
+
+                if (!exact.empty())
+                {
+                    std::string text = nlohmann::json(std::forward<T>(value)).dump();
+                    for (auto id : exact)
+                    {
+                        resolve(id, text);
+                    }
+                }
+
+                return !isComplete();
+            }
+
+            bool startContainer(bool isArray)
+            {
+                if (m_captureDepth > 0)
+                {
+                    nlohmann::json* container = addToCapture(isArray ? nlohmann::json::array() : nlohmann::json::object());
+                    m_captureStack.push_back(container);
+                    ++m_captureDepth;
+                }
+
+                if (m_skipDepth > 0)
+                {
+                    ++m_skipDepth;
+                    return true;
+                }
+
+                std::vector<std::size_t> exact;
+                std::vector<std::size_t> deeper;
+                classify(exact, deeper);
+
+                if (!exact.empty())
+                {
+                    if (m_captureDepth == 0)
+                    {
+                        m_captured = isArray ? nlohmann::json::array() : nlohmann::json::object();
+                        m_captureStack.assign(1, &m_captured);
+                        m_captureDepth = 1;
+                    }
+
+                    m_captures.push_back({ m_captureDepth, std::move(exact) });
+                }
+
+                if (deeper.empty())
+                {
+                    m_skipDepth = 1;
+                    return true;
+                }
+
+                m_frames.push_back({ isArray, 0, {}, std::move(deeper) });
+                return true;
+            }
+
+            bool endContainer()
+            {
+                if (m_captureDepth > 0)
+                {
+                    if (!m_captures.empty() && m_captures.back().depth == m_captureDepth)
+                    {
+                        std::string text = m_captureStack.back()->dump();
+                        for (auto id : m_captures.back().ids)
+                        {
+                            resolve(id, text);
+                        }
+                        m_captures.pop_back();
+                    }
+
+                    m_captureStack.pop_back();
+                    --m_captureDepth;
+                }
+
+                if (m_skipDepth > 0)
+                {
+                    --m_skipDepth;
+                }
+                else if (!m_frames.empty())
+                {
+                    m_frames.pop_back();
+                }
+
+                return !isComplete();
+            }
+
+            // Splits the unresolved paths alive at the current position into those ending at this value and those continuing below it
+            void classify(std::vector<std::size_t>& exact, std::vector<std::size_t>& deeper)
+            {
+                if (m_frames.empty())
+                {
+                    if (m_rootSeen)
+                    {
+                        return;
+                    }
+
+                    m_rootSeen = true;
+                    for (auto id : m_rootAlive)
+                    {
+                        if (m_results[id].has_value())
+                        {
+                            continue;
+                        }
+
+                        (m_paths[id].empty() ? exact : deeper).push_back(id);
+                    }
+                    return;
+                }
+
+                Frame& frame = m_frames.back();
+                std::size_t depth = m_frames.size() - 1;
+                std::size_t index = frame.isArray ? frame.nextIndex++ : 0;
+
+                for (auto id : frame.alive)
+                {
+                    if (m_results[id].has_value())
+                    {
+                        continue;
+                    }
+
+                    const Key& expected = m_paths[id][depth];
+                    bool matches = frame.isArray ? (expected.isIndex && expected.index == index)
+                                                 : (!expected.isIndex && expected.field == frame.key);
+                    if (!matches)
+                    {
+                        continue;
+                    }
+
+                    (m_paths[id].size() == depth + 1 ? exact : deeper).push_back(id);
+                }
+            }
+
+            nlohmann::json* addToCapture(nlohmann::json value)
+            {
+                nlohmann::json* parent = m_captureStack.back();
+                if (parent->is_array())
+                {
+                    parent->push_back(std::move(value));
+                    return &parent->back();
+                }
+
+                auto& slot = (*parent)[m_pendingKey];
+                slot = std::move(value);
+                return &slot;
+            }
+
+            void resolve(std::size_t id, const std::string& text)
+            {
+                if (!m_results[id].has_value())
+                {
+                    m_results[id] = text;
+                    --m_remaining;
+                }
+            }
+        };
+    } // namespace
+
+    bool JsonStreamSelector::supports(const JsonPath& path)
+    {
+        for (const auto& step : path.getSteps())
+        {
+            if (step.kind == JsonPath::StepKind::Field)
+            {
+                continue;
+            }
+
+            if (step.kind == JsonPath::StepKind::Index && step.index >= 0)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        return true;
+    }
+
+    std::size_t JsonStreamSelector::addPath(const JsonPath& path)
+    {
+        std::vector<Key> keys;
+        for (const auto& step : path.getSteps())
+        {
+            if (step.kind == JsonPath::StepKind::Index)
+            {
+                keys.push_back({ true, static_cast<std::size_t>(step.index), {} });
+            }
+            else
+            {
+                keys.push_back({ false, 0, step.field });
+            }
+        }
+
+        m_paths.push_back(std::move(keys));
+        return m_paths.size() - 1;
+    }
+
+    std::size_t JsonStreamSelector::size() const
+    {
+        return m_paths.size();
+    }
+
+    bool JsonStreamSelector::select(std::string_view text, std::vector<std::optional<std::string>>& results) const
+    {
+        results.assign(m_paths.size(), std::nullopt);
+        if (m_paths.empty())
+        {
+            return true;
+        }
+
+        SelectorHandler handler(m_paths, results);
+        bool parsed = nlohmann::json::sax_parse(text.begin(), text.end(), &handler);
+
+        return parsed || handler.isComplete();
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,496 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // The entry to merge the stats of the label into. Instances filled by one program agree on positions, which are
+        // tried first; those of different programs, as the flows of a mix, are matched by label instead.
+        template <typename Stats>
+        Stats& entryFor(std::vector<Stats>& entries, std::size_t index, const std::string& label, std::string Stats::* key)
+        {
+            if (index < entries.size() && entries[index].*key == label)
+            {
+                return entries[index];
+            }
+            if (auto found = std::ranges::find(entries, label, key); found != entries.end())
+            {
+                return *found;
+            }
+
+            if (entries.size() <= index)
+            {
+                entries.resize(index + 1);
+            }
+            if (!(entries[index].*key).empty())
+            {
+                index = entries.size();
+                entries.emplace_back();
+            }
+            entries[index].*key = label;
+            return entries[index];
+        }
+    } // namespace
+
+    void Metrics::recordRequest(std::chrono::milliseconds latency, bool success)
+    {
+        auto value = static_cast<std::uint64_t>(std::max<std::chrono::milliseconds::rep>(latency.count(), 0));
+
+        ++m_requests;
+        if (!success)
+        {
+            ++m_failedRequests;
+        }
+        m_latencyTotal += value;
+        m_latencyMax = std::max(m_latencyMax, value);
+        ++m_histogram[bucketOf(value)];
+    }
+
+    void Metrics::recordHttpCache(std::size_t index, const std::string& step, http::CacheStatus status)
+    {
+        if (status == http::CacheStatus::None)
+        {
+            return;
+        }
+        if (m_httpCache.size() <= index)
+        {
+            m_httpCache.resize(index + 1);
+        }
+
+        HttpCacheStats& stats = m_httpCache[index];
+        if (stats.step.empty())
+        {
+            stats.step = step;
+        }
+        switch (status)
+        {
+        case http::CacheStatus::Hit:
+            ++stats.hits;
+            break;
+        case http::CacheStatus::Revalidated:
+            ++stats.revalidations;
+            break;
+        default:
+            ++stats.misses;
+            break;
+        }
+    }
+
+    void Metrics::recordIteration(bool success)
+    {
+        ++m_iterations;
+        if (!success)
+        {
+            ++m_failedIterations;
+        }
+    }
+
+    void Metrics::recordRateLimitWait(std::chrono::nanoseconds wait)
+    {
+        ++m_rateLimitWaits;
+        m_rateLimitWaitTime += wait;
+        m_rateLimitWaitMax = std::max(m_rateLimitWaitMax, wait);
+    }
+
+    void Metrics::recordRateLimitSkip()
+    {
+        ++m_rateLimitSkips;
+    }
+
+    void Metrics::recordCacheHit()
+    {
+        ++m_cacheHits;
+    }
+
+    void Metrics::recordBurst(std::uint64_t round, std::chrono::nanoseconds offset, std::chrono::milliseconds latency)
+    {
+        m_bursts.push_back({ round, offset, static_cast<std::uint64_t>(std::max<std::chrono::milliseconds::rep>(latency.count(), 0)) });
+    }
+
+    void Metrics::recordTarget(std::size_t index, const std::string& label, std::chrono::milliseconds latency, bool success)
+    {
+        if (m_targets.size() <= index)
+        {
+            m_targets.resize(index + 1);
+        }
+
+        TargetStats& target = m_targets[index];
+        if (target.label.empty())
+        {
+            target.label = label;
+        }
+
+        auto value = static_cast<std::uint64_t>(std::max<std::chrono::milliseconds::rep>(latency.count(), 0));
+        ++target.requests;
+        if (!success)
+        {
+            ++target.failed;
+        }
+        target.latencyTotal += value;
+        target.latencyMax = std::max(target.latencyMax, value);
+    }
+
+    void Metrics::recordStage(Stage stage, std::chrono::nanoseconds service, std::chrono::nanoseconds wait)
+    {
+        StageStats& stats = m_stages[static_cast<std::size_t>(stage)];
+        ++stats.jobs;
+        stats.serviceTotal += service;
+        stats.serviceMax = std::max(stats.serviceMax, service);
+        stats.waitTotal += wait;
+    }
+
+    void Metrics::recordQueue(Stage stage, std::size_t depth, bool overflow)
+    {
+        StageStats& stats = m_stages[static_cast<std::size_t>(stage)];
+        stats.depthTotal += depth;
+        stats.depthMax = std::max<std::uint64_t>(stats.depthMax, depth);
+        if (overflow)
+        {
+            ++stats.overflows;
+        }
+    }
+
+    void Metrics::recordLateFailures(std::uint64_t count)
+    {
+        m_failedRequests += count;
+    }
+
+    void Metrics::merge(const Metrics& other)
+    {
+        m_requests += other.m_requests;
+        m_failedRequests += other.m_failedRequests;
+        m_iterations += other.m_iterations;
+        m_failedIterations += other.m_failedIterations;
+        m_latencyTotal += other.m_latencyTotal;
+        m_latencyMax = std::max(m_latencyMax, other.m_latencyMax);
+        for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            m_histogram[bucket] += other.m_histogram[bucket];
+        }
+        m_rateLimitWaits += other.m_rateLimitWaits;
+        m_rateLimitWaitTime += other.m_rateLimitWaitTime;
+        m_rateLimitWaitMax = std::max(m_rateLimitWaitMax, other.m_rateLimitWaitMax);
+        m_rateLimitSkips += other.m_rateLimitSkips;
+        m_cacheHits += other.m_cacheHits;
+        m_bursts.insert(m_bursts.end(), other.m_bursts.begin(), other.m_bursts.end());
+        for (std::size_t stage = 0; stage < m_stages.size(); ++stage)
+        {
+            const StageStats& from = other.m_stages[stage];
+            StageStats& into = m_stages[stage];
+            into.jobs += from.jobs;
+            into.serviceTotal += from.serviceTotal;
+            into.serviceMax = std::max(into.serviceMax, from.serviceMax);
+            into.waitTotal += from.waitTotal;
+            into.depthTotal += from.depthTotal;
+            into.depthMax = std::max(into.depthMax, from.depthMax);
+            into.overflows += from.overflows;
+        }
+
+        for (std::size_t index = 0; index < other.m_httpCache.size(); ++index)
+        {
+            const HttpCacheStats& from = other.m_httpCache[index];
+            if (from.step.empty())
+            {
+                continue;
+            }
+
+            HttpCacheStats& into = entryFor(m_httpCache, index, from.step, &HttpCacheStats::step);
+            into.hits += from.hits;
+            into.revalidations += from.revalidations;
+            into.misses += from.misses;
+        }
+
+        for (std::size_t index = 0; index < other.m_targets.size(); ++index)
+        {
+            const TargetStats& from = other.m_targets[index];
+            if (from.label.empty())
+            {
+                continue;
+            }
+
+            TargetStats& into = entryFor(m_targets, index, from.label, &TargetStats::label);
+            into.requests += from.requests;
+            into.failed += from.failed;
+            into.latencyTotal += from.latencyTotal;
+            into.latencyMax = std::max(into.latencyMax, from.latencyMax);
+        }
+    }
+
+    void Metrics::reset()
+    {
+        *this = Metrics();
+    }
+
+    std::uint64_t Metrics::getRequests() const
+    {
+        return m_requests;
+    }
+
+    std::uint64_t Metrics::getFailedRequests() const
+    {
+        return m_failedRequests;
+    }
+
+    std::uint64_t Metrics::getIterations() const
+    {
+        return m_iterations;
+    }
+
+    std::uint64_t Metrics::getFailedIterations() const
+    {
+        return m_failedIterations;
+    }
+
+    double Metrics::getMeanLatency() const
+    {
+        return m_requests == 0 ? 0.0 : static_cast<double>(m_latencyTotal) / static_cast<double>(m_requests);
+    }
+
+    std::uint64_t Metrics::getMaxLatency() const
+    {
+        return m_latencyMax;
+    }
+
+    std::uint64_t Metrics::getLatencyPercentile(double fraction) const
+    {
+        if (m_requests == 0)
+        {
+            return 0;
+        }
+
+        auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(m_requests)));
+        rank = std::max<std::uint64_t>(rank, 1);
+
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            seen += m_histogram[bucket];
+            if (seen >= rank)
+            {
+                return std::min(bucketValue(bucket), m_latencyMax);
+            }
+        }
+
+        return m_latencyMax;
+    }
+
+    std::uint64_t Metrics::getRateLimitWaits() const
+    {
+        return m_rateLimitWaits;
+    }
+
+    std::chrono::nanoseconds Metrics::getRateLimitWaitTime() const
+    {
+        return m_rateLimitWaitTime;
+    }
+
+    std::uint64_t Metrics::getRateLimitSkips() const
+    {
+        return m_rateLimitSkips;
+    }
+
+    std::uint64_t Metrics::getCacheHits() const
+    {
+        return m_cacheHits;
+    }
+
+    std::chrono::nanoseconds Metrics::getMaxSendSkew() const
+    {
+        auto skews = sendSkews();
+        return skews.empty() ? std::chrono::nanoseconds(0) : *std::ranges::max_element(skews);
+    }
+
+    const std::vector<Metrics::TargetStats>& Metrics::getTargets() const
+    {
+        return m_targets;
+    }
+
+    const std::vector<Metrics::HttpCacheStats>& Metrics::getHttpCache() const
+    {
+        return m_httpCache;
+    }
+
+    const Metrics::StageStats& Metrics::getStage(Stage stage) const
+    {
+        return m_stages[static_cast<std::size_t>(stage)];
+    }
+
+    std::vector<std::chrono::nanoseconds> Metrics::sendSkews() const
+    {
+        std::vector<BurstSend> sends = m_bursts;
+        std::ranges::sort(sends, {}, &BurstSend::round);
+
+        std::vector<std::chrono::nanoseconds> skews;
+        for (auto first = sends.begin(); first != sends.end();)
+        {
+            auto last = std::find_if(first, sends.end(), [round = first->round](const BurstSend& send) { return send.round != round; });
+            auto [earliest, latest] = std::minmax_element(
+                first, last, [](const BurstSend& left, const BurstSend& right) { return left.offset < right.offset; });
+            skews.push_back(latest->offset - earliest->offset);
+            first = last;
+        }
+        return skews;
+    }
+
+    std::string Metrics::format(const std::string& title, std::chrono::milliseconds elapsed) const
+    {
+        double seconds = std::max(static_cast<double>(elapsed.count()) / 1000.0, 0.001);
+        double errorRate = m_requests == 0 ? 0.0 : 100.0 * static_cast<double>(m_failedRequests) / static_cast<double>(m_requests);
+
+        std::string out = std::format("{}\n", title);
+        out += std::format("  iterations  {} ({} failed)\n", m_iterations, m_failedIterations);
+        out += std::format("  requests    {} ({} failed, {:.1f}%), {:.1f}/s\n",
+                           m_requests,
+                           m_failedRequests,
+                           errorRate,
+                           static_cast<double>(m_requests) / seconds);
+        out += std::format("  latency ms  mean {:.1f}, p50 {}, p90 {}, p99 {}, max {}\n",
+                           getMeanLatency(),
+                           getLatencyPercentile(0.5),
+                           getLatencyPercentile(0.9),
+                           getLatencyPercentile(0.99),
+                           m_latencyMax);
+
+        if (m_rateLimitWaits > 0 || m_rateLimitSkips > 0)
+        {
+            using Milliseconds = std::chrono::duration<double, std::milli>;
+            double meanWait =
+                m_rateLimitWaits == 0 ? 0.0 : Milliseconds(m_rateLimitWaitTime).count() / static_cast<double>(m_rateLimitWaits);
+            out += std::format("  rate limit  {} waited, mean {:.1f} ms, max {:.1f} ms; {} skipped\n",
+                               m_rateLimitWaits,
+                               meanWait,
+                               Milliseconds(m_rateLimitWaitMax).count(),
+                               m_rateLimitSkips);
+        }
+
+        if (m_cacheHits > 0)
+        {
+            out += std::format("  cache       {} hits, {:.1f}% of step requests not sent\n",
+                               m_cacheHits,
+                               100.0 * static_cast<double>(m_cacheHits) / static_cast<double>(m_cacheHits + m_requests));
+        }
+
+        if (!m_bursts.empty())
+        {
+            auto skews = sendSkews();
+            std::chrono::nanoseconds skewTotal{ 0 };
+            for (auto skew : skews)
+            {
+                skewTotal += skew;
+            }
+
+            std::vector<std::uint64_t> latencies;
+            for (const auto& send : m_bursts)
+            {
+                latencies.push_back(send.latency);
+            }
+            std::ranges::sort(latencies);
+            auto percentile = [&latencies](double fraction)
+            {
+                auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(latencies.size())));
+                return latencies[std::max<std::size_t>(rank, 1) - 1];
+            };
+
+            out += std::format("  burst       {} rounds, {} sends, send skew us mean {:.1f}, max {:.1f}\n",
+                               skews.size(),
+                               m_bursts.size(),
+                               static_cast<double>(skewTotal.count()) / 1000.0 / static_cast<double>(skews.size()),
+                               static_cast<double>(getMaxSendSkew().count()) / 1000.0);
+            out += std::format("  burst ms    p50 {}, p90 {}, p99 {}, max {}\n",
+                               percentile(0.5),
+                               percentile(0.9),
+                               percentile(0.99),
+                               latencies.back());
+        }
+
+        for (const auto& stats : m_httpCache)
+        {
+            std::uint64_t total = stats.hits + stats.revalidations + stats.misses;
+            if (total == 0)
+            {
+                continue;
+            }
+            auto share = [total](std::uint64_t count) { return 100.0 * static_cast<double>(count) / static_cast<double>(total); };
+            out += std::format("  http cache  {}: {:.1f}% hit, {:.1f}% revalidated, {:.1f}% missed of {}\n",
+                               stats.step,
+                               share(stats.hits),
+                               share(stats.revalidations),
+                               share(stats.misses),
+                               total);
+        }
+
+        // Without a response pipeline everything happens on the request thread and the stages are not reported
+        if (const StageStats& process = getStage(Stage::Process); process.jobs > 0)
+        {
+            using Milliseconds = std::chrono::duration<double, std::milli>;
+            auto mean = [](std::chrono::nanoseconds total, std::uint64_t count)
+            { return count == 0 ? 0.0 : Milliseconds(total).count() / static_cast<double>(count); };
+
+            const StageStats& respond = getStage(Stage::Respond);
+            out += std::format("  stage       respond: {}, mean {:.2f} ms, max {:.2f} ms\n",
+                               respond.jobs,
+                               mean(respond.serviceTotal, respond.jobs),
+                               Milliseconds(respond.serviceMax).count());
+            out += std::format("  stage       process: {}, mean {:.2f} ms, max {:.2f} ms, waited {:.2f} ms, "
+                               "queue mean {:.1f}, max {}, {} inline\n",
+                               process.jobs,
+                               mean(process.serviceTotal, process.jobs),
+                               Milliseconds(process.serviceMax).count(),
+                               mean(process.waitTotal, process.jobs),
+                               static_cast<double>(process.depthTotal) / static_cast<double>(process.jobs),
+                               process.depthMax,
+                               process.overflows);
+        }
+
+        for (const auto& target : m_targets)
+        {
+            if (target.requests == 0)
+            {
+                continue;
+            }
+            out += std::format("  target      {}: {} ({} failed), mean {:.1f} ms, max {}\n",
+                               target.label,
+                               target.requests,
+                               target.failed,
+                               static_cast<double>(target.latencyTotal) / static_cast<double>(target.requests),
+                               target.latencyMax);
+        }
+        return out;
+    }
+
+    std::size_t Metrics::bucketOf(std::uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return static_cast<std::size_t>(value);
+        }
+
+        // The top SUB_BUCKET_BITS + 1 bits of the value pick the bucket
+        auto exponent = static_cast<std::size_t>(std::bit_width(value)) - 1;
+        std::size_t shift = exponent - SUB_BUCKET_BITS;
+        auto sub = static_cast<std::size_t>((value >> shift) & (SUB_BUCKETS - 1));
+        return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+    }
+
+    std::uint64_t Metrics::bucketValue(std::size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+        {
+            return bucket;
+        }
+
+        std::size_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+        std::size_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+        // Upper edge of the bucket, so that percentiles never under-report
+        return ((static_cast<std::uint64_t>(SUB_BUCKETS + sub + 1)) << shift) - 1;
+    }
+} // namespace zaplet::scenario
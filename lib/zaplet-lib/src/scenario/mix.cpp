@@ -0,0 +1,82 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/mix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    std::vector<std::size_t> Mix::allocate(std::size_t total) const
+    {
+        std::vector<std::size_t> result(entries.size(), 0);
+
+        std::size_t fixed = 0;
+        double weights = 0.0;
+        std::size_t weighted = 0;
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].virtualUsers.has_value())
+            {
+                result[i] = entries[i].virtualUsers.value();
+                fixed += result[i];
+            }
+            else
+            {
+                weights += entries[i].weight;
+                ++weighted;
+            }
+        }
+
+        if (weighted == 0)
+        {
+            return result;
+        }
+
+        if (total < fixed + weighted)
+        {
+            throw std::runtime_error(std::format(
+                "Mix '{}' needs at least {} virtual users: {} fixed and one per weighted scenario", name, fixed + weighted, fixed));
+        }
+
+        // Largest remainder split of the weighted virtual users, then every weighted scenario gets at least one
+        std::size_t available = total - fixed;
+        std::vector<std::pair<double, std::size_t>> fractions;
+        std::size_t assigned = 0;
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].virtualUsers.has_value())
+            {
+                continue;
+            }
+
+            double share = weights > 0.0 ? static_cast<double>(available) * entries[i].weight / weights : 0.0;
+            result[i] = static_cast<std::size_t>(std::floor(share));
+            assigned += result[i];
+            fractions.emplace_back(share - std::floor(share), i);
+        }
+
+        std::ranges::sort(fractions, std::greater<>());
+        for (std::size_t i = 0; assigned < available && i < fractions.size(); ++i, ++assigned)
+        {
+            ++result[fractions[i].second];
+        }
+
+        for (const auto& [fraction, index] : fractions)
+        {
+            if (result[index] == 0)
+            {
+                auto largest = std::ranges::max_element(
+                    fractions, [&result](const auto& a, const auto& b) { return result[a.second] < result[b.second]; });
+                --result[largest->second];
+                result[index] = 1;
+            }
+        }
+
+        return result;
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,105 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/pattern.h"
+
+#include <re2/re2.h>
+
+#include <format>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    Pattern Pattern::compile(const std::string& pattern)
+    {
+        RE2::Options options;
+        options.set_log_errors(false);
+
+        auto regex = std::make_shared<const re2::RE2>(pattern, options);
+        if (!regex->ok())
+        {
+            throw std::runtime_error(std::format("Invalid regex '{}': {}", pattern, regex->error()));
+        }
+
+        Pattern result;
+        result.m_source = pattern;
+        result.m_regex = std::move(regex);
+
+        for (const auto& [name, index] : result.m_regex->NamedCapturingGroups())
+        {
+            result.m_namedGroups.emplace_back(name, static_cast<std::size_t>(index));
+        }
+
+        return result;
+    }
+
+    bool Pattern::search(std::string_view text, std::vector<std::string_view>& groups) const
+    {
+        return match(text, false, groups);
+    }
+
+    bool Pattern::fullMatch(std::string_view text, std::vector<std::string_view>& groups) const
+    {
+        return match(text, true, groups);
+    }
+
+    bool Pattern::contains(std::string_view text) const
+    {
+        if (!m_regex)
+        {
+            return false;
+        }
+
+        return m_regex->Match(absl::string_view(text.data(), text.size()), 0, text.size(), RE2::UNANCHORED, nullptr, 0);
+    }
+
+    const std::string& Pattern::getSource() const
+    {
+        return m_source;
+    }
+
+    std::size_t Pattern::getGroupCount() const
+    {
+        return m_regex ? static_cast<std::size_t>(m_regex->NumberOfCapturingGroups()) : 0;
+    }
+
+    const std::vector<std::pair<std::string, std::size_t>>& Pattern::getNamedGroups() const
+    {
+        return m_namedGroups;
+    }
+
+    bool Pattern::match(std::string_view text, bool anchored, std::vector<std::string_view>& groups) const
+    {
+        if (!m_regex)
+        {
+            return false;
+        }
+
+        thread_local std::vector<absl::string_view> submatches;
+
+        std::size_t count = getGroupCount() + 1;
+        submatches.assign(count, absl::string_view());
+
+        bool matched = m_regex->Match(
+            absl::string_view(text.data(), text.size()),
+            0,
+            text.size(),
+            anchored ? RE2::ANCHOR_BOTH : RE2::UNANCHORED,
+            submatches.data(),
+            static_cast<int>(count));
+
+        if (!matched)
+        {
+            return false;
+        }
+
+        groups.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            groups[i] = std::string_view(submatches[i].data(), submatches[i].size());
+        }
+
+        return true;
+    }
+} // namespace zaplet::scenario
@@ -5,33 +5,85 @@
 #include "zaplet/scenario/player.h"
 
 #include "zaplet/logging/logger.h"
+#include "zaplet/scenario/random.h"
 #include "zaplet/scenario/yaml_parser.h"
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
-#include <regex>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <utility>
 
 namespace zaplet::scenario
 {
+    namespace
+    {
+        // How long a virtual user waits between looks at a credential another one is logging in for
+        constexpr std::chrono::milliseconds CREDENTIAL_POLL_INTERVAL{ 1 };
+
+        // Stream of the think time generator, derived from the seed of the virtual user
+        constexpr std::uint64_t THINK_TIME_STREAM = 0x7468696e6b;
+    } // namespace
+
     Player::Player(std::shared_ptr<http::Client> client, std::shared_ptr<output::Formatter> formatter)
         : m_client(std::move(client))
         , m_formatter(std::move(formatter))
     {
     }
 
+    Player::Lane::~Lane()
+    {
+        if (worker.joinable())
+        {
+            state.wait(BranchState::Busy, std::memory_order_acquire);
+            state.store(BranchState::Stop, std::memory_order_release);
+            state.notify_one();
+        }
+    }
+
     bool Player::play(const Scenario& scenario)
     {
-        LOG_INFO_FMT("Starting scenario: {}", scenario.getName());
-        LOG_INFO_FMT("Description: {}", scenario.getDescription());
+        return play(std::make_shared<const Program>(Program::compile(scenario)));
+    }
+
+    bool Player::play(std::shared_ptr<const Program> program)
+    {
+        prepare(std::move(program));
+
+        // Run-scope phases belong to the runner once it handed out the setup variables
+        bool ownsSetup = m_sharedVariables == nullptr || m_program->getSection(Program::Phase::Setup).scope == PhaseScope::VirtualUser;
+        bool ownsTeardown =
+            m_sharedVariables == nullptr || m_program->getSection(Program::Phase::Teardown).scope == PhaseScope::VirtualUser;
+
+        if (m_sharedVariables != nullptr)
+        {
+            for (const auto& [slot, value] : *m_sharedVariables)
+            {
+                m_frame.set(slot, value);
+            }
+        }
+
+        LOG_INFO_FMT("Starting scenario: {}", m_program->getName());
+        LOG_INFO_FMT("Description: {}", m_program->getDescription());
 
-        m_variables = scenario.getEnvironment();
+        if (ownsSetup && !runPhase(Program::Phase::Setup))
+        {
+            LOG_ERROR_FMT("Setup of scenario '{}' failed, skipping its steps", m_program->getName());
+            if (m_burst != nullptr)
+            {
+                m_burst->leave(m_abort);
+            }
+            return false;
+        }
 
         int iterations = 1;
-        if (scenario.getRepeatCount().has_value())
+        if (m_program->getRepeatCount().has_value())
         {
-            iterations = scenario.getRepeatCount().value();
+            iterations = m_program->getRepeatCount().value();
             LOG_INFO_FMT("Will repeat scenario {} times", iterations);
         }
         else
@@ -40,402 +92,1200 @@ namespace zaplet::scenario
             iterations = std::numeric_limits<int>::max();
         }
 
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (m_program->getDuration().has_value())
+        {
+            deadline = std::chrono::steady_clock::now() + m_program->getDuration().value();
+            LOG_INFO_FMT("Will start no new iteration after {} ms", m_program->getDuration()->count());
+        }
+
+        // Paced virtual users start at random offsets within one interval instead of all at once
+        auto pacing = m_program->getPacing();
+        if (pacing.has_value() && m_virtualUsers > 1)
+        {
+            pause(std::chrono::milliseconds(m_random.below(static_cast<std::uint64_t>(pacing->count()))));
+        }
+
         bool success = true;
         for (int i = 0; i < iterations; ++i)
         {
+            auto iterationStart = std::chrono::steady_clock::now();
+
+            if (m_drain.stop_requested() || std::chrono::steady_clock::now() >= deadline)
+            {
+                LOG_INFO_FMT("Virtual user {} stops after {} iterations", m_virtualUser + 1, i);
+                break;
+            }
+
+            if (!bindData())
+            {
+                break;
+            }
+
+            resetScratch();
             LOG_INFO_FMT("Starting iteration {}", i + 1);
 
-            for (const auto& step : scenario.getSteps())
+            bool iterationSuccess = m_burst != nullptr ? runBurst() : runSection(m_program->getSection(Program::Phase::Main));
+            // a response still in the pipeline counts against the iteration that finds it failed
+            iterationSuccess = collectPipeline(false) && iterationSuccess;
+            if (m_abort.stop_requested())
             {
-                if (step.delay.has_value())
-                {
-                    LOG_DEBUG_FMT("Waiting for {} ms before executing step '{}'", step.delay.value().count(), step.name);
-                    std::this_thread::sleep_for(step.delay.value());
-                }
+                LOG_WARNING_FMT("Iteration {} of virtual user {} was interrupted", i + 1, m_virtualUser + 1);
+                break;
+            }
+
+            m_metrics.recordIteration(iterationSuccess);
+            if (!iterationSuccess)
+            {
+                success = false;
 
-                if (step.condition.has_value() && !evaluateCondition(step.condition))
+                if (!m_program->getContinueOnError())
                 {
-                    LOG_INFO_FMT("Skipping step '{}' because condition is false", step.name);
-                    continue;
+                    LOG_ERROR("Stopping scenario due to error");
+                    break;
                 }
+            }
 
-                LOG_INFO_FMT("Executing step: {}", step.name);
-                LOG_INFO_FMT("Step description: {}", step.description);
-                bool stepSuccess = executeStep(step);
+            LOG_INFO_FMT("Completed iteration {}", i + 1);
 
-                if (!stepSuccess)
+            // Burst rounds are spaced by the barrier
+            if (i < iterations - 1 && m_burst == nullptr)
+            {
+                if (pacing.has_value())
                 {
-                    LOG_ERROR_FMT("Step '{}' failed", step.name);
-                    success = false;
-
-                    if (!scenario.getContinueOnError())
+                    auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(std::chrono::steady_clock::now() - iterationStart);
+                    if (elapsed >= pacing.value())
                     {
-                        LOG_ERROR("Stopping scenario due to error");
-                        return false;
+                        LOG_DEBUG_FMT("Iteration {} took {} ms, longer than its pacing interval", i + 1, elapsed.count());
                     }
+                    pause(std::max(pacing.value() - elapsed, std::chrono::milliseconds(0)));
+                }
+                else
+                {
+                    pause(m_program->getThinkTime().sample(m_random));
                 }
             }
+        }
 
-            LOG_INFO_FMT("Completed iteration {}", i + 1);
+        if (m_burst != nullptr)
+        {
+            m_burst->leave(m_abort);
+        }
+        if (!collectPipeline(true))
+        {
+            success = false;
+        }
 
-            if (i < iterations - 1)
-            {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
+        if (ownsTeardown && !m_abort.stop_requested() && !runPhase(Program::Phase::Teardown))
+        {
+            success = false;
+        }
+
+        for (const auto& lane : m_lanes)
+        {
+            m_metrics.merge(lane.metrics);
+        }
+        if (m_sink != nullptr)
+        {
+            std::lock_guard lock(m_sink->mutex);
+            m_metrics.merge(m_sink->metrics);
         }
 
-        LOG_INFO_FMT("Scenario '{}' completed with {}", scenario.getName(), success ? "success" : "failures");
+        LOG_INFO_FMT("Scenario '{}' completed with {}", m_program->getName(), success ? "success" : "failures");
         return success;
     }
 
-    bool Player::playFile(const std::string& filePath)
+    bool Player::runSetup(std::shared_ptr<const Program> program)
     {
-        try
+        prepare(std::move(program));
+        if (m_program->getSection(Program::Phase::Setup).scope != PhaseScope::Run)
         {
-            YamlParser parser;
-            Scenario scenario = parser.parseFile(filePath);
-            return play(scenario);
-        } catch (const std::exception& e)
+            return true;
+        }
+        return runPhase(Program::Phase::Setup);
+    }
+
+    bool Player::runTeardown()
+    {
+        if (m_program->getSection(Program::Phase::Teardown).scope != PhaseScope::Run)
         {
-            LOG_ERROR_FMT("Failed to play scenario file {}: {}", filePath, e.what());
-            return false;
+            return true;
         }
+        return runPhase(Program::Phase::Teardown);
     }
 
-    bool Player::executeStep(const Step& step)
+    Player::SharedVariables Player::getSharedVariables() const
     {
-        try
+        auto variables = std::make_shared<std::vector<std::pair<VariableSlot, std::string>>>();
+        for (VariableSlot slot : m_program->getSharedSlots())
         {
-            http::Request processedRequest = replaceVariablesInRequest(step.request);
+            if (m_frame.has(slot))
+            {
+                variables->emplace_back(slot, m_frame.get(slot));
+            }
+        }
+        return variables;
+    }
 
-            LOG_DEBUG_FMT("Executing {} request to {}", processedRequest.getMethod(), processedRequest.getUrl());
-            auto response = m_client->execute(processedRequest);
+    void Player::setSharedVariables(SharedVariables variables)
+    {
+        m_sharedVariables = std::move(variables);
+    }
 
-            extractVariables(step, response);
+    void Player::prepare(std::shared_ptr<const Program> program)
+    {
+        m_program = std::move(program);
+        m_frame = m_program->createFrame();
+        Random::local().seed(Random::mix(m_program->getSeed(), m_virtualUser));
+        m_random.seed(Random::mix(Random::mix(m_program->getSeed(), m_virtualUser), THINK_TIME_STREAM));
+        m_cached.assign(m_program->getCaches().size(), nullptr);
+        m_httpCache.reset();
+        if (const auto& policy = m_program->getHttpCache())
+        {
+            m_httpCache = std::make_unique<http::ResponseCache>(policy->maxEntries, policy->maxBytes);
+        }
+
+        m_cursors.clear();
+        for (const auto& feed : m_program->getData())
+        {
+            m_cursors.push_back(feed->createCursor(m_virtualUser, m_virtualUsers));
+        }
+
+        m_loops.clear();
+        m_lanes.clear();
+        m_lanes.emplace_back();
+        for (std::size_t i = 0; i < m_program->getParallelWidth(); ++i)
+        {
+            m_lanes.emplace_back().deferred = true;
+        }
+        m_loops.reserve(m_program->getLoops().size());
+        for (std::size_t i = 0; i < m_program->getLoops().size(); ++i)
+        {
+            m_loops.emplace_back(&m_lanes.front().arena);
+        }
+        m_last = nullptr;
+        m_metrics.reset();
+        m_sink = m_pipeline != nullptr ? std::make_shared<ResponsePipeline::Sink>() : nullptr;
 
-            bool validationResult = true;
-            if (step.expectedResponse.has_value())
+        m_requests.assign(m_program->getSteps().size(), http::Request());
+        for (std::size_t i = 0; i < m_requests.size(); ++i)
+        {
+            const auto& step = m_program->getSteps()[i];
+            if (step.parallel.empty())
             {
-                validationResult = validateResponse(step, response);
+                m_requests[i].setMethod(m_program->getString(step.method));
+                m_requests[i].setTimeout(step.timeout);
             }
+        }
+    }
 
-            http::printResponse(m_formatter->format(response), response.getStatusCode());
+    const Metrics& Player::getMetrics() const
+    {
+        return m_metrics;
+    }
 
-            return response.isSuccess() && validationResult;
+    bool Player::playFile(const std::string& filePath)
+    {
+        try
+        {
+            YamlParser parser;
+            Scenario scenario = parser.parseFile(filePath);
+            return play(scenario);
         } catch (const std::exception& e)
         {
-            LOG_ERROR_FMT("Exception during step execution: {}", e.what());
+            LOG_ERROR_FMT("Failed to play scenario file {}: {}", filePath, e.what());
             return false;
         }
     }
 
-    std::string Player::replaceVariables(const std::string& input)
+    void Player::setVirtualUser(std::size_t index, std::size_t count)
     {
-        std::string result = input;
-        std::regex variablePattern("\\$\\{([\\w.]+)\\}");
+        m_virtualUser = index;
+        m_virtualUsers = count;
+    }
 
-        std::smatch matches;
-        std::string::const_iterator searchStart(input.cbegin());
+    void Player::setBurstBarrier(std::shared_ptr<BurstBarrier> barrier)
+    {
+        m_burst = std::move(barrier);
+    }
 
-        while (std::regex_search(searchStart, input.cend(), matches, variablePattern))
-        {
-            std::string varName = matches[1].str();
-            std::string replacement;
+    void Player::setStopTokens(std::stop_token drain, std::stop_token abort)
+    {
+        m_drain = std::move(drain);
+        m_abort = std::move(abort);
+    }
 
-            if (m_variables.find(varName) != m_variables.end())
-            {
-                replacement = m_variables[varName];
-                LOG_DEBUG_FMT("Replacing variable '{}' with '{}'", varName, replacement);
-            }
-            else
-            {
-                LOG_WARNING_FMT("Variable '{}' not found, leaving as is", varName);
-                replacement = matches[0].str();
-            }
+    void Player::setPipeline(std::shared_ptr<ResponsePipeline> pipeline)
+    {
+        m_pipeline = std::move(pipeline);
+    }
 
-            size_t pos = result.find(matches[0].str());
-            if (pos != std::string::npos)
+    bool Player::bindData()
+    {
+        for (auto& cursor : m_cursors)
+        {
+            if (!cursor.next(m_frame))
             {
-                result.replace(pos, matches[0].length(), replacement);
+                LOG_INFO_FMT("Data file '{}' is exhausted, virtual user {} stops", cursor.getFeed().getFile(), m_virtualUser + 1);
+                return false;
             }
-
-            searchStart = matches.suffix().first;
         }
 
-        return result;
+        return true;
     }
 
-    http::Request Player::replaceVariablesInRequest(const http::Request& request)
+    bool Player::runPhase(Program::Phase phase)
     {
-        http::Request result = request;
-
-        result.setUrl(replaceVariables(request.getUrl()));
-
-        std::map<std::string, std::string> headers = request.getHeaders();
-        std::map<std::string, std::string> processedHeaders;
-
-        for (const auto& [key, value] : headers)
+        const Program::Section& section = m_program->getSection(phase);
+        if (section.begin == section.end)
         {
-            processedHeaders[key] = replaceVariables(value);
+            return true;
         }
-        result.setHeaders(processedHeaders);
 
-        if (request.getBody().has_value())
-        {
-            result.setBody(replaceVariables(request.getBody().value()));
-        }
+        const char* name = phase == Program::Phase::Setup ? "setup" : "teardown";
+        LOG_INFO_FMT("Running {} of scenario '{}'", name, m_program->getName());
 
-        std::map<std::string, std::string> params = request.getQueryParams();
-        std::map<std::string, std::string> processedParams;
+        m_recording = false;
+        bool success = runSection(section);
+        m_recording = true;
 
-        for (const auto& [key, value] : params)
+        if (!success)
         {
-            processedParams[key] = replaceVariables(value);
+            LOG_ERROR_FMT("The {} of scenario '{}' failed", name, m_program->getName());
         }
-        result.setQueryParams(processedParams);
-
-        return result;
+        return success;
     }
 
-    void Player::extractVariables(const Step& step, const http::Response& response)
+    bool Player::runSection(const Program::Section& section)
     {
-        for (const auto& [varName, extractionRule] : step.variables)
+        const auto& code = m_program->getCode();
+        bool success = true;
+
+        std::size_t pc = section.begin;
+        while (pc < section.end && !m_abort.stop_requested())
         {
-            try
+            const Program::Instruction& instruction = code[pc];
+
+            switch (instruction.op)
             {
-                if (extractionRule.starts_with("$."))
+            case Program::OpCode::Delay:
+            {
+                const Program::StepCode& step = m_program->getSteps()[instruction.operand];
+                auto delay = step.delay->sample(m_random);
+                LOG_DEBUG_FMT("Waiting for {} ms before executing step '{}'", delay.count(), m_program->getString(step.name));
+                pause(delay);
+                ++pc;
+                break;
+            }
+            case Program::OpCode::Branch:
+            {
+                const Program::StepCode& step = m_program->getSteps()[instruction.operand];
+                if (!evaluateCondition(step.condition.value()))
                 {
-                    try
-                    {
-                        auto json = nlohmann::json::parse(response.getBody());
-
-                        // Format: $.field1.field2[0].field3
-                        std::string path = extractionRule.substr(2);
-                        std::vector<std::string> parts;
-
-                        std::regex pathRegex(R"((\w+)(?:\[(\d+)\])?)");
-                        std::sregex_iterator it(path.begin(), path.end(), pathRegex);
-                        std::sregex_iterator end;
+                    LOG_INFO_FMT("Skipping step '{}' because condition is false", m_program->getString(step.name));
+                    pc = instruction.target;
+                }
+                else
+                {
+                    ++pc;
+                }
+                break;
+            }
+            case Program::OpCode::Request:
+            {
+                const Program::StepCode& step = m_program->getSteps()[instruction.operand];
+                const std::string& stepName = m_program->getString(step.name);
+                LOG_INFO_FMT("Executing step: {}", stepName);
+                LOG_INFO_FMT("Step description: {}", step.description);
 
-                        nlohmann::json current = json;
+                bool stepSuccess = executeStep(step, m_requests[instruction.operand], m_lanes.front());
+                m_last = &m_lanes.front();
 
-                        while (it != end)
-                        {
-                            std::smatch match = *it;
-                            std::string fieldName = match[1].str();
-
-                            if (current.contains(fieldName))
-                            {
-                                current = current[fieldName];
-
-                                if (match[2].matched)
-                                {
-                                    int index = std::stoi(match[2].str());
-                                    if (current.is_array() && index >= 0 && index < current.size())
-                                    {
-                                        current = current[index];
-                                    }
-                                    else
-                                    {
-                                        LOG_WARNING_FMT("Invalid array index {} for field {}", index, fieldName);
-                                        break;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                LOG_WARNING_FMT("Field {} not found in JSON", fieldName);
-                                break;
-                            }
-
-                            ++it;
-                        }
+                if (!stepSuccess)
+                {
+                    LOG_ERROR_FMT("Step '{}' failed", stepName);
+                    success = false;
 
-                        if (current.is_string())
-                        {
-                            m_variables[varName] = current.get<std::string>();
-                        }
-                        else
-                        {
-                            m_variables[varName] = current.dump();
-                        }
+                    if (!m_program->getContinueOnError())
+                    {
+                        return false;
+                    }
+                }
+                ++pc;
+                break;
+            }
+            case Program::OpCode::Lease:
+            {
+                if (!leaseCredential(instruction.operand))
+                {
+                    LOG_ERROR_FMT("Step '{}' failed", m_program->getString(m_program->getSteps()[instruction.operand].name));
+                    success = false;
 
-                        LOG_DEBUG_FMT("Extracted variable '{}' = '{}' using JSON path", varName, m_variables[varName]);
-                    } catch (const nlohmann::json::exception& e)
+                    if (!m_program->getContinueOnError())
                     {
-                        LOG_WARNING_FMT("Failed to parse response as JSON: {}", e.what());
+                        return false;
                     }
                 }
-                else if (extractionRule.starts_with("header."))
+                ++pc;
+                break;
+            }
+            case Program::OpCode::Fork:
+            {
+                const Program::StepCode& group = m_program->getSteps()[instruction.operand];
+                const std::string& groupName = m_program->getString(group.name);
+                LOG_INFO_FMT("Executing parallel group: {}", groupName);
+
+                if (!executeParallel(group))
                 {
-                    std::string headerName = extractionRule.substr(7);
-                    auto headers = response.getHeaders();
+                    LOG_ERROR_FMT("Parallel group '{}' failed", groupName);
+                    success = false;
 
-                    if (headers.find(headerName) != headers.end())
+                    if (!m_program->getContinueOnError())
                     {
-                        m_variables[varName] = headers[headerName];
-                        LOG_DEBUG_FMT("Extracted variable '{}' = '{}' from header", varName, m_variables[varName]);
+                        return false;
                     }
-                    else
+                }
+                ++pc;
+                break;
+            }
+            case Program::OpCode::Loop:
+                if (!startLoop(instruction.operand))
+                {
+                    success = false;
+
+                    if (!m_program->getContinueOnError())
                     {
-                        LOG_WARNING_FMT("Header {} not found in response", headerName);
+                        return false;
                     }
                 }
-                else if (extractionRule == "status_code")
+
+                if (m_loops[instruction.operand].count == 0)
                 {
-                    m_variables[varName] = std::to_string(response.getStatusCode());
-                    LOG_DEBUG_FMT("Extracted variable '{}' = '{}' from status code", varName, m_variables[varName]);
+                    pc = instruction.target;
                 }
-                else if (extractionRule == "body")
+                else
                 {
-                    m_variables[varName] = response.getBody();
-                    LOG_DEBUG_FMT("Extracted variable '{}' from response body", varName);
+                    bindLoopItem(instruction.operand);
+                    ++pc;
                 }
-                else if (extractionRule.starts_with("regex:"))
+                break;
+            case Program::OpCode::Next:
+            {
+                LoopState& state = m_loops[instruction.operand];
+                if (++state.index < state.count)
                 {
-                    std::string pattern = extractionRule.substr(6);
-                    std::regex regex(pattern);
-                    std::smatch matches;
-
-                    if (std::regex_search(response.getBody(), matches, regex) && matches.size() > 1)
-                    {
-                        m_variables[varName] = matches[1].str();
-                        LOG_DEBUG_FMT("Extracted variable '{}' = '{}' using regex", varName, m_variables[varName]);
-                    }
-                    else
-                    {
-                        LOG_WARNING_FMT("Regex pattern {} did not match or has no capture group", pattern);
-                    }
+                    bindLoopItem(instruction.operand);
+                    pc = instruction.target;
                 }
                 else
                 {
-                    LOG_WARNING_FMT("Unknown variable extraction rule: {}", extractionRule);
+                    ++pc;
                 }
-            } catch (const std::exception& e)
-            {
-                LOG_ERROR_FMT("Error extracting variable {}: {}", varName, e.what());
+                break;
+            }
             }
         }
+
+        return success;
     }
 
-    bool Player::evaluateCondition(const std::optional<std::string>& condition)
+    void Player::resetScratch()
     {
-        if (!condition.has_value() || condition->empty())
+        // the containers give their memory back before the arenas hand it out again
+        for (auto& state : m_loops)
         {
-            return true;
+            state.items = LoopState::Items(state.items.get_allocator());
+            state.count = 0;
         }
+        for (auto& lane : m_lanes)
+        {
+            lane.writes = Lane::Writes(lane.writes.get_allocator());
+            lane.arena.reset();
+        }
+    }
 
-        std::string processedCondition = replaceVariables(condition.value());
+    void Player::pause(std::chrono::nanoseconds duration) const
+    {
+        std::mutex mutex;
+        std::condition_variable_any wakeUp;
+        std::unique_lock lock(mutex);
+        wakeUp.wait_for(lock, m_abort, duration, []() { return false; });
+    }
 
-        // Format: variable == value, variable != value, etc.
-        std::regex conditionRegex(R"((\S+)\s*(==|!=|>|<|>=|<=)\s*(\S+))");
-        std::smatch matches;
+    bool Player::executeStep(const Program::StepCode& step, http::Request& request, Lane& lane)
+    {
+        bool claimed = false;
+        if (step.cache.has_value() && replayCache(step, lane, claimed))
+        {
+            return true;
+        }
 
-        if (std::regex_match(processedCondition, matches, conditionRegex))
+        try
         {
-            std::string left = matches[1].str();
-            std::string op = matches[2].str();
-            std::string right = matches[3].str();
+            const http::Request& processedRequest = renderRequest(step, request, lane);
 
-            if (left.front() == '"' && left.back() == '"')
-            {
-                left = left.substr(1, left.length() - 2);
-            }
-            if (right.front() == '"' && right.back() == '"')
+            lane.document.reset();
+            if (!throttle(step, processedRequest, lane))
             {
-                right = right.substr(1, right.length() - 2);
+                LOG_INFO_FMT("Skipping step '{}' because its rate limit is exhausted", m_program->getString(step.name));
+                receive(lane, http::Response());
+                releaseTarget(step, lane, std::nullopt);
+                storeCache(step, lane, false, claimed);
+                return true;
             }
 
-            LOG_DEBUG_FMT("Evaluating condition: {} {} {}", left, op, right);
-
-            if (op == "==")
-            {
-                return left == right;
-            }
-            else if (op == "!=")
-            {
-                return left != right;
-            }
-            else if (op == ">")
-            {
-                return std::stod(left) > std::stod(right);
-            }
-            else if (op == "<")
-            {
-                return std::stod(left) < std::stod(right);
-            }
-            else if (op == ">=")
-            {
-                return std::stod(left) >= std::stod(right);
-            }
-            else if (op == "<=")
+            LOG_DEBUG_FMT("Executing {} request to {}", processedRequest.getMethod(), processedRequest.getUrl());
+            receive(lane, m_client->execute(processedRequest, m_httpCache.get()));
+            bool success = completeStep(step, lane);
+            storeCache(step, lane, success, claimed);
+            return success;
+        } catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT("Exception during step execution: {}", e.what());
+            if (m_recording)
             {
-                return std::stod(left) <= std::stod(right);
+                lane.metrics.recordRequest(lane.response->getLatency(), false);
             }
+            releaseTarget(step, lane, false);
+            storeCache(step, lane, false, claimed);
+            return false;
         }
-
-        LOG_WARNING_FMT("Invalid condition format: {}", processedCondition);
-        return false;
     }
 
-    bool Player::validateResponse(const Step& step, const http::Response& actualResponse) const
+    bool Player::replayCache(const Program::StepCode& step, Lane& lane, bool& claimed)
     {
-        if (!step.expectedResponse.has_value())
+        const Program::CacheCode& cache = m_program->getCaches()[step.cache.value()];
+        auto cached = cache.shared != nullptr ? cache.shared->lease(0) : m_cached[step.cache.value()];
+        bool valid = cached != nullptr && std::chrono::steady_clock::now() < cached->expires;
+
+        // One virtual user refreshes a shared entry; the others keep replaying the expired one meanwhile
+        if (!valid && cache.shared != nullptr)
         {
-            return true;
+            claimed = cache.shared->claim(0);
+            valid = !claimed && cached != nullptr;
+        }
+        if (!valid)
+        {
+            return false;
         }
 
-        const http::Response& expectedResponse = step.expectedResponse.value();
-        bool isValid = true;
+        LOG_DEBUG_FMT("Replaying {} cached variables of step '{}'", cached->values.size(), m_program->getString(step.name));
+        for (const auto& [slot, value] : cached->values)
+        {
+            assign(lane, slot, value);
+        }
+        lane.document.reset();
+        receive(lane, http::Response());
+        if (m_recording)
+        {
+            lane.metrics.recordCacheHit();
+        }
+        return true;
+    }
 
-        if (expectedResponse.getStatusCode() != 0 && expectedResponse.getStatusCode() != actualResponse.getStatusCode())
+    void Player::storeCache(const Program::StepCode& step, const Lane& lane, bool success, bool claimed)
+    {
+        if (!step.cache.has_value())
         {
-            LOG_ERROR_FMT(
-                "Status code validation failed: expected {}, got {}", expectedResponse.getStatusCode(), actualResponse.getStatusCode());
-            isValid = false;
+            return;
         }
 
-        for (const auto& [name, value] : expectedResponse.getHeaders())
+        const Program::CacheCode& cache = m_program->getCaches()[step.cache.value()];
+        // Without the claim another virtual user publishes the shared entry
+        if (cache.shared != nullptr && !claimed)
         {
-            if (actualResponse.getHeaders().find(name) == actualResponse.getHeaders().end() ||
-                actualResponse.getHeaders().at(name) != value)
+            return;
+        }
+        if (!success)
+        {
+            if (claimed)
             {
-                LOG_ERROR_FMT(
-                    "Header validation failed for {}: expected {}, got {}",
-                    name,
-                    value,
-                    actualResponse.getHeaders().find(name) != actualResponse.getHeaders().end() ? actualResponse.getHeaders().at(name)
-                                                                                                : "not present");
-                isValid = false;
+                cache.shared->release(0);
             }
+            return;
         }
 
-        if (!expectedResponse.getBody().empty())
+        auto result = std::make_shared<Credential>();
+        if (lane.deferred)
         {
-            try
+            // a step of an automatically parallelised group has not written its variables to the frame yet
+            for (const auto& [slot, value] : lane.writes)
             {
-                auto expectedJson = nlohmann::json::parse(expectedResponse.getBody());
-                auto actualJson = nlohmann::json::parse(actualResponse.getBody());
-
-                if (expectedJson != actualJson)
-                {
-                    LOG_ERROR("JSON body validation failed");
-                    LOG_DEBUG_FMT("Expected: {}", expectedResponse.getBody());
-                    LOG_DEBUG_FMT("Actual: {}", actualResponse.getBody());
-                    isValid = false;
-                }
-            } catch (const nlohmann::json::exception&)
+                std::erase_if(result->values, [slot](const auto& entry) { return entry.first == slot; });
+                result->values.emplace_back(slot, value);
+            }
+        }
+        else
+        {
+            for (VariableSlot slot : cache.slots)
             {
-                if (expectedResponse.getBody() != actualResponse.getBody())
+                if (m_frame.has(slot))
                 {
-                    LOG_ERROR("Body validation failed");
-                    LOG_DEBUG_FMT("Expected: {}", expectedResponse.getBody());
-                    LOG_DEBUG_FMT("Actual: {}", actualResponse.getBody());
-                    isValid = false;
+                    result->values.emplace_back(slot, m_frame.get(slot));
                 }
             }
         }
+        if (cache.ttl.has_value())
+        {
+            result->expires = std::chrono::steady_clock::now() + cache.ttl.value();
+        }
 
-        return isValid;
+        if (cache.shared != nullptr)
+        {
+            cache.shared->publish(0, std::move(result));
+        }
+        else
+        {
+            m_cached[step.cache.value()] = std::move(result);
+        }
+    }
+
+    bool Player::throttle(const Program::StepCode& step, const http::Request& request, Lane& lane)
+    {
+        const auto& limits = m_program->getRateLimits();
+        if (step.rateLimit.has_value() && !takeToken(limits[step.rateLimit.value()], lane))
+        {
+            return false;
+        }
+
+        // Patterns match the URL as it is sent, query parameters included
+        bool rendered = false;
+        for (const auto& limit : limits)
+        {
+            if (!limit.match.has_value())
+            {
+                continue;
+            }
+            if (!rendered)
+            {
+                lane.buffer = request.getUrl();
+                http::Client::appendQuery(lane.buffer, request.getQueryParams());
+                rendered = true;
+            }
+            if (limit.match->contains(lane.buffer) && !takeToken(limit, lane))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Player::takeToken(const Program::RateLimitCode& limit, Lane& lane)
+    {
+        if (limit.action == RateLimitAction::Skip)
+        {
+            bool taken = limit.bucket->tryTake();
+            if (!taken && m_recording)
+            {
+                lane.metrics.recordRateLimitSkip();
+            }
+            return taken;
+        }
+
+        auto wait = limit.bucket->reserve();
+        if (wait.count() > 0)
+        {
+            auto start = std::chrono::steady_clock::now();
+            pause(wait);
+            if (m_recording)
+            {
+                lane.metrics.recordRateLimitWait(std::chrono::steady_clock::now() - start);
+            }
+        }
+        // an aborted run does not send what it was waiting for
+        return !m_abort.stop_requested();
+    }
+
+    void Player::receive(Lane& lane, http::Response response)
+    {
+        if (lane.handedOff)
+        {
+            lane.response = std::make_shared<http::Response>(std::move(response));
+            lane.handedOff = false;
+        }
+        else
+        {
+            *lane.response = std::move(response);
+        }
+    }
+
+    bool Player::completeStep(const Program::StepCode& step, Lane& lane)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const http::Response& response = *lane.response;
+        ResponseDocument& document = lane.document.emplace(response);
+        // setup and teardown do everything on the request thread, as their variables are handed to other players
+        bool offload = m_pipeline != nullptr && m_recording;
+
+        extractVariables(step, document, lane, offload);
+
+        bool validationResult = true;
+        if (step.validator.has_value() && !(offload && step.lateValidation))
+        {
+            validationResult = step.validator->validate(document);
+        }
+
+        if (offload)
+        {
+            ResponsePipeline::Job job;
+            job.program = m_program.get();
+            job.step = &step;
+            job.formatter = m_formatter.get();
+            job.sink = m_sink;
+            job.response = lane.response;
+            lane.handedOff = true;
+            // the values are not used, so the extractions nothing reads only run for the debug log
+            job.extract = logging::Logger::getInstance().get()->should_log(spdlog::level::debug) &&
+                          std::ranges::any_of(step.extractions, [](const auto& extraction) { return !extraction.live; });
+            job.validate = step.lateValidation;
+            m_pipeline->submit(job);
+        }
+        else if (http::isResponsePrinted(response.getStatusCode()))
+        {
+            http::printResponse(m_formatter->format(response), response.getStatusCode());
+        }
+
+        bool success = response.isSuccess() && validationResult;
+        if (m_recording)
+        {
+            // a response the HTTP cache served was never sent
+            if (response.getCacheStatus() != http::CacheStatus::Hit)
+            {
+                lane.metrics.recordRequest(response.getLatency(), success);
+            }
+            lane.metrics.recordHttpCache(step.name, m_program->getString(step.name), response.getCacheStatus());
+            if (offload)
+            {
+                lane.metrics.recordStage(Metrics::Stage::Respond, std::chrono::steady_clock::now() - start);
+            }
+        }
+        releaseTarget(step, lane, success);
+        return success;
+    }
+
+    bool Player::collectPipeline(bool wait)
+    {
+        if (m_sink == nullptr)
+        {
+            return true;
+        }
+
+        if (wait)
+        {
+            ResponsePipeline::await(*m_sink);
+        }
+        std::uint64_t failed = m_sink->failed.exchange(0, std::memory_order_relaxed);
+        m_metrics.recordLateFailures(failed);
+        return failed == 0;
+    }
+
+    void Player::releaseTarget(const Program::StepCode& step, Lane& lane, std::optional<bool> success)
+    {
+        if (!lane.node.has_value())
+        {
+            return;
+        }
+
+        const Program::TargetCode& target = m_program->getTargets()[step.target.value()];
+        std::size_t node = std::exchange(lane.node, std::nullopt).value();
+        target.group->release(node);
+        if (success.has_value() && m_recording)
+        {
+            lane.metrics.recordTarget(
+                target.firstNode + node, target.group->getNodes()[node].label, lane.response->getLatency(), success.value());
+        }
+    }
+
+    bool Player::runBurst()
+    {
+        const Program::Section& main = m_program->getSection(Program::Phase::Main);
+        std::size_t stepIndex = m_program->getCode()[main.begin].operand;
+        const Program::StepCode& step = m_program->getSteps()[stepIndex];
+        const std::string& stepName = m_program->getString(step.name);
+
+        LOG_INFO_FMT("Preparing burst step: {}", stepName);
+        bool success = sendBurst(step, m_requests[stepIndex], m_lanes.front());
+        m_last = &m_lanes.front();
+
+        if (!success)
+        {
+            LOG_ERROR_FMT("Step '{}' failed", stepName);
+            if (!m_program->getContinueOnError() || m_abort.stop_requested())
+            {
+                return false;
+            }
+        }
+
+        return runSection({ main.begin + 1, main.end, main.scope }) && success;
+    }
+
+    bool Player::sendBurst(const Program::StepCode& step, http::Request& request, Lane& lane)
+    {
+        // Everything but the send itself happens before the barrier
+        std::optional<http::PreparedRequest> prepared;
+        try
+        {
+            prepared = m_client->prepare(renderRequest(step, request, lane), m_httpCache.get());
+        } catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT("Exception during step execution: {}", e.what());
+        }
+
+        // A virtual user that could not prepare its request still takes its place in the round
+        auto release = m_burst->arrive(m_abort);
+        if (!release.has_value() || !prepared.has_value())
+        {
+            if (release.has_value() && m_recording)
+            {
+                lane.metrics.recordRequest(std::chrono::milliseconds(0), false);
+            }
+            releaseTarget(step, lane, release.has_value() ? std::optional<bool>(false) : std::nullopt);
+            return false;
+        }
+
+        try
+        {
+            auto sent = std::chrono::steady_clock::now();
+            lane.document.reset();
+            receive(lane, m_client->send(prepared.value()));
+
+            if (m_recording)
+            {
+                lane.metrics.recordBurst(release->round, sent - release->time, lane.response->getLatency());
+            }
+            return completeStep(step, lane);
+        } catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT("Exception during step execution: {}", e.what());
+            if (m_recording)
+            {
+                lane.metrics.recordRequest(lane.response->getLatency(), false);
+            }
+            releaseTarget(step, lane, false);
+            return false;
+        }
+    }
+
+    bool Player::executeParallel(const Program::StepCode& group)
+    {
+        const auto& steps = m_program->getSteps();
+
+        // Conditions are evaluated before fanning out, against the variables as they were before the group
+        m_forked.clear();
+        for (std::size_t branch : group.parallel)
+        {
+            const Program::StepCode& step = steps[branch];
+            if (step.condition.has_value() && !evaluateCondition(step.condition.value()))
+            {
+                LOG_INFO_FMT("Skipping step '{}' because condition is false", m_program->getString(step.name));
+                continue;
+            }
+            m_forked.push_back(branch);
+        }
+
+        if (m_forked.empty())
+        {
+            return true;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (std::size_t index = 0; index < m_forked.size(); ++index)
+        {
+            const auto& delay = steps[m_forked[index]].delay;
+            m_lanes[index + 1].delay = delay.has_value() ? delay->sample(m_random) : std::chrono::milliseconds(0);
+        }
+
+        // The calling thread sends the first step itself and hands the others to the workers of their lanes
+        for (std::size_t index = 1; index < m_forked.size(); ++index)
+        {
+            Lane& lane = m_lanes[index + 1];
+            lane.seed = Random::local().next();
+            if (!lane.worker.joinable())
+            {
+                lane.worker = std::jthread([this, index]() { serveBranches(index); });
+            }
+            lane.state.store(BranchState::Busy, std::memory_order_release);
+            lane.state.notify_one();
+        }
+        runBranch(0);
+        for (std::size_t index = 1; index < m_forked.size(); ++index)
+        {
+            m_lanes[index + 1].state.wait(BranchState::Busy, std::memory_order_acquire);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+
+        // Variables extracted by the branches are published in declaration order once all of them are done
+        bool success = true;
+        for (std::size_t index = 0; index < m_forked.size(); ++index)
+        {
+            Lane& lane = m_lanes[index + 1];
+            for (const auto& [slot, value] : lane.writes)
+            {
+                m_frame.set(slot, value);
+            }
+            lane.writes.clear();
+
+            if (!lane.success)
+            {
+                LOG_ERROR_FMT("Step '{}' failed", m_program->getString(steps[m_forked[index]].name));
+                success = false;
+            }
+            m_last = &lane;
+        }
+
+        LOG_INFO_FMT("Parallel group '{}' completed {} steps in {} ms", m_program->getString(group.name), m_forked.size(), elapsed.count());
+        return success;
+    }
+
+    void Player::runBranch(std::size_t index)
+    {
+        const Program::StepCode& step = m_program->getSteps()[m_forked[index]];
+        Lane& lane = m_lanes[index + 1];
+        if (index > 0)
+        {
+            Random::local().seed(lane.seed);
+        }
+
+        if (lane.delay.count() > 0)
+        {
+            pause(lane.delay);
+        }
+
+        LOG_INFO_FMT("Executing parallel step: {}", m_program->getString(step.name));
+        lane.success = executeStep(step, m_requests[m_forked[index]], lane);
+    }
+
+    void Player::serveBranches(std::size_t index)
+    {
+        Lane& lane = m_lanes[index + 1];
+        while (true)
+        {
+            lane.state.wait(BranchState::Idle, std::memory_order_acquire);
+            if (lane.state.load(std::memory_order_acquire) == BranchState::Stop)
+            {
+                return;
+            }
+
+            runBranch(index);
+            lane.state.store(BranchState::Idle, std::memory_order_release);
+            lane.state.notify_one();
+        }
+    }
+
+    bool Player::leaseCredential(std::size_t stepIndex)
+    {
+        const Program::StepCode& step = m_program->getSteps()[stepIndex];
+        const Program::CredentialCode& policy = m_program->getCredentials()[step.credential.value()];
+        CredentialStore& store = *policy.store;
+        std::size_t entry = m_virtualUser % store.size();
+
+        while (true)
+        {
+            auto credential = store.lease(entry);
+            auto now = std::chrono::steady_clock::now();
+            bool valid = credential != nullptr && now < credential->expires;
+
+            if (valid && now + policy.refreshBefore < credential->expires)
+            {
+                bindCredential(*credential);
+                return true;
+            }
+
+            if (store.claim(entry))
+            {
+                return renewCredential(stepIndex, entry, valid ? credential.get() : nullptr);
+            }
+
+            // Another virtual user is renewing the credential; one that has not expired yet can still be used meanwhile
+            if (valid)
+            {
+                bindCredential(*credential);
+                return true;
+            }
+            if (m_abort.stop_requested())
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(CREDENTIAL_POLL_INTERVAL);
+        }
+    }
+
+    bool Player::renewCredential(std::size_t stepIndex, std::size_t entry, const Credential* current)
+    {
+        const Program::StepCode& step = m_program->getSteps()[stepIndex];
+        const Program::CredentialCode& policy = m_program->getCredentials()[step.credential.value()];
+        const std::string& stepName = m_program->getString(step.name);
+
+        bool success = false;
+        if (current != nullptr && policy.refresh.has_value())
+        {
+            const Program::StepCode& refresh = m_program->getSteps()[policy.refresh.value()];
+            LOG_INFO_FMT("Refreshing credential {} of step '{}' with step '{}'", entry + 1, stepName, m_program->getString(refresh.name));
+
+            bindCredential(*current);
+            success = executeStep(refresh, m_requests[policy.refresh.value()], m_lanes.front());
+            m_last = &m_lanes.front();
+            if (!success)
+            {
+                LOG_WARNING_FMT("Refreshing credential {} of step '{}' failed, logging in again", entry + 1, stepName);
+            }
+        }
+
+        if (!success)
+        {
+            LOG_INFO_FMT("Executing step: {}", stepName);
+            LOG_INFO_FMT("Step description: {}", step.description);
+            success = executeStep(step, m_requests[stepIndex], m_lanes.front());
+            m_last = &m_lanes.front();
+        }
+
+        if (!success)
+        {
+            policy.store->release(entry);
+            return false;
+        }
+
+        auto credential = std::make_shared<Credential>();
+        for (VariableSlot slot : policy.slots)
+        {
+            if (m_frame.has(slot))
+            {
+                credential->values.emplace_back(slot, m_frame.get(slot));
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (policy.ttl.has_value())
+        {
+            credential->expires = now + policy.ttl.value();
+        }
+        else if (policy.expiresIn.has_value() && m_frame.has(policy.expiresIn.value()))
+        {
+            const std::string& value = m_frame.get(policy.expiresIn.value());
+            std::int64_t seconds = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+            if (ec == std::errc() && seconds >= 0)
+            {
+                credential->expires = now + std::chrono::seconds(seconds);
+            }
+            else
+            {
+                LOG_WARNING_FMT("Credential lifetime '{}' of step '{}' is not a number of seconds, it never expires", value, stepName);
+            }
+        }
+
+        LOG_DEBUG_FMT("Published credential {} of step '{}' with {} variables", entry + 1, stepName, credential->values.size());
+        policy.store->publish(entry, std::move(credential));
+        return true;
+    }
+
+    void Player::bindCredential(const Credential& credential)
+    {
+        for (const auto& [slot, value] : credential.values)
+        {
+            m_frame.set(slot, value);
+        }
+    }
+
+    bool Player::startLoop(std::size_t loopIndex)
+    {
+        const Program::LoopCode& loop = m_program->getLoops()[loopIndex];
+        const std::string& stepName = m_program->getString(m_program->getSteps()[loop.step].name);
+        LoopState& state = m_loops[loopIndex];
+        state.index = 0;
+        state.count = 0;
+
+        if (!loop.items.has_value())
+        {
+            state.count = static_cast<std::size_t>(loop.count);
+            LOG_DEBUG_FMT("Repeating step '{}' {} times", stepName, state.count);
+            return true;
+        }
+
+        std::string& buffer = m_lanes.front().buffer;
+        loop.items->render(m_frame, buffer);
+
+        nlohmann::json items = nlohmann::json::parse(buffer, nullptr, false);
+        if (!items.is_array())
+        {
+            LOG_ERROR_FMT("Foreach value of step '{}' is not a JSON array: {}", stepName, buffer);
+            return false;
+        }
+
+        // Item strings are reused by the later runs of the loop within the iteration
+        state.items.resize(items.size());
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            if (items[i].is_string())
+            {
+                state.items[i].assign(items[i].get_ref<const std::string&>());
+            }
+            else
+            {
+                state.items[i].assign(items[i].dump());
+            }
+        }
+        state.count = state.items.size();
+
+        LOG_DEBUG_FMT("Iterating step '{}' over {} items", stepName, state.count);
+        return true;
+    }
+
+    void Player::bindLoopItem(std::size_t loopIndex)
+    {
+        const Program::LoopCode& loop = m_program->getLoops()[loopIndex];
+        const LoopState& state = m_loops[loopIndex];
+
+        char digits[24];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), state.index);
+        m_frame.set(loop.indexSlot, std::string_view(digits, static_cast<std::size_t>(end - digits)));
+
+        if (loop.items.has_value())
+        {
+            m_frame.set(loop.itemSlot, state.items[state.index]);
+        }
+    }
+
+    const http::Request& Player::renderRequest(const Program::StepCode& step, http::Request& request, Lane& lane)
+    {
+        if (step.target.has_value())
+        {
+            const Program::TargetCode& target = m_program->getTargets()[step.target.value()];
+            lane.buffer.clear();
+            if (target.key.has_value())
+            {
+                target.key->render(m_frame, lane.buffer);
+            }
+            lane.node = target.group->acquire(lane.buffer);
+
+            // the node path is a prefix of the step path
+            const TargetGroup::Node& node = target.group->getNodes()[lane.node.value()];
+            step.url.render(m_frame, lane.buffer);
+            lane.buffer.insert(0, node.origin.path);
+            request.setUrl(node.origin, lane.buffer);
+            if (!node.host.empty())
+            {
+                request.setHeader("Host", node.host);
+            }
+        }
+        else
+        {
+            step.url.render(m_frame, lane.buffer);
+            if (step.origin.has_value())
+            {
+                request.setUrl(step.origin.value(), lane.buffer);
+            }
+            else
+            {
+                request.setUrl(lane.buffer);
+            }
+        }
+
+        for (const auto& [name, value] : step.headers)
+        {
+            value.render(m_frame, lane.buffer);
+            request.setHeader(m_program->getString(name), lane.buffer);
+        }
+
+        if (step.body.has_value())
+        {
+            step.body->render(m_frame, lane.buffer);
+            request.setBody(lane.buffer);
+        }
+
+        for (const auto& [name, value] : step.queryParams)
+        {
+            value.render(m_frame, lane.buffer);
+            request.addQueryParam(m_program->getString(name), lane.buffer);
+        }
+
+        return request;
+    }
+
+    void Player::extractVariables(const Program::StepCode& step, ResponseDocument& document, Lane& lane, bool liveOnly)
+    {
+        const VariableTable& table = m_program->getTable();
+
+        if (!step.streamedExtractions.empty())
+        {
+            if (!step.jsonStream.select(document.getResponse().getBody(), lane.streamed))
+            {
+                LOG_WARNING("Failed to parse response as JSON");
+            }
+
+            for (std::size_t i = 0; i < step.streamedExtractions.size(); ++i)
+            {
+                const auto& [slot, extractor, groups, live] = step.streamedExtractions[i];
+
+                if (lane.streamed[i].has_value())
+                {
+                    assign(lane, slot, lane.streamed[i].value());
+                    LOG_DEBUG_FMT(
+                        "Extracted variable '{}' = '{}' using rule {}", table.getName(slot), lane.streamed[i].value(), extractor.getRule());
+                }
+                else
+                {
+                    LOG_WARNING_FMT("JSON path {} not found in response", extractor.getRule());
+                }
+            }
+        }
+
+        for (const auto& [slot, extractor, groups, live] : step.extractions)
+        {
+            if (liveOnly && !live)
+            {
+                continue;
+            }
+
+            try
+            {
+                if (extractor.getKind() == Extractor::Kind::Regex)
+                {
+                    if (!extractor.getPattern().search(document.getResponse().getBody(), lane.groups))
+                    {
+                        LOG_WARNING_FMT("Regex pattern {} did not match", extractor.getPattern().getSource());
+                        continue;
+                    }
+
+                    for (const auto& [groupSlot, groupIndex] : groups)
+                    {
+                        if (lane.groups[groupIndex].data() != nullptr)
+                        {
+                            assign(lane, groupSlot, lane.groups[groupIndex]);
+                            LOG_DEBUG_FMT(
+                                "Extracted variable '{}' = '{}' using regex", table.getName(groupSlot), lane.groups[groupIndex]);
+                        }
+                    }
+                }
+                else if (extractor.extract(document, lane.extracted))
+                {
+                    assign(lane, slot, lane.extracted);
+                    LOG_DEBUG_FMT("Extracted variable '{}' = '{}' using rule {}", table.getName(slot), lane.extracted, extractor.getRule());
+                }
+            } catch (const std::exception& e)
+            {
+                LOG_ERROR_FMT("Error extracting variable {}: {}", table.getName(slot), e.what());
+            }
+        }
+    }
+
+    void Player::assign(Lane& lane, VariableSlot slot, std::string_view value)
+    {
+        if (lane.deferred)
+        {
+            lane.writes.emplace_back(slot, value);
+        }
+        else
+        {
+            m_frame.set(slot, value);
+        }
+    }
+
+    bool Player::evaluateCondition(const Condition& condition)
+    {
+        ResponseDocument* document = m_last != nullptr && m_last->document.has_value() ? &m_last->document.value() : nullptr;
+        bool result = condition.evaluate(m_frame, document);
+        LOG_DEBUG_FMT("Condition '{}' evaluated to {}", condition.getSource(), result);
+        return result;
     }
-} // namespace zaplet::scenario
\ No newline at end of file
+} // namespace zaplet::scenario
@@ -0,0 +1,1207 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/program.h"
+
+#include "zaplet/logging/logger.h"
+#include "zaplet/scenario/dependency_graph.h"
+#include "zaplet/scenario/random.h"
+
+#include <algorithm>
+#include <format>
+#include <set>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // Bound by loop and foreach steps to the zero-based iteration number
+        constexpr const char* LOOP_INDEX_VARIABLE = "index";
+
+        // Splits a URL template into a constant origin and a path template, when scheme, host and port are all literal
+        std::optional<std::pair<http::Url, std::string>> splitOrigin(const Template& url)
+        {
+            const auto& segments = url.getSegments();
+            if (segments.empty() || segments.front().kind != Template::SegmentKind::Literal)
+            {
+                return std::nullopt;
+            }
+
+            std::string_view source = url.getSource();
+            std::string_view literal = source.substr(0, segments.front().length);
+
+            std::size_t schemeEnd = literal.find("://");
+            if (schemeEnd == std::string_view::npos)
+            {
+                return std::nullopt;
+            }
+
+            std::size_t authorityEnd = literal.find_first_of("/?", schemeEnd + 3);
+            if (authorityEnd == std::string_view::npos)
+            {
+                if (segments.size() > 1)
+                {
+                    return std::nullopt;
+                }
+                authorityEnd = literal.size();
+            }
+
+            auto origin = http::Url::parse(literal.substr(0, authorityEnd));
+            if (!origin.has_value())
+            {
+                return std::nullopt;
+            }
+
+            std::string path(source.substr(authorityEnd));
+            if (path.empty() || path.front() != '/')
+            {
+                path.insert(path.begin(), '/');
+            }
+
+            return std::make_pair(std::move(origin.value()), std::move(path));
+        }
+
+        std::string describe(const Template& value, const VariableTable& table)
+        {
+            std::string result;
+            for (const auto& segment : value.getSegments())
+            {
+                if (!result.empty())
+                {
+                    result += " + ";
+                }
+
+                if (segment.kind == Template::SegmentKind::Literal)
+                {
+                    result += std::format("\"{}\"", value.getSource().substr(segment.offset, segment.length));
+                }
+                else if (segment.kind == Template::SegmentKind::Function)
+                {
+                    result += value.getSource().substr(segment.offset + 2, segment.length - 3);
+                }
+                else
+                {
+                    result += std::format("${}:{}", segment.slot, table.getName(segment.slot));
+                }
+            }
+
+            return result.empty() ? "\"\"" : result;
+        }
+
+        std::string_view dataModeName(DataMode mode)
+        {
+            switch (mode)
+            {
+            case DataMode::Sequential:
+                return "sequential";
+            case DataMode::Random:
+                return "random";
+            case DataMode::Unique:
+                return "unique";
+            case DataMode::Circular:
+                return "circular";
+            }
+
+            return "unknown";
+        }
+
+        std::string_view balanceName(BalanceMode mode)
+        {
+            switch (mode)
+            {
+            case BalanceMode::RoundRobin:
+                return "round robin";
+            case BalanceMode::LeastOutstanding:
+                return "least outstanding";
+            case BalanceMode::ConsistentHash:
+                return "consistent hash";
+            }
+
+            return "unknown";
+        }
+
+        std::string_view kindName(Extractor::Kind kind)
+        {
+            switch (kind)
+            {
+            case Extractor::Kind::JsonPath:
+                return "json";
+            case Extractor::Kind::Header:
+                return "header";
+            case Extractor::Kind::StatusCode:
+                return "status";
+            case Extractor::Kind::Body:
+                return "body";
+            case Extractor::Kind::Regex:
+                return "regex";
+            }
+
+            return "unknown";
+        }
+
+        void markReads(const Template& value, std::vector<bool>& read)
+        {
+            for (const auto& segment : value.getSegments())
+            {
+                if (segment.kind == Template::SegmentKind::Variable)
+                {
+                    read[segment.slot] = true;
+                }
+            }
+            for (const auto& call : value.getCalls())
+            {
+                for (const auto& argument : call.arguments)
+                {
+                    if (argument.variable)
+                    {
+                        read[argument.slot] = true;
+                    }
+                }
+            }
+        }
+    } // namespace
+
+    Program Program::compile(const Scenario& scenario)
+    {
+        Program program;
+        program.m_name = scenario.getName();
+        program.m_description = scenario.getDescription();
+        program.m_repeatCount = scenario.getRepeatCount();
+        program.m_continueOnError = scenario.getContinueOnError();
+        program.m_virtualUsers = scenario.getVirtualUsers();
+        program.m_seed = scenario.getSeed().value_or(Random().next());
+        program.m_duration = scenario.getDuration();
+        program.m_thinkTime = scenario.getThinkTime();
+        program.m_pacing = scenario.getPacing();
+        program.m_burst = scenario.getBurst();
+        program.m_httpCache = scenario.getHttpCache();
+
+        for (const auto& limit : scenario.getRateLimits())
+        {
+            program.m_rateLimits.push_back(
+                { std::make_shared<TokenBucket>(limit.rate, limit.burst), limit.action, Pattern::compile(limit.match.value()) });
+        }
+
+        // Steps are laid out setup first, then the main steps, then teardown; the steps of a parallel group follow the group
+        std::vector<const Step*> steps;
+        auto layout = [&steps](const std::vector<Step>& phase)
+        {
+            std::vector<std::size_t> indices;
+            for (const auto& step : phase)
+            {
+                indices.push_back(steps.size());
+                steps.push_back(&step);
+                for (const auto& branch : step.parallel)
+                {
+                    steps.push_back(&branch);
+                }
+            }
+            return indices;
+        };
+
+        std::vector<std::size_t> setupIndices = layout(scenario.getSetup());
+        std::size_t setupStepCount = steps.size();
+        std::vector<std::size_t> stepIndices = layout(scenario.getSteps());
+        std::size_t mainStepEnd = steps.size();
+        std::vector<std::size_t> teardownIndices = layout(scenario.getTeardown());
+
+        // Extraction rules are compiled first to learn which variables the scenario writes
+        std::vector<std::vector<std::pair<std::string, Extractor>>> extractors;
+        std::set<std::string, std::less<>> written;
+
+        for (const Step* step : steps)
+        {
+            auto& stepExtractors = extractors.emplace_back();
+            for (const auto& [varName, extractionRule] : step->variables)
+            {
+                Extractor extractor = Extractor::compile(extractionRule);
+                written.insert(varName);
+
+                if (extractor.getKind() == Extractor::Kind::Regex)
+                {
+                    for (const auto& [groupName, groupIndex] : extractor.getPattern().getNamedGroups())
+                    {
+                        written.insert(groupName);
+                    }
+                }
+
+                stepExtractors.emplace_back(varName, std::move(extractor));
+            }
+
+            if (step->loop.has_value() || step->foreach.has_value())
+            {
+                written.insert(LOOP_INDEX_VARIABLE);
+            }
+            if (step->foreach.has_value())
+            {
+                written.insert(step->itemVariable);
+            }
+        }
+
+        // Variables bound to data files change every iteration
+        for (const auto& source : scenario.getData())
+        {
+            auto feed = std::make_shared<const DataFeed>(source, program.m_table);
+            for (const auto& slots : feed->getBindings())
+            {
+                for (VariableSlot slot : slots)
+                {
+                    written.insert(program.m_table.getName(slot));
+                }
+            }
+            program.m_data.push_back(std::move(feed));
+        }
+
+        // Environment variables no step overwrites are folded into the templates
+        for (const auto& [name, value] : scenario.getEnvironment())
+        {
+            program.m_initialValues.emplace_back(program.m_table.intern(name), value);
+            if (!written.contains(name))
+            {
+                program.m_constants.emplace(name, value);
+            }
+        }
+
+        std::size_t nodeCount = 0;
+        for (const auto& [name, definition] : scenario.getTargets())
+        {
+            std::vector<TargetGroup::Node> nodes;
+            for (const auto& url : definition.urls)
+            {
+                auto expanded = TargetGroup::expand(url, definition.resolve);
+                nodes.insert(nodes.end(), expanded.begin(), expanded.end());
+            }
+
+            TargetCode& target = program.m_targets.emplace_back();
+            target.group = std::make_shared<TargetGroup>(name, std::move(nodes), definition.balance);
+            if (definition.key.has_value())
+            {
+                target.key = Template::compile(definition.key.value(), program.m_table, program.m_constants);
+            }
+            target.firstNode = nodeCount;
+            nodeCount += target.group->getNodes().size();
+        }
+
+        for (std::size_t stepIndex = 0; stepIndex < steps.size(); ++stepIndex)
+        {
+            StepCode code = program.compileStep(*steps[stepIndex], extractors[stepIndex], scenario.getJsonStreaming());
+            for (std::size_t branch = 1; branch <= steps[stepIndex]->parallel.size(); ++branch)
+            {
+                code.parallel.push_back(stepIndex + branch);
+            }
+            program.m_parallelWidth = std::max(program.m_parallelWidth, code.parallel.size());
+            program.m_steps.push_back(std::move(code));
+        }
+
+        std::vector<std::pair<std::size_t, const Step*>> topLevel;
+        for (const auto& [indices, phase] : { std::pair(&setupIndices, &scenario.getSetup()),
+                                              std::pair(&stepIndices, &scenario.getSteps()),
+                                              std::pair(&teardownIndices, &scenario.getTeardown()) })
+        {
+            for (std::size_t index = 0; index < indices->size(); ++index)
+            {
+                topLevel.emplace_back((*indices)[index], &(*phase)[index]);
+            }
+        }
+        program.compileCredentials(topLevel);
+        program.compileCaches(topLevel);
+
+        for (std::size_t index = 0; index < setupIndices.size(); ++index)
+        {
+            program.emitStep(setupIndices[index], scenario.getSetup()[index]);
+        }
+        program.m_setup = { 0, program.m_code.size(), scenario.getSetupScope() };
+
+        if (!scenario.getAutoParallel())
+        {
+            for (std::size_t index = 0; index < stepIndices.size(); ++index)
+            {
+                program.emitStep(stepIndices[index], scenario.getSteps()[index]);
+            }
+        }
+        else
+        {
+            // Each level of the dependency graph with more than one step becomes a parallel group of its own
+            DependencyGraph graph = DependencyGraph::build(scenario);
+            for (auto level : graph.getLevels())
+            {
+                std::erase_if(level, [&](std::size_t index) { return program.m_steps[stepIndices[index]].refresh; });
+                if (level.empty())
+                {
+                    continue;
+                }
+                if (level.size() == 1)
+                {
+                    program.emitStep(stepIndices[level.front()], scenario.getSteps()[level.front()]);
+                    continue;
+                }
+
+                StepCode group;
+                std::string name;
+                for (std::size_t index : level)
+                {
+                    name += name.empty() ? "" : " + ";
+                    name += scenario.getSteps()[index].name;
+                    group.parallel.push_back(stepIndices[index]);
+                }
+                group.name = program.intern(name);
+
+                program.m_parallelWidth = std::max(program.m_parallelWidth, group.parallel.size());
+                program.m_code.push_back({ OpCode::Fork, program.m_steps.size(), 0 });
+                program.m_steps.push_back(std::move(group));
+            }
+        }
+        program.m_main = { program.m_setup.end, program.m_code.size(), PhaseScope::Run };
+
+        // Virtual users of a burst wait at the barrier with the request of the first step rendered
+        if (program.m_burst.has_value() &&
+            (program.m_main.begin == program.m_main.end || program.m_code[program.m_main.begin].op != OpCode::Request ||
+             program.m_steps[program.m_code[program.m_main.begin].operand].cache.has_value()))
+        {
+            throw std::runtime_error(std::format("Burst scenario '{}' must start with a step that only sends a request, without condition, "
+                                                 "delay, loop, cache or parallel steps",
+                                                 scenario.getName()));
+        }
+
+        for (std::size_t index = 0; index < teardownIndices.size(); ++index)
+        {
+            program.emitStep(teardownIndices[index], scenario.getTeardown()[index]);
+        }
+        program.m_teardown = { program.m_main.end, program.m_code.size(), scenario.getTeardownScope() };
+
+        for (std::size_t stepIndex = 0; stepIndex < setupStepCount; ++stepIndex)
+        {
+            const StepCode& code = program.m_steps[stepIndex];
+            for (const auto* extractions : { &code.extractions, &code.streamedExtractions })
+            {
+                for (const auto& extraction : *extractions)
+                {
+                    program.m_sharedSlots.push_back(extraction.slot);
+                    for (const auto& [slot, group] : extraction.groups)
+                    {
+                        program.m_sharedSlots.push_back(slot);
+                    }
+                }
+            }
+        }
+        std::ranges::sort(program.m_sharedSlots);
+        program.m_sharedSlots.erase(std::unique(program.m_sharedSlots.begin(), program.m_sharedSlots.end()), program.m_sharedSlots.end());
+
+        std::vector<bool> read = program.collectReads();
+        for (std::size_t stepIndex = 0; stepIndex < program.m_steps.size(); ++stepIndex)
+        {
+            StepCode& code = program.m_steps[stepIndex];
+            for (auto& extraction : code.extractions)
+            {
+                extraction.live = read[extraction.slot] ||
+                                  std::ranges::any_of(extraction.groups, [&read](const auto& group) { return read[group.first]; });
+            }
+            code.lateValidation = program.m_continueOnError && stepIndex >= setupStepCount && stepIndex < mainStepEnd &&
+                                  code.validator.has_value() && !code.credential.has_value() && !code.refresh && !code.cache.has_value();
+        }
+
+        LOG_DEBUG_FMT(
+            "Compiled {} steps into {} instructions with {} variable slots and {} constants",
+            program.m_steps.size(),
+            program.m_code.size(),
+            program.m_table.size(),
+            program.m_constants.size());
+
+        return program;
+    }
+
+    VariableFrame Program::createFrame() const
+    {
+        VariableFrame frame(m_table.size());
+        for (const auto& [slot, value] : m_initialValues)
+        {
+            frame.set(slot, value);
+        }
+
+        return frame;
+    }
+
+    const std::string& Program::getName() const
+    {
+        return m_name;
+    }
+
+    const std::string& Program::getDescription() const
+    {
+        return m_description;
+    }
+
+    std::optional<int> Program::getRepeatCount() const
+    {
+        return m_repeatCount;
+    }
+
+    bool Program::getContinueOnError() const
+    {
+        return m_continueOnError;
+    }
+
+    std::size_t Program::getVirtualUsers() const
+    {
+        return m_virtualUsers;
+    }
+
+    std::uint64_t Program::getSeed() const
+    {
+        return m_seed;
+    }
+
+    std::optional<std::chrono::milliseconds> Program::getDuration() const
+    {
+        return m_duration;
+    }
+
+    const ThinkTime& Program::getThinkTime() const
+    {
+        return m_thinkTime;
+    }
+
+    std::optional<std::chrono::milliseconds> Program::getPacing() const
+    {
+        return m_pacing;
+    }
+
+    const std::optional<BurstPolicy>& Program::getBurst() const
+    {
+        return m_burst;
+    }
+
+    const std::optional<HttpCachePolicy>& Program::getHttpCache() const
+    {
+        return m_httpCache;
+    }
+
+    const VariableTable& Program::getTable() const
+    {
+        return m_table;
+    }
+
+    const std::string& Program::getString(StringId id) const
+    {
+        return m_strings[id];
+    }
+
+    const std::vector<Program::StepCode>& Program::getSteps() const
+    {
+        return m_steps;
+    }
+
+    const std::vector<Program::Instruction>& Program::getCode() const
+    {
+        return m_code;
+    }
+
+    const std::vector<Program::LoopCode>& Program::getLoops() const
+    {
+        return m_loops;
+    }
+
+    const std::vector<std::shared_ptr<const DataFeed>>& Program::getData() const
+    {
+        return m_data;
+    }
+
+    const std::vector<Program::CredentialCode>& Program::getCredentials() const
+    {
+        return m_credentials;
+    }
+
+    const std::vector<Program::CacheCode>& Program::getCaches() const
+    {
+        return m_caches;
+    }
+
+    const std::vector<Program::RateLimitCode>& Program::getRateLimits() const
+    {
+        return m_rateLimits;
+    }
+
+    const std::vector<Program::TargetCode>& Program::getTargets() const
+    {
+        return m_targets;
+    }
+
+    std::size_t Program::getParallelWidth() const
+    {
+        return m_parallelWidth;
+    }
+
+    const Program::Section& Program::getSection(Phase phase) const
+    {
+        switch (phase)
+        {
+        case Phase::Setup:
+            return m_setup;
+        case Phase::Teardown:
+            return m_teardown;
+        case Phase::Main:
+            break;
+        }
+
+        return m_main;
+    }
+
+    const std::vector<VariableSlot>& Program::getSharedSlots() const
+    {
+        return m_sharedSlots;
+    }
+
+    std::string Program::dump() const
+    {
+        std::string out;
+
+        out += std::format("program '{}' ({} virtual users, seed {})\n", m_name, m_virtualUsers, m_seed);
+        out += std::format(
+            "  {} steps, {} instructions, {} loops, {} slots, {} constants, {} strings\n",
+            m_steps.size(),
+            m_code.size(),
+            m_loops.size(),
+            m_table.size(),
+            m_constants.size(),
+            m_strings.size());
+        if (m_burst.has_value())
+        {
+            out += std::format("  {} burst rounds at least {} ms apart\n", m_burst->rounds, m_burst->interval.count());
+        }
+        else if (m_pacing.has_value())
+        {
+            out += std::format("  iterations paced every {} ms\n", m_pacing->count());
+        }
+        else
+        {
+            out += std::format("  think time between iterations: {}\n", m_thinkTime.describe());
+        }
+        if (m_httpCache.has_value())
+        {
+            out += std::format("  HTTP cache per virtual user of {} entries, {} bytes\n", m_httpCache->maxEntries, m_httpCache->maxBytes);
+        }
+
+        out += "\nslots:\n";
+        for (VariableSlot slot = 0; slot < m_table.size(); ++slot)
+        {
+            const std::string& name = m_table.getName(slot);
+            auto initial = std::find_if(
+                m_initialValues.begin(), m_initialValues.end(), [slot](const auto& value) { return value.first == slot; });
+
+            out += std::format("  ${:<4} {}", slot, name);
+            if (m_constants.contains(name))
+            {
+                out += std::format(" = \"{}\" (folded)", initial->second);
+            }
+            else if (initial != m_initialValues.end())
+            {
+                out += std::format(" = \"{}\"", initial->second);
+            }
+            out += "\n";
+        }
+
+        if (!m_data.empty())
+        {
+            out += "\ndata:\n";
+        }
+        for (const auto& feed : m_data)
+        {
+            out += std::format("  {} ({})\n", feed->getFile(), dataModeName(feed->getMode()));
+            for (std::size_t column = 0; column < feed->getColumns().size(); ++column)
+            {
+                for (VariableSlot slot : feed->getBindings()[column])
+                {
+                    out += std::format("      ${} <- column {} '{}'\n", slot, column, feed->getColumns()[column]);
+                }
+            }
+        }
+
+        if (!m_targets.empty())
+        {
+            out += "\ntargets:\n";
+        }
+        for (std::size_t index = 0; index < m_targets.size(); ++index)
+        {
+            const TargetCode& target = m_targets[index];
+            out += std::format("  T{:<3} {} ({}", index, target.group->getName(), balanceName(target.group->getBalance()));
+            out += target.key.has_value() ? std::format(" by {})\n", describe(target.key.value(), m_table)) : ")\n";
+            for (std::size_t node = 0; node < target.group->getNodes().size(); ++node)
+            {
+                const TargetGroup::Node& entry = target.group->getNodes()[node];
+                out += std::format(
+                    "      node {:<3} {}{}\n", target.firstNode + node, entry.label, entry.host.empty() ? "" : ", Host: " + entry.host);
+            }
+        }
+
+        if (!m_rateLimits.empty())
+        {
+            out += "\nrate limits:\n";
+        }
+        for (std::size_t index = 0; index < m_rateLimits.size(); ++index)
+        {
+            const RateLimitCode& limit = m_rateLimits[index];
+            out += std::format("  R{:<3} {:g}/s, burst {}, {} when limited",
+                               index,
+                               limit.bucket->getRate(),
+                               limit.bucket->getBurst(),
+                               limit.action == RateLimitAction::Wait ? "wait" : "skip");
+            out += limit.match.has_value() ? std::format(", URLs matching {}\n", limit.match->getSource()) : "\n";
+        }
+
+        out += "\nstrings:\n";
+        for (StringId id = 0; id < m_strings.size(); ++id)
+        {
+            out += std::format("  #{:<4} \"{}\"\n", id, m_strings[id]);
+        }
+
+        out += "\nsteps:\n";
+        for (std::size_t index = 0; index < m_steps.size(); ++index)
+        {
+            const StepCode& step = m_steps[index];
+
+            if (!step.parallel.empty())
+            {
+                out += std::format("  [{}] {} (parallel)\n", index, getString(step.name));
+                for (std::size_t branch : step.parallel)
+                {
+                    out += std::format("      branch  [{}] {}\n", branch, getString(m_steps[branch].name));
+                }
+                if (step.condition.has_value())
+                {
+                    out += std::format("      if      {} ({} nodes)\n", step.condition->getSource(), step.condition->getNodes().size());
+                }
+                continue;
+            }
+
+            out += std::format("  [{}] {} (timeout {} s)\n", index, getString(step.name), step.timeout);
+            if (step.origin.has_value())
+            {
+                std::string origin;
+                step.origin->appendOrigin(origin);
+                out += std::format("      origin  {} (pre-split)\n", origin);
+                out += std::format("      path    {} {}\n", getString(step.method), describe(step.url, m_table));
+            }
+            else
+            {
+                out += std::format("      url     {} {} (parsed per request)\n", getString(step.method), describe(step.url, m_table));
+            }
+
+            for (const auto& [name, value] : step.headers)
+            {
+                out += std::format("      header  #{} = {}\n", name, describe(value, m_table));
+            }
+            for (const auto& [name, value] : step.queryParams)
+            {
+                out += std::format("      query   #{} = {}\n", name, describe(value, m_table));
+            }
+            if (step.body.has_value())
+            {
+                out += std::format("      body    {}\n", describe(step.body.value(), m_table));
+            }
+            for (const auto& extraction : step.streamedExtractions)
+            {
+                out += std::format("      extract ${} <- {} (streamed)\n", extraction.slot, extraction.extractor.getRule());
+            }
+            for (const auto& extraction : step.extractions)
+            {
+                out += std::format(
+                    "      extract ${} <- {} {}",
+                    extraction.slot,
+                    kindName(extraction.extractor.getKind()),
+                    extraction.extractor.getRule());
+                for (std::size_t i = 1; i < extraction.groups.size(); ++i)
+                {
+                    out += std::format(", ${} <- group {}", extraction.groups[i].first, extraction.groups[i].second);
+                }
+                out += extraction.live ? "\n" : " (never read)\n";
+            }
+            if (step.condition.has_value())
+            {
+                out += std::format("      if      {} ({} nodes)\n", step.condition->getSource(), step.condition->getNodes().size());
+            }
+            if (step.validator.has_value())
+            {
+                out += std::format("      checks  {}{}{}\n",
+                                   step.validator->size(),
+                                   step.validator->needsDocument() ? " (parses body)" : "",
+                                   step.lateValidation ? " (may run late)" : "");
+            }
+            if (step.credential.has_value())
+            {
+                const CredentialCode& credential = m_credentials[step.credential.value()];
+                std::string expiry = "never expires";
+                if (credential.ttl.has_value())
+                {
+                    expiry = std::format("ttl {} ms", credential.ttl->count());
+                }
+                else if (credential.expiresIn.has_value())
+                {
+                    expiry = std::format("expires in ${} s", credential.expiresIn.value());
+                }
+                out += std::format(
+                    "      pool    {} credentials of {} slots, {}, renewed {} ms ahead",
+                    credential.store->size(),
+                    credential.slots.size(),
+                    expiry,
+                    credential.refreshBefore.count());
+                if (credential.refresh.has_value())
+                {
+                    out += std::format(", refresh [{}]", credential.refresh.value());
+                }
+                out += "\n";
+            }
+            if (step.refresh)
+            {
+                out += "      (sent only to refresh a credential)\n";
+            }
+            if (step.cache.has_value())
+            {
+                const CacheCode& cache = m_caches[step.cache.value()];
+                out += std::format("      cache   {} slots, {}, {}\n",
+                                   cache.slots.size(),
+                                   cache.shared != nullptr ? "global" : "per virtual user",
+                                   cache.ttl.has_value() ? std::format("ttl {} ms", cache.ttl->count()) : "never expires");
+            }
+            if (step.rateLimit.has_value())
+            {
+                out += std::format("      limit   R{}\n", step.rateLimit.value());
+            }
+            if (step.target.has_value())
+            {
+                out += std::format("      target  T{}\n", step.target.value());
+            }
+        }
+
+        if (!m_loops.empty())
+        {
+            out += "\nloops:\n";
+        }
+        for (std::size_t index = 0; index < m_loops.size(); ++index)
+        {
+            const LoopCode& loop = m_loops[index];
+            if (loop.items.has_value())
+            {
+                out += std::format(
+                    "  L{:<3} [{}] foreach {} as ${}:{}, index ${}\n",
+                    index,
+                    loop.step,
+                    describe(loop.items.value(), m_table),
+                    loop.itemSlot,
+                    m_table.getName(loop.itemSlot),
+                    loop.indexSlot);
+            }
+            else
+            {
+                out += std::format("  L{:<3} [{}] loop {} times, index ${}\n", index, loop.step, loop.count, loop.indexSlot);
+            }
+        }
+
+        out += "\ncode:\n";
+        for (std::size_t pc = 0; pc < m_code.size(); ++pc)
+        {
+            const Instruction& instruction = m_code[pc];
+
+            if (pc == m_setup.begin && m_setup.end > m_setup.begin)
+            {
+                out += std::format("  setup ({})\n", m_setup.scope == PhaseScope::Run ? "once per run" : "once per virtual user");
+            }
+            if (pc == m_main.begin && (m_setup.end > m_setup.begin || m_teardown.end > m_teardown.begin))
+            {
+                out += "  main\n";
+            }
+            if (pc == m_teardown.begin)
+            {
+                out += std::format("  teardown ({})\n", m_teardown.scope == PhaseScope::Run ? "once per run" : "once per virtual user");
+            }
+
+            switch (instruction.op)
+            {
+            case OpCode::Delay:
+                out += std::format(
+                    "  {:04}  DELAY    [{}] {}\n", pc, instruction.operand, m_steps[instruction.operand].delay->describe());
+                break;
+            case OpCode::Branch:
+                out += std::format("  {:04}  BRANCH   [{}] unless condition -> {:04}\n", pc, instruction.operand, instruction.target);
+                break;
+            case OpCode::Request:
+                out += std::format("  {:04}  REQUEST  [{}] {}\n", pc, instruction.operand, getString(m_steps[instruction.operand].name));
+                break;
+            case OpCode::Loop:
+                out += std::format("  {:04}  LOOP     L{} else -> {:04}\n", pc, instruction.operand, instruction.target);
+                break;
+            case OpCode::Next:
+                out += std::format("  {:04}  NEXT     L{} -> {:04}\n", pc, instruction.operand, instruction.target);
+                break;
+            case OpCode::Lease:
+                out += std::format("  {:04}  LEASE    [{}] {}\n", pc, instruction.operand, getString(m_steps[instruction.operand].name));
+                break;
+            case OpCode::Fork:
+                out += std::format(
+                    "  {:04}  FORK     [{}] {} x{}\n",
+                    pc,
+                    instruction.operand,
+                    getString(m_steps[instruction.operand].name),
+                    m_steps[instruction.operand].parallel.size());
+                break;
+            }
+        }
+        out += std::format("  {:04}  END\n", m_code.size());
+
+        return out;
+    }
+
+    Program::StepCode Program::compileStep(
+        const Step& step, std::vector<std::pair<std::string, Extractor>>& extractors, bool jsonStreaming)
+    {
+        StepCode code;
+        code.name = intern(step.name);
+        code.description = step.description;
+        code.delay = step.delay;
+
+        if (step.rateLimit.has_value())
+        {
+            code.rateLimit = m_rateLimits.size();
+            m_rateLimits.push_back(
+                { std::make_shared<TokenBucket>(step.rateLimit->rate, step.rateLimit->burst), step.rateLimit->action, std::nullopt });
+        }
+
+        if (step.condition.has_value() && !step.condition->empty())
+        {
+            code.condition = Condition::compile(step.condition.value(), m_table);
+        }
+
+        if (!step.parallel.empty())
+        {
+            return code;
+        }
+
+        code.method = intern(step.request.getMethod());
+        code.timeout = step.request.getTimeout();
+
+        code.url = Template::compile(step.request.getUrl(), m_table, m_constants);
+        if (step.target.has_value())
+        {
+            auto it =
+                std::ranges::find_if(m_targets, [&step](const TargetCode& target) { return target.group->getName() == step.target; });
+            if (it == m_targets.end())
+            {
+                throw std::runtime_error(std::format("Step '{}' sends to unknown target group '{}'", step.name, step.target.value()));
+            }
+            if (!step.request.getUrl().starts_with('/'))
+            {
+                throw std::runtime_error(std::format(
+                    "Step '{}' sends to target group '{}', so its url must be a path starting with '/'", step.name, step.target.value()));
+            }
+            code.target = static_cast<std::size_t>(it - m_targets.begin());
+        }
+        else if (auto split = splitOrigin(code.url))
+        {
+            code.origin = std::move(split->first);
+            code.url = Template::compile(split->second, m_table);
+        }
+
+        for (const auto& [name, value] : step.request.getHeaders())
+        {
+            code.headers.emplace_back(intern(name), Template::compile(value, m_table, m_constants));
+        }
+
+        if (step.request.getBody().has_value())
+        {
+            code.body = step.bodyJson ? Template::compileJson(step.request.getBody().value(), m_table, m_constants)
+                                      : Template::compile(step.request.getBody().value(), m_table, m_constants);
+        }
+
+        for (const auto& [name, value] : step.request.getQueryParams())
+        {
+            code.queryParams.emplace_back(intern(name), Template::compile(value, m_table, m_constants));
+        }
+
+        if (step.expectedResponse.has_value())
+        {
+            code.validator = ResponseValidator::compile(step.expectedResponse.value());
+        }
+
+        // The body is streamed only when no validator needs the whole document and every JSON path can be resolved in one pass
+        bool needsDocument = code.validator.has_value() && code.validator->needsDocument();
+        bool streamJson = jsonStreaming && !needsDocument;
+
+        std::vector<Extraction> extractions;
+        for (auto& [varName, extractor] : extractors)
+        {
+            Extraction extraction;
+            extraction.slot = m_table.intern(varName);
+            extraction.extractor = std::move(extractor);
+
+            if (extraction.extractor.getKind() == Extractor::Kind::JsonPath &&
+                !JsonStreamSelector::supports(extraction.extractor.getPath()))
+            {
+                streamJson = false;
+            }
+
+            if (extraction.extractor.getKind() == Extractor::Kind::Regex)
+            {
+                // The variable takes the group named after it, or the first group; other named groups become variables of their own
+                std::size_t primaryGroup = 1;
+                for (const auto& [groupName, groupIndex] : extraction.extractor.getPattern().getNamedGroups())
+                {
+                    if (groupName == varName)
+                    {
+                        primaryGroup = groupIndex;
+                    }
+                    else
+                    {
+                        extraction.groups.emplace_back(m_table.intern(groupName), groupIndex);
+                    }
+                }
+                extraction.groups.emplace(extraction.groups.begin(), extraction.slot, primaryGroup);
+            }
+
+            extractions.push_back(std::move(extraction));
+        }
+
+        for (auto& extraction : extractions)
+        {
+            if (streamJson && extraction.extractor.getKind() == Extractor::Kind::JsonPath)
+            {
+                code.jsonStream.addPath(extraction.extractor.getPath());
+                code.streamedExtractions.push_back(std::move(extraction));
+            }
+            else
+            {
+                code.extractions.push_back(std::move(extraction));
+            }
+        }
+
+        return code;
+    }
+
+    void Program::collectSlots(std::size_t stepIndex, std::vector<VariableSlot>& slots) const
+    {
+        const StepCode& code = m_steps[stepIndex];
+        for (const auto* extractions : { &code.extractions, &code.streamedExtractions })
+        {
+            for (const auto& extraction : *extractions)
+            {
+                slots.push_back(extraction.slot);
+                for (const auto& [slot, group] : extraction.groups)
+                {
+                    slots.push_back(slot);
+                }
+            }
+        }
+    }
+
+    std::vector<bool> Program::collectReads() const
+    {
+        std::vector<bool> read(m_table.size());
+        for (const auto& step : m_steps)
+        {
+            markReads(step.url, read);
+            for (const auto* templates : { &step.headers, &step.queryParams })
+            {
+                for (const auto& [name, value] : *templates)
+                {
+                    markReads(value, read);
+                }
+            }
+            if (step.body.has_value())
+            {
+                markReads(step.body.value(), read);
+            }
+            if (step.condition.has_value())
+            {
+                for (const auto& node : step.condition->getNodes())
+                {
+                    if (node.kind == Condition::NodeKind::Variable)
+                    {
+                        read[node.slot] = true;
+                    }
+                }
+            }
+        }
+        for (const auto& loop : m_loops)
+        {
+            if (loop.items.has_value())
+            {
+                markReads(loop.items.value(), read);
+            }
+        }
+        for (const auto& target : m_targets)
+        {
+            if (target.key.has_value())
+            {
+                markReads(target.key.value(), read);
+            }
+        }
+
+        // Published variables are read by whoever replays them
+        for (const auto& credential : m_credentials)
+        {
+            for (VariableSlot slot : credential.slots)
+            {
+                read[slot] = true;
+            }
+            if (credential.expiresIn.has_value())
+            {
+                read[credential.expiresIn.value()] = true;
+            }
+        }
+        for (const auto& cache : m_caches)
+        {
+            for (VariableSlot slot : cache.slots)
+            {
+                read[slot] = true;
+            }
+        }
+        for (VariableSlot slot : m_sharedSlots)
+        {
+            read[slot] = true;
+        }
+        return read;
+    }
+
+    void Program::compileCredentials(const std::vector<std::pair<std::size_t, const Step*>>& steps)
+    {
+        for (const auto& [stepIndex, step] : steps)
+        {
+            if (!step->credentials.has_value())
+            {
+                continue;
+            }
+            const CredentialPolicy& policy = step->credentials.value();
+
+            CredentialCode credential;
+            credential.store = std::make_shared<CredentialStore>(policy.pool);
+            credential.ttl = policy.ttl;
+            credential.refreshBefore = policy.refreshBefore;
+            if (policy.expiresIn.has_value())
+            {
+                credential.expiresIn = m_table.intern(policy.expiresIn.value());
+            }
+            collectSlots(stepIndex, credential.slots);
+
+            if (policy.refresh.has_value())
+            {
+                const std::string& refreshName = policy.refresh.value();
+                auto it = std::ranges::find_if(steps, [&refreshName](const auto& other) { return other.second->name == refreshName; });
+                if (it == steps.end() || !it->second->parallel.empty() || it->second->credentials.has_value())
+                {
+                    throw std::runtime_error(
+                        std::format("Credentials of step '{}' are refreshed by '{}', which is not a plain step", step->name, refreshName));
+                }
+
+                credential.refresh = it->first;
+                m_steps[it->first].refresh = true;
+                collectSlots(it->first, credential.slots);
+            }
+
+            std::ranges::sort(credential.slots);
+            credential.slots.erase(std::unique(credential.slots.begin(), credential.slots.end()), credential.slots.end());
+
+            m_steps[stepIndex].credential = m_credentials.size();
+            m_credentials.push_back(std::move(credential));
+        }
+    }
+
+    void Program::compileCaches(const std::vector<std::pair<std::size_t, const Step*>>& steps)
+    {
+        // the steps of a parallel group follow the group
+        std::vector<std::pair<std::size_t, const Step*>> all;
+        for (const auto& [stepIndex, step] : steps)
+        {
+            all.emplace_back(stepIndex, step);
+            for (std::size_t branch = 0; branch < step->parallel.size(); ++branch)
+            {
+                all.emplace_back(stepIndex + 1 + branch, &step->parallel[branch]);
+            }
+        }
+
+        for (const auto& [stepIndex, step] : all)
+        {
+            if (!step->cache.has_value())
+            {
+                continue;
+            }
+
+            CacheCode cache;
+            if (step->cache->scope == CacheScope::Global)
+            {
+                cache.shared = std::make_shared<CredentialStore>(1);
+            }
+            cache.ttl = step->cache->ttl;
+            collectSlots(stepIndex, cache.slots);
+            std::ranges::sort(cache.slots);
+            cache.slots.erase(std::unique(cache.slots.begin(), cache.slots.end()), cache.slots.end());
+
+            m_steps[stepIndex].cache = m_caches.size();
+            m_caches.push_back(std::move(cache));
+        }
+    }
+
+    void Program::emitStep(std::size_t stepIndex, const Step& step)
+    {
+        const StepCode& code = m_steps[stepIndex];
+        if (code.refresh)
+        {
+            return;
+        }
+
+        std::size_t loopStart = 0;
+        bool looped = step.loop.has_value() || step.foreach.has_value();
+        if (looped)
+        {
+            LoopCode loop;
+            loop.step = stepIndex;
+            loop.count = step.loop.value_or(0);
+            loop.indexSlot = m_table.intern(LOOP_INDEX_VARIABLE);
+            if (step.foreach.has_value())
+            {
+                loop.items = Template::compile(step.foreach.value(), m_table, m_constants);
+                loop.itemSlot = m_table.intern(step.itemVariable);
+            }
+
+            loopStart = m_code.size();
+            m_code.push_back({ OpCode::Loop, m_loops.size(), 0 });
+            m_loops.push_back(std::move(loop));
+        }
+
+        if (code.delay.has_value())
+        {
+            m_code.push_back({ OpCode::Delay, stepIndex, 0 });
+        }
+
+        std::size_t branch = m_code.size();
+        if (code.condition.has_value())
+        {
+            m_code.push_back({ OpCode::Branch, stepIndex, 0 });
+        }
+
+        OpCode op = code.credential.has_value() ? OpCode::Lease : OpCode::Request;
+        m_code.push_back({ code.parallel.empty() ? op : OpCode::Fork, stepIndex, 0 });
+
+        if (code.condition.has_value())
+        {
+            m_code[branch].target = m_code.size();
+        }
+
+        if (looped)
+        {
+            m_code.push_back({ OpCode::Next, m_code[loopStart].operand, loopStart + 1 });
+            m_code[loopStart].target = m_code.size();
+        }
+    }
+
+    Program::StringId Program::intern(const std::string& value)
+    {
+        auto it = std::find(m_strings.begin(), m_strings.end(), value);
+        if (it != m_strings.end())
+        {
+            return static_cast<StringId>(it - m_strings.begin());
+        }
+
+        m_strings.push_back(value);
+        return m_strings.size() - 1;
+    }
+} // namespace zaplet::scenario
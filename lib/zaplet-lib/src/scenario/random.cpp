@@ -0,0 +1,92 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/random.h"
+
+#include <bit>
+#include <random>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        std::uint64_t splitMix(std::uint64_t& state)
+        {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+    } // namespace
+
+    Random::Random()
+    {
+        std::random_device device;
+        seed((static_cast<std::uint64_t>(device()) << 32) | device());
+    }
+
+    Random::Random(std::uint64_t seed)
+    {
+        this->seed(seed);
+    }
+
+    Random& Random::local()
+    {
+        thread_local Random random;
+        return random;
+    }
+
+    std::uint64_t Random::mix(std::uint64_t seed, std::uint64_t stream)
+    {
+        std::uint64_t state = seed ^ splitMix(stream);
+        return splitMix(state);
+    }
+
+    void Random::seed(std::uint64_t seed)
+    {
+        for (auto& word : m_state)
+        {
+            word = splitMix(seed);
+        }
+    }
+
+    std::uint64_t Random::next()
+    {
+        std::uint64_t result = std::rotl(m_state[1] * 5, 7) * 9;
+        std::uint64_t t = m_state[1] << 17;
+
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = std::rotl(m_state[3], 45);
+
+        return result;
+    }
+
+    std::uint64_t Random::below(std::uint64_t bound)
+    {
+        if (bound == 0)
+        {
+            return 0;
+        }
+
+        // Rejecting the lowest 2^64 mod bound values removes the modulo bias
+        std::uint64_t threshold = (0 - bound) % bound;
+        std::uint64_t value = next();
+        while (value < threshold)
+        {
+            value = next();
+        }
+
+        return value % bound;
+    }
+
+    double Random::uniform()
+    {
+        // The top 53 bits fill the mantissa of a double
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+} // namespace zaplet::scenario
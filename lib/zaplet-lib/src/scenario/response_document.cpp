@@ -0,0 +1,42 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/response_document.h"
+
+#include <nlohmann/json.hpp>
+
+namespace zaplet::scenario
+{
+    ResponseDocument::ResponseDocument(const http::Response& response)
+        : m_response(response)
+    {
+    }
+
+    ResponseDocument::~ResponseDocument() = default;
+
+    const http::Response& ResponseDocument::getResponse() const
+    {
+        return m_response;
+    }
+
+    const nlohmann::json* ResponseDocument::getJson()
+    {
+        if (!m_parsed)
+        {
+            m_parsed = true;
+
+            auto json = nlohmann::json::parse(m_response.getBody(), nullptr, false);
+            if (json.is_discarded())
+            {
+                LOG_DEBUG("Response body is not valid JSON");
+            }
+            else
+            {
+                m_json = std::make_unique<nlohmann::json>(std::move(json));
+            }
+        }
+
+        return m_json.get();
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,168 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/response_pipeline.h"
+
+#include "zaplet/logging/logger.h"
+#include "zaplet/scenario/response_document.h"
+
+#include <string>
+#include <string_view>
+
+namespace zaplet::scenario
+{
+    ResponsePipeline::ResponsePipeline(std::size_t workers, std::size_t capacity)
+        : m_queue(capacity)
+    {
+        m_workers.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i)
+        {
+            m_workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ResponsePipeline::~ResponsePipeline()
+    {
+        m_stopping.store(true, std::memory_order_release);
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_all();
+        m_workers.clear();
+    }
+
+    void ResponsePipeline::submit(Job& job)
+    {
+        job.depth = m_queue.size();
+        job.queued = std::chrono::steady_clock::now();
+        job.sink->pending.fetch_add(1, std::memory_order_relaxed);
+
+        if (!m_queue.tryPush(job))
+        {
+            process(job, true);
+            return;
+        }
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_one();
+    }
+
+    void ResponsePipeline::await(Sink& sink)
+    {
+        for (std::size_t pending = sink.pending.load(std::memory_order_acquire); pending != 0;
+             pending = sink.pending.load(std::memory_order_acquire))
+        {
+            sink.pending.wait(pending, std::memory_order_acquire);
+        }
+    }
+
+    std::size_t ResponsePipeline::getWorkers() const
+    {
+        return m_workers.size();
+    }
+
+    void ResponsePipeline::work()
+    {
+        Job job;
+        while (true)
+        {
+            // read before looking at the queue, so a push after an empty look still changes it
+            std::uint32_t signal = m_signal.load(std::memory_order_acquire);
+            if (m_queue.tryPop(job))
+            {
+                process(job, false);
+                job = Job();
+                continue;
+            }
+            if (m_stopping.load(std::memory_order_acquire))
+            {
+                return;
+            }
+            m_signal.wait(signal, std::memory_order_acquire);
+        }
+    }
+
+    void ResponsePipeline::process(Job& job, bool inlined)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const Program::StepCode& step = *job.step;
+        const VariableTable& table = job.program->getTable();
+        const http::Response& response = *job.response;
+        ResponseDocument document(response);
+
+        if (job.extract)
+        {
+            std::string extracted;
+            std::vector<std::string_view> groups;
+            for (const auto& extraction : step.extractions)
+            {
+                if (extraction.live)
+                {
+                    continue;
+                }
+
+                try
+                {
+                    if (extraction.extractor.getKind() == Extractor::Kind::Regex)
+                    {
+                        if (!extraction.extractor.getPattern().search(response.getBody(), groups))
+                        {
+                            LOG_WARNING_FMT("Regex pattern {} did not match", extraction.extractor.getPattern().getSource());
+                            continue;
+                        }
+                        for (const auto& [slot, group] : extraction.groups)
+                        {
+                            if (groups[group].data() != nullptr)
+                            {
+                                LOG_DEBUG_FMT("Extracted variable '{}' = '{}' using regex", table.getName(slot), groups[group]);
+                            }
+                        }
+                    }
+                    else if (extraction.extractor.extract(document, extracted))
+                    {
+                        LOG_DEBUG_FMT("Extracted variable '{}' = '{}' using rule {}",
+                                      table.getName(extraction.slot),
+                                      extracted,
+                                      extraction.extractor.getRule());
+                    }
+                } catch (const std::exception& e)
+                {
+                    LOG_ERROR_FMT("Error extracting variable {}: {}", table.getName(extraction.slot), e.what());
+                }
+            }
+        }
+
+        bool valid = true;
+        try
+        {
+            valid = !job.validate || step.validator->validate(document);
+            if (!valid)
+            {
+                LOG_ERROR_FMT("Step '{}' failed validation", job.program->getString(step.name));
+            }
+            if (http::isResponsePrinted(response.getStatusCode()))
+            {
+                http::printResponse(job.formatter->format(response), response.getStatusCode());
+            }
+        } catch (const std::exception& e)
+        {
+            LOG_ERROR_FMT("Exception during response processing: {}", e.what());
+            valid = false;
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        Sink& sink = *job.sink;
+        {
+            std::lock_guard lock(sink.mutex);
+            sink.metrics.recordStage(Metrics::Stage::Process, end - start, inlined ? std::chrono::nanoseconds(0) : start - job.queued);
+            sink.metrics.recordQueue(Metrics::Stage::Process, job.depth, inlined);
+        }
+        // a response that failed anyway was already counted as a failed request
+        if (!valid && response.isSuccess())
+        {
+            sink.failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (sink.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            sink.pending.notify_all();
+        }
+    }
+} // namespace zaplet::scenario
@@ -0,0 +1,255 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/runner.h"
+
+#include "zaplet/logging/logger.h"
+#include "zaplet/scenario/player.h"
+
+#include <algorithm>
+#include <stop_token>
+#include <thread>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // How often the calling thread looks at the deadline, the stop requests and the finished virtual users
+        constexpr std::chrono::milliseconds SUPERVISION_INTERVAL{ 10 };
+
+        // Responses that may wait for each pipeline worker; beyond them the virtual users process their responses themselves,
+        // which keeps the backlog short enough to drain quickly when the run stops
+        constexpr std::size_t PIPELINE_QUEUE_PER_WORKER = 64;
+
+        static_assert(std::atomic<int>::is_always_lock_free, "Runner::requestStop must be async-signal-safe");
+    } // namespace
+
+    Runner::Runner(std::shared_ptr<http::Client> client, std::shared_ptr<output::Formatter> formatter)
+        : m_client(std::move(client))
+        , m_formatter(std::move(formatter))
+    {
+    }
+
+    bool Runner::run(std::shared_ptr<const Program> program, std::size_t virtualUsers)
+    {
+        std::vector<Flow> flows(1);
+        flows.front().name = program->getName();
+        flows.front().program = std::move(program);
+        flows.front().virtualUsers = virtualUsers;
+        return run(flows);
+    }
+
+    bool Runner::run(std::vector<Flow>& flows)
+    {
+        struct VirtualUser
+        {
+            std::size_t flow = 0;
+            std::unique_ptr<Player> player;
+            bool success = false;
+        };
+
+        std::stop_source drainSource;
+        std::stop_source abortSource;
+
+        std::optional<std::chrono::milliseconds> duration = m_duration;
+        for (const auto& flow : flows)
+        {
+            auto flowDuration = flow.program->getDuration();
+            if (!m_duration.has_value() && flowDuration.has_value())
+            {
+                duration = std::max(duration.value_or(flowDuration.value()), flowDuration.value());
+            }
+        }
+
+        std::shared_ptr<ResponsePipeline> pipeline;
+        if (m_pipelineWorkers > 0)
+        {
+            pipeline = std::make_shared<ResponsePipeline>(m_pipelineWorkers, m_pipelineWorkers * PIPELINE_QUEUE_PER_WORKER);
+        }
+
+        // Run-scope setup happens before any thread starts, so its variables are read by the virtual users without locking
+        std::vector<std::unique_ptr<Player>> setupPlayers(flows.size());
+        bool setupSuccess = true;
+
+        std::vector<VirtualUser> users;
+        for (std::size_t flow = 0; flow < flows.size(); ++flow)
+        {
+            if (abortSource.stop_requested())
+            {
+                break;
+            }
+
+            Flow& current = flows[flow];
+            current.virtualUsers = std::max<std::size_t>(current.virtualUsers, 1);
+            current.metrics.reset();
+
+            LOG_INFO_FMT("Scenario '{}': {} virtual users, run seed: {}", current.name, current.virtualUsers, current.program->getSeed());
+
+            Player::SharedVariables shared;
+            const auto& setup = current.program->getSection(Program::Phase::Setup);
+            const auto& teardown = current.program->getSection(Program::Phase::Teardown);
+            if ((setup.scope == PhaseScope::Run && setup.end > setup.begin) ||
+                (teardown.scope == PhaseScope::Run && teardown.end > teardown.begin))
+            {
+                auto& player = setupPlayers[flow];
+                player = std::make_unique<Player>(m_client, m_formatter);
+                player->setStopTokens({}, abortSource.get_token());
+                if (!supervise("setup", [&]() { return player->runSetup(current.program); }, abortSource))
+                {
+                    LOG_ERROR_FMT("Setup of scenario '{}' failed, its virtual users are not started", current.name);
+                    player.reset();
+                    setupSuccess = false;
+                    continue;
+                }
+                shared = player->getSharedVariables();
+            }
+
+            std::shared_ptr<BurstBarrier> burst;
+            if (const auto& policy = current.program->getBurst(); policy.has_value())
+            {
+                LOG_INFO_FMT("Scenario '{}' sends bursts of {} requests", current.name, current.virtualUsers);
+                burst = std::make_shared<BurstBarrier>(current.virtualUsers, policy->interval);
+            }
+
+            for (std::size_t index = 0; index < current.virtualUsers; ++index)
+            {
+                auto& user = users.emplace_back(VirtualUser{ flow, std::make_unique<Player>(m_client, m_formatter), false });
+                user.player->setVirtualUser(index, current.virtualUsers);
+                user.player->setSharedVariables(shared);
+                user.player->setBurstBarrier(burst);
+                user.player->setStopTokens(drainSource.get_token(), abortSource.get_token());
+                user.player->setPipeline(pipeline);
+            }
+        }
+
+        if (abortSource.stop_requested())
+        {
+            LOG_WARNING("Stop requested during setup, the virtual users are not started");
+            users.clear();
+            setupSuccess = false;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        {
+            std::atomic<std::size_t> finished{ 0 };
+            std::vector<std::jthread> threads;
+            threads.reserve(users.size());
+            for (auto& user : users)
+            {
+                threads.emplace_back(
+                    [&user, &flows, &finished]()
+                    {
+                        user.success = user.player->play(flows[user.flow].program);
+                        finished.fetch_add(1, std::memory_order_release);
+                    });
+            }
+
+            auto deadline = duration.has_value() ? startTime + duration.value() : std::chrono::steady_clock::time_point::max();
+            std::optional<std::chrono::steady_clock::time_point> drainStart;
+            while (finished.load(std::memory_order_acquire) < users.size())
+            {
+                auto now = std::chrono::steady_clock::now();
+                int stopRequests = m_stopRequests.load(std::memory_order_relaxed);
+
+                if (!drainStart.has_value() && (stopRequests > 0 || now >= deadline))
+                {
+                    if (stopRequests > 0)
+                    {
+                        LOG_WARNING_FMT("Stop requested, waiting up to {} ms for the running iterations", m_gracePeriod.count());
+                    }
+                    else
+                    {
+                        LOG_INFO_FMT(
+                            "Run duration of {} ms is over, waiting up to {} ms for the running iterations",
+                            duration->count(),
+                            m_gracePeriod.count());
+                    }
+                    drainSource.request_stop();
+                    drainStart = now;
+                }
+
+                bool graceOver = drainStart.has_value() && (stopRequests > 1 || now - drainStart.value() >= m_gracePeriod);
+                if (graceOver && !abortSource.stop_requested())
+                {
+                    LOG_WARNING("Abandoning the running iterations");
+                    abortSource.request_stop();
+                }
+
+                std::this_thread::sleep_for(SUPERVISION_INTERVAL);
+            }
+        }
+        m_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+
+        std::size_t succeeded = 0;
+        for (const auto& user : users)
+        {
+            flows[user.flow].metrics.merge(user.player->getMetrics());
+            succeeded += user.success ? 1 : 0;
+        }
+
+        for (auto& player : setupPlayers)
+        {
+            if (player != nullptr && !abortSource.stop_requested() &&
+                !supervise("teardown", [&player]() { return player->runTeardown(); }, abortSource))
+            {
+                setupSuccess = false;
+            }
+        }
+
+        if (users.size() > 1)
+        {
+            LOG_INFO_FMT("{} of {} virtual users completed successfully", succeeded, users.size());
+        }
+        return setupSuccess && succeeded == users.size();
+    }
+
+    bool Runner::supervise(std::string_view phase, const std::function<bool()>& play, std::stop_source& abort)
+    {
+        int stopRequests = m_stopRequests.load(std::memory_order_relaxed);
+        std::atomic<bool> finished{ false };
+        bool success = false;
+
+        std::jthread thread(
+            [&]()
+            {
+                success = play();
+                finished.store(true, std::memory_order_release);
+            });
+        while (!finished.load(std::memory_order_acquire))
+        {
+            if (m_stopRequests.load(std::memory_order_relaxed) > stopRequests && !abort.stop_requested())
+            {
+                LOG_WARNING_FMT("Stop requested, abandoning the {}", phase);
+                abort.request_stop();
+            }
+            std::this_thread::sleep_for(SUPERVISION_INTERVAL);
+        }
+        return success;
+    }
+
+    std::chrono::milliseconds Runner::getElapsed() const
+    {
+        return m_elapsed;
+    }
+
+    void Runner::setDuration(const std::optional<std::chrono::milliseconds>& duration)
+    {
+        m_duration = duration;
+    }
+
+    void Runner::setGracePeriod(std::chrono::milliseconds gracePeriod)
+    {
+        m_gracePeriod = gracePeriod;
+    }
+
+    void Runner::setPipelineWorkers(std::size_t workers)
+    {
+        m_pipelineWorkers = workers;
+    }
+
+    void Runner::requestStop()
+    {
+        m_stopRequests.fetch_add(1, std::memory_order_relaxed);
+    }
+} // namespace zaplet::scenario
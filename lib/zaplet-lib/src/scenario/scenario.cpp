@@ -75,4 +75,156 @@ namespace zaplet::scenario
     {
         m_continueOnError = continue_;
     }
+
+    bool Scenario::getJsonStreaming() const
+    {
+        return m_jsonStreaming;
+    }
+
+    void Scenario::setJsonStreaming(bool streaming)
+    {
+        m_jsonStreaming = streaming;
+    }
+
+    bool Scenario::getAutoParallel() const
+    {
+        return m_autoParallel;
+    }
+
+    void Scenario::setAutoParallel(bool autoParallel)
+    {
+        m_autoParallel = autoParallel;
+    }
+
+    const std::vector<DataSource>& Scenario::getData() const
+    {
+        return m_data;
+    }
+
+    void Scenario::setData(const std::vector<DataSource>& data)
+    {
+        m_data = data;
+    }
+
+    std::size_t Scenario::getVirtualUsers() const
+    {
+        return m_virtualUsers;
+    }
+
+    void Scenario::setVirtualUsers(std::size_t virtualUsers)
+    {
+        m_virtualUsers = virtualUsers;
+    }
+
+    std::optional<std::uint64_t> Scenario::getSeed() const
+    {
+        return m_seed;
+    }
+
+    void Scenario::setSeed(const std::optional<std::uint64_t>& seed)
+    {
+        m_seed = seed;
+    }
+
+    const ThinkTime& Scenario::getThinkTime() const
+    {
+        return m_thinkTime;
+    }
+
+    void Scenario::setThinkTime(const ThinkTime& thinkTime)
+    {
+        m_thinkTime = thinkTime;
+    }
+
+    std::optional<std::chrono::milliseconds> Scenario::getPacing() const
+    {
+        return m_pacing;
+    }
+
+    void Scenario::setPacing(const std::optional<std::chrono::milliseconds>& pacing)
+    {
+        m_pacing = pacing;
+    }
+
+    std::optional<std::chrono::milliseconds> Scenario::getDuration() const
+    {
+        return m_duration;
+    }
+
+    void Scenario::setDuration(const std::optional<std::chrono::milliseconds>& duration)
+    {
+        m_duration = duration;
+    }
+
+    const std::map<std::string, TargetDefinition>& Scenario::getTargets() const
+    {
+        return m_targets;
+    }
+
+    void Scenario::setTargets(const std::map<std::string, TargetDefinition>& targets)
+    {
+        m_targets = targets;
+    }
+
+    const std::vector<RateLimit>& Scenario::getRateLimits() const
+    {
+        return m_rateLimits;
+    }
+
+    void Scenario::setRateLimits(const std::vector<RateLimit>& rateLimits)
+    {
+        m_rateLimits = rateLimits;
+    }
+
+    const std::optional<BurstPolicy>& Scenario::getBurst() const
+    {
+        return m_burst;
+    }
+
+    void Scenario::setBurst(const std::optional<BurstPolicy>& burst)
+    {
+        m_burst = burst;
+    }
+
+    const std::optional<HttpCachePolicy>& Scenario::getHttpCache() const
+    {
+        return m_httpCache;
+    }
+
+    void Scenario::setHttpCache(const std::optional<HttpCachePolicy>& httpCache)
+    {
+        m_httpCache = httpCache;
+    }
+
+    const std::vector<Step>& Scenario::getSetup() const
+    {
+        return m_setup;
+    }
+
+    void Scenario::setSetup(const std::vector<Step>& steps, PhaseScope scope)
+    {
+        m_setup = steps;
+        m_setupScope = scope;
+    }
+
+    PhaseScope Scenario::getSetupScope() const
+    {
+        return m_setupScope;
+    }
+
+    const std::vector<Step>& Scenario::getTeardown() const
+    {
+        return m_teardown;
+    }
+
+    void Scenario::setTeardown(const std::vector<Step>& steps, PhaseScope scope)
+    {
+        m_teardown = steps;
+        m_teardownScope = scope;
+    }
+
+    PhaseScope Scenario::getTeardownScope() const
+    {
+        return m_teardownScope;
+    }
 } // namespace zaplet::scenario
\ No newline at end of file
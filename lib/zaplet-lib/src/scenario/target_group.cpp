@@ -0,0 +1,190 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/target_group.h"
+
+#include "zaplet/scenario/random.h"
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        // Jump consistent hash (Lamping and Veach): maps a key to one of buckets, moving only 1/buckets of the keys
+        // when a bucket is added, without any table
+        std::size_t jumpHash(std::uint64_t key, std::size_t buckets)
+        {
+            std::int64_t bucket = -1;
+            std::int64_t next = 0;
+            while (next < static_cast<std::int64_t>(buckets))
+            {
+                bucket = next;
+                key = key * 2862933555777941757ULL + 1;
+                next = static_cast<std::int64_t>(static_cast<double>(bucket + 1) *
+                                                 (static_cast<double>(std::int64_t{ 1 } << 31) / static_cast<double>((key >> 33) + 1)));
+            }
+            return static_cast<std::size_t>(bucket);
+        }
+
+        std::vector<std::string> resolveHost(const std::string& host)
+        {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+
+            addrinfo* results = nullptr;
+            int error = getaddrinfo(host.c_str(), nullptr, &hints, &results);
+            if (error != 0)
+            {
+                throw std::runtime_error(std::format("Cannot resolve target host '{}': {}", host, gai_strerror(error)));
+            }
+
+            std::vector<std::string> addresses;
+            for (addrinfo* entry = results; entry != nullptr; entry = entry->ai_next)
+            {
+                char buffer[INET6_ADDRSTRLEN] = {};
+                const void* address = entry->ai_family == AF_INET6
+                                          ? static_cast<const void*>(&reinterpret_cast<sockaddr_in6*>(entry->ai_addr)->sin6_addr)
+                                          : static_cast<const void*>(&reinterpret_cast<sockaddr_in*>(entry->ai_addr)->sin_addr);
+                if (inet_ntop(entry->ai_family, address, buffer, sizeof(buffer)) != nullptr &&
+                    std::ranges::find(addresses, buffer) == addresses.end())
+                {
+                    addresses.emplace_back(buffer);
+                }
+            }
+            freeaddrinfo(results);
+
+            return addresses;
+        }
+    } // namespace
+
+    TargetGroup::TargetGroup(std::string name, std::vector<Node> nodes, BalanceMode balance)
+        : m_name(std::move(name))
+        , m_nodes(std::move(nodes))
+        , m_balance(balance)
+        , m_outstanding(std::make_unique<Counter[]>(m_nodes.size()))
+    {
+        if (m_nodes.empty())
+        {
+            throw std::runtime_error(std::format("Target group '{}' has no nodes", m_name));
+        }
+    }
+
+    std::vector<TargetGroup::Node> TargetGroup::expand(const std::string& url, bool resolve)
+    {
+        auto origin = http::Url::parse(url);
+        if (!origin.has_value())
+        {
+            throw std::runtime_error(std::format("Invalid target URL '{}'", url));
+        }
+        if (origin->path.find('?') != std::string::npos)
+        {
+            throw std::runtime_error(std::format("Target URL '{}' cannot have a query string", url));
+        }
+        if (origin->path.ends_with('/'))
+        {
+            origin->path.pop_back();
+        }
+
+        std::vector<Node> nodes;
+        if (!resolve)
+        {
+            std::string label;
+            origin->appendOrigin(label);
+            nodes.push_back({ origin.value(), "", label + origin->path });
+            return nodes;
+        }
+
+        std::string host = origin->isDefaultPort() ? origin->host : std::format("{}:{}", origin->host, origin->port);
+        for (const auto& address : resolveHost(origin->host))
+        {
+            Node& node = nodes.emplace_back(Node{ origin.value(), host, "" });
+            node.origin.address = address;
+
+            bool ipv6 = address.find(':') != std::string::npos;
+            node.label = std::format("{}://{}{}{}:{}{}",
+                                     origin->scheme,
+                                     ipv6 ? "[" : "",
+                                     address,
+                                     ipv6 ? "]" : "",
+                                     origin->port,
+                                     origin->path);
+        }
+        return nodes;
+    }
+
+    std::size_t TargetGroup::acquire(std::string_view key)
+    {
+        std::size_t node = 0;
+        switch (m_balance)
+        {
+        case BalanceMode::RoundRobin:
+            node = static_cast<std::size_t>(m_next.fetch_add(1, std::memory_order_relaxed) % m_nodes.size());
+            break;
+        case BalanceMode::LeastOutstanding:
+        {
+            // Ties go round robin, so an idle cluster is not sent everything on its first node
+            auto start = static_cast<std::size_t>(m_next.fetch_add(1, std::memory_order_relaxed) % m_nodes.size());
+            std::int64_t fewest = std::numeric_limits<std::int64_t>::max();
+            for (std::size_t offset = 0; offset < m_nodes.size(); ++offset)
+            {
+                std::size_t candidate = (start + offset) % m_nodes.size();
+                std::int64_t outstanding = m_outstanding[candidate].value.load(std::memory_order_relaxed);
+                if (outstanding < fewest)
+                {
+                    fewest = outstanding;
+                    node = candidate;
+                }
+            }
+            m_outstanding[node].value.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        case BalanceMode::ConsistentHash:
+            node = jumpHash(Random::mix(std::hash<std::string_view>{}(key), 0), m_nodes.size());
+            break;
+        }
+        return node;
+    }
+
+    void TargetGroup::release(std::size_t node)
+    {
+        if (m_balance == BalanceMode::LeastOutstanding)
+        {
+            m_outstanding[node].value.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    const std::string& TargetGroup::getName() const
+    {
+        return m_name;
+    }
+
+    const std::vector<TargetGroup::Node>& TargetGroup::getNodes() const
+    {
+        return m_nodes;
+    }
+
+    BalanceMode TargetGroup::getBalance() const
+    {
+        return m_balance;
+    }
+} // namespace zaplet::scenario
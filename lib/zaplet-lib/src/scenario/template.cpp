@@ -0,0 +1,830 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/template.h"
+
+#include "zaplet/logging/logger.h"
+#include "zaplet/scenario/random.h"
+
+#include <nlohmann/json.hpp>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        struct FunctionInfo
+        {
+            std::string_view name;
+            Template::Function function;
+            std::size_t arguments;
+        };
+
+        constexpr std::array FUNCTIONS = {
+            FunctionInfo{ "uuid", Template::Function::Uuid, 0 },
+            FunctionInfo{ "rand_int", Template::Function::RandInt, 2 },
+            FunctionInfo{ "rand_str", Template::Function::RandStr, 1 },
+            FunctionInfo{ "now_ms", Template::Function::NowMs, 0 },
+            FunctionInfo{ "seq", Template::Function::Seq, 0 },
+            FunctionInfo{ "faker.email", Template::Function::FakerEmail, 0 },
+            FunctionInfo{ "base64", Template::Function::Base64, 1 },
+            FunctionInfo{ "hmac_sha256", Template::Function::HmacSha256, 2 },
+        };
+
+        constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+        constexpr std::string_view ALPHANUMERIC = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+        constexpr std::string_view BASE64_ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        constexpr std::array FIRST_NAMES = { "alex", "maria", "ivan", "olga", "john", "emma", "liam", "sofia", "noah", "anna",
+                                             "max",  "lena",  "leo",  "mia",  "omar", "zoe",  "yuri", "nina",  "paul", "kate" };
+        constexpr std::array LAST_NAMES = { "smith", "ivanov", "garcia", "muller", "rossi", "novak", "kim", "silva",
+                                            "brown", "petrov", "lopez",  "wagner", "costa", "sato",  "lee", "dubois" };
+        constexpr std::array EMAIL_DOMAINS = { "example.com", "example.org", "example.net", "test.local" };
+
+        // Shared by every virtual user so that seq() values are unique across the whole run
+        std::atomic<std::uint64_t> sequence{ 0 };
+
+        void appendNumber(std::int64_t value, std::string& out)
+        {
+            std::array<char, 24> buffer{};
+            auto [end, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+            out.append(buffer.data(), end);
+        }
+
+        void appendUuid(std::string& out)
+        {
+            Random& random = Random::local();
+            std::uint64_t high = random.next();
+            std::uint64_t low = random.next();
+
+            // version 4, variant 10
+            high = (high & 0xffffffffffff0fffULL) | 0x0000000000004000ULL;
+            low = (low & 0x3fffffffffffffffULL) | 0x8000000000000000ULL;
+
+            for (int nibble = 0; nibble < 32; ++nibble)
+            {
+                if (nibble == 8 || nibble == 12 || nibble == 16 || nibble == 20)
+                {
+                    out.push_back('-');
+                }
+
+                std::uint64_t word = nibble < 16 ? high : low;
+                out.push_back(HEX_DIGITS[(word >> (60 - 4 * (nibble % 16))) & 0xf]);
+            }
+        }
+
+        void appendRandomString(std::int64_t length, std::string& out)
+        {
+            Random& random = Random::local();
+            for (std::int64_t i = 0; i < length; ++i)
+            {
+                out.push_back(ALPHANUMERIC[random.below(ALPHANUMERIC.size())]);
+            }
+        }
+
+        void appendEmail(std::string& out)
+        {
+            Random& random = Random::local();
+            out.append(FIRST_NAMES[random.below(FIRST_NAMES.size())]);
+            out.push_back('.');
+            out.append(LAST_NAMES[random.below(LAST_NAMES.size())]);
+            appendNumber(static_cast<std::int64_t>(random.below(100000)), out);
+            out.push_back('@');
+            out.append(EMAIL_DOMAINS[random.below(EMAIL_DOMAINS.size())]);
+        }
+
+        void appendBase64(std::string_view value, std::string& out)
+        {
+            std::size_t i = 0;
+            for (; i + 2 < value.size(); i += 3)
+            {
+                std::uint32_t triple = (static_cast<unsigned char>(value[i]) << 16) | (static_cast<unsigned char>(value[i + 1]) << 8) |
+                                       static_cast<unsigned char>(value[i + 2]);
+                out.push_back(BASE64_ALPHABET[(triple >> 18) & 0x3f]);
+                out.push_back(BASE64_ALPHABET[(triple >> 12) & 0x3f]);
+                out.push_back(BASE64_ALPHABET[(triple >> 6) & 0x3f]);
+                out.push_back(BASE64_ALPHABET[triple & 0x3f]);
+            }
+
+            std::size_t rest = value.size() - i;
+            if (rest == 0)
+            {
+                return;
+            }
+
+            std::uint32_t triple = static_cast<unsigned char>(value[i]) << 16;
+            if (rest == 2)
+            {
+                triple |= static_cast<unsigned char>(value[i + 1]) << 8;
+            }
+            out.push_back(BASE64_ALPHABET[(triple >> 18) & 0x3f]);
+            out.push_back(BASE64_ALPHABET[(triple >> 12) & 0x3f]);
+            out.push_back(rest == 2 ? BASE64_ALPHABET[(triple >> 6) & 0x3f] : '=');
+            out.push_back('=');
+        }
+
+        void appendHmacSha256(std::string_view key, std::string_view message, std::string& out)
+        {
+            std::array<unsigned char, EVP_MAX_MD_SIZE> digest{};
+            unsigned int length = 0;
+            HMAC(EVP_sha256(),
+                 key.data(),
+                 static_cast<int>(key.size()),
+                 reinterpret_cast<const unsigned char*>(message.data()),
+                 message.size(),
+                 digest.data(),
+                 &length);
+
+            for (unsigned int i = 0; i < length; ++i)
+            {
+                out.push_back(HEX_DIGITS[digest[i] >> 4]);
+                out.push_back(HEX_DIGITS[digest[i] & 0xf]);
+            }
+        }
+
+        std::string_view trim(std::string_view value)
+        {
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front())))
+            {
+                value.remove_prefix(1);
+            }
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())))
+            {
+                value.remove_suffix(1);
+            }
+            return value;
+        }
+
+        void appendJsonEscaped(std::string_view value, std::string& out)
+        {
+            for (char c : value)
+            {
+                switch (c)
+                {
+                case '"':
+                    out.append("\\\"");
+                    break;
+                case '\\':
+                    out.append("\\\\");
+                    break;
+                case '\n':
+                    out.append("\\n");
+                    break;
+                case '\r':
+                    out.append("\\r");
+                    break;
+                case '\t':
+                    out.append("\\t");
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        out.append("\\u00");
+                        out.push_back(HEX_DIGITS[(c >> 4) & 0xf]);
+                        out.push_back(HEX_DIGITS[c & 0xf]);
+                    }
+                    else
+                    {
+                        out.push_back(c);
+                    }
+                }
+            }
+        }
+
+        // JSON allows no leading zeros, which from_chars accepts
+        bool isJsonInteger(std::string_view value)
+        {
+            std::string_view digits = value.starts_with('-') ? value.substr(1) : value;
+            if (digits.size() > 1 && digits.front() == '0')
+            {
+                return false;
+            }
+
+            std::int64_t integer = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), integer);
+            return ec == std::errc() && end == value.data() + value.size() && !value.empty();
+        }
+
+        // Encodes the value appended to out after start in place; false when it cannot be written as the requested type
+        bool encodeValue(Template::Encoding encoding, std::string& out, std::size_t start)
+        {
+            std::string_view value = std::string_view(out).substr(start);
+            switch (encoding)
+            {
+            case Template::Encoding::Text:
+                return true;
+            case Template::Encoding::JsonRaw:
+                return nlohmann::json::accept(value);
+            case Template::Encoding::JsonString:
+            {
+                auto special = std::ranges::find_if(
+                    value, [](char c) { return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20; });
+                if (special == value.end())
+                {
+                    return true;
+                }
+
+                std::string raw(value);
+                out.resize(start);
+                appendJsonEscaped(raw, out);
+                return true;
+            }
+            case Template::Encoding::JsonInteger:
+                return isJsonInteger(value);
+            case Template::Encoding::JsonNumber:
+            {
+                if (isJsonInteger(value))
+                {
+                    return true;
+                }
+
+                double number = 0.0;
+                auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+                if (ec != std::errc() || end != value.data() + value.size() || value.empty() || !std::isfinite(number))
+                {
+                    return false;
+                }
+
+                // Rewritten so that forms JSON does not allow, such as "1." or ".5", come out valid
+                std::array<char, 32> buffer{};
+                auto [numberEnd, numberEc] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+                out.resize(start);
+                out.append(buffer.data(), numberEnd);
+                return true;
+            }
+            case Template::Encoding::JsonBoolean:
+                if (value == "true" || value == "false")
+                {
+                    return true;
+                }
+                if (value == "1" || value == "0")
+                {
+                    bool flag = value == "1";
+                    out.resize(start);
+                    out.append(flag ? "true" : "false");
+                    return true;
+                }
+                return false;
+            }
+
+            return true;
+        }
+
+        std::string_view encodingName(Template::Encoding encoding)
+        {
+            switch (encoding)
+            {
+            case Template::Encoding::JsonBoolean:
+                return "boolean";
+            case Template::Encoding::JsonInteger:
+                return "integer";
+            case Template::Encoding::JsonRaw:
+                return "JSON";
+            default:
+                return "number";
+            }
+        }
+
+        std::optional<Template::Encoding> parseEncoding(std::string_view type)
+        {
+            if (type == "string")
+            {
+                return Template::Encoding::JsonString;
+            }
+            if (type == "int")
+            {
+                return Template::Encoding::JsonInteger;
+            }
+            if (type == "number")
+            {
+                return Template::Encoding::JsonNumber;
+            }
+            if (type == "bool")
+            {
+                return Template::Encoding::JsonBoolean;
+            }
+            if (type == "json")
+            {
+                return Template::Encoding::JsonRaw;
+            }
+            return std::nullopt;
+        }
+
+        std::int64_t parseInteger(std::string_view value, std::string_view function)
+        {
+            std::int64_t result = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+            if (ec != std::errc() || end != value.data() + value.size())
+            {
+                throw std::runtime_error(std::format("{}() expects integer arguments, got '{}'", function, value));
+            }
+            return result;
+        }
+    } // namespace
+
+    static bool isVariableName(std::string_view name)
+    {
+        if (name.empty())
+        {
+            return false;
+        }
+
+        return std::ranges::all_of(
+            name,
+            [](char c)
+            {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+            });
+    }
+
+    static std::string_view argumentValue(const Template::Argument& argument, const VariableFrame& frame, std::string_view placeholder)
+    {
+        if (!argument.variable)
+        {
+            return argument.value;
+        }
+        if (frame.has(argument.slot))
+        {
+            return frame.get(argument.slot);
+        }
+
+        LOG_WARNING_FMT("Variable in '{}' not found, using an empty value", placeholder);
+        return {};
+    }
+
+    static void appendCall(const Template::Call& call, const VariableFrame& frame, std::string_view placeholder, std::string& out)
+    {
+        switch (call.function)
+        {
+        case Template::Function::Uuid:
+            appendUuid(out);
+            break;
+        case Template::Function::RandInt:
+        {
+            auto span = static_cast<std::uint64_t>(call.high) - static_cast<std::uint64_t>(call.low);
+            std::uint64_t offset = span == UINT64_MAX ? Random::local().next() : Random::local().below(span + 1);
+            appendNumber(static_cast<std::int64_t>(static_cast<std::uint64_t>(call.low) + offset), out);
+            break;
+        }
+        case Template::Function::RandStr:
+            appendRandomString(call.high, out);
+            break;
+        case Template::Function::NowMs:
+            appendNumber(
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), out);
+            break;
+        case Template::Function::Seq:
+            appendNumber(static_cast<std::int64_t>(sequence.fetch_add(1, std::memory_order_relaxed) + 1), out);
+            break;
+        case Template::Function::FakerEmail:
+            appendEmail(out);
+            break;
+        case Template::Function::Base64:
+            appendBase64(argumentValue(call.arguments[0], frame, placeholder), out);
+            break;
+        case Template::Function::HmacSha256:
+            appendHmacSha256(
+                argumentValue(call.arguments[0], frame, placeholder), argumentValue(call.arguments[1], frame, placeholder), out);
+            break;
+        }
+    }
+
+    // Parses the arguments of a call whose '(' is at open; returns the position of the closing ')'
+    static std::size_t parseCall(std::string_view source,
+                                 std::size_t open,
+                                 const FunctionInfo& info,
+                                 VariableTable& table,
+                                 const Template::Constants& constants,
+                                 Template::Call& call)
+    {
+        call.function = info.function;
+
+        std::size_t pos = open + 1;
+        while (true)
+        {
+            while (pos < source.size() && std::isspace(static_cast<unsigned char>(source[pos])))
+            {
+                ++pos;
+            }
+            if (pos >= source.size())
+            {
+                break;
+            }
+            if (source[pos] == ')' && call.arguments.empty())
+            {
+                break;
+            }
+
+            Template::Argument argument;
+            if (source[pos] == '\'' || source[pos] == '"')
+            {
+                std::size_t close = source.find(source[pos], pos + 1);
+                if (close == std::string_view::npos)
+                {
+                    throw std::runtime_error(std::format("Unterminated string argument of {}()", info.name));
+                }
+                argument.value = source.substr(pos + 1, close - pos - 1);
+                pos = close + 1;
+            }
+            else
+            {
+                std::size_t end = source.find_first_of(",)", pos);
+                if (end == std::string_view::npos)
+                {
+                    throw std::runtime_error(std::format("Missing ')' after the arguments of {}()", info.name));
+                }
+                std::string_view token = trim(source.substr(pos, end - pos));
+                if (isVariableName(token) && !std::isdigit(static_cast<unsigned char>(token.front())))
+                {
+                    if (auto constant = constants.find(token); constant != constants.end())
+                    {
+                        argument.value = constant->second;
+                    }
+                    else
+                    {
+                        argument.variable = true;
+                        argument.slot = table.intern(token);
+                    }
+                }
+                else
+                {
+                    argument.value = std::to_string(parseInteger(token, info.name));
+                }
+                pos = end;
+            }
+            call.arguments.push_back(std::move(argument));
+
+            pos = source.find_first_not_of(" \t", pos);
+            if (pos == std::string_view::npos || source[pos] == ')')
+            {
+                break;
+            }
+            if (source[pos] != ',')
+            {
+                throw std::runtime_error(std::format("Expected ',' or ')' in the arguments of {}()", info.name));
+            }
+            ++pos;
+        }
+
+        if (pos >= source.size() || source[pos] != ')')
+        {
+            throw std::runtime_error(std::format("Missing ')' after the arguments of {}()", info.name));
+        }
+        if (call.arguments.size() != info.arguments)
+        {
+            throw std::runtime_error(
+                std::format("{}() takes {} arguments, {} given", info.name, info.arguments, call.arguments.size()));
+        }
+
+        if (info.function == Template::Function::RandInt || info.function == Template::Function::RandStr)
+        {
+            for (const auto& argument : call.arguments)
+            {
+                if (argument.variable)
+                {
+                    throw std::runtime_error(
+                        std::format("{}() expects integer arguments, got '{}'", info.name, table.getName(argument.slot)));
+                }
+            }
+        }
+        if (info.function == Template::Function::RandInt)
+        {
+            call.low = parseInteger(call.arguments[0].value, info.name);
+            call.high = parseInteger(call.arguments[1].value, info.name);
+            if (call.low > call.high)
+            {
+                throw std::runtime_error(std::format("rand_int() lower bound {} is greater than the upper bound {}", call.low, call.high));
+            }
+        }
+        else if (info.function == Template::Function::RandStr)
+        {
+            call.high = parseInteger(call.arguments[0].value, info.name);
+            if (call.high < 0)
+            {
+                throw std::runtime_error(std::format("rand_str() length cannot be negative, got {}", call.high));
+            }
+        }
+
+        return pos;
+    }
+
+    Template Template::compile(std::string_view source, VariableTable& table)
+    {
+        static const Constants noConstants;
+        return compile(source, table, noConstants);
+    }
+
+    Template Template::compile(std::string_view source, VariableTable& table, const Constants& constants)
+    {
+        Template result;
+        result.m_source.reserve(source.size());
+
+        std::size_t literalStart = 0;
+        std::size_t pos = 0;
+
+        while ((pos = source.find("${", pos)) != std::string_view::npos)
+        {
+            std::size_t nameEnd = pos + 2;
+            while (nameEnd < source.size() && (std::isalnum(static_cast<unsigned char>(source[nameEnd])) || source[nameEnd] == '_' ||
+                                               source[nameEnd] == '.'))
+            {
+                ++nameEnd;
+            }
+
+            if (nameEnd < source.size() && source[nameEnd] == '(')
+            {
+                std::string_view name = source.substr(pos + 2, nameEnd - pos - 2);
+                auto info = std::ranges::find(FUNCTIONS, name, &FunctionInfo::name);
+                if (info == FUNCTIONS.end())
+                {
+                    throw std::runtime_error(std::format("Unknown template function '{}'", name));
+                }
+
+                Call call;
+                std::size_t close = parseCall(source, nameEnd, *info, table, constants, call) + 1;
+                if (close >= source.size() || source[close] != '}')
+                {
+                    throw std::runtime_error(std::format("Missing '}}' after {}()", name));
+                }
+
+                result.appendLiteral(source.substr(literalStart, pos - literalStart));
+
+                bool pure = call.function == Function::Base64 || call.function == Function::HmacSha256;
+                if (pure && std::ranges::none_of(call.arguments, &Argument::variable))
+                {
+                    std::string value;
+                    appendCall(call, VariableFrame(), "", value);
+                    result.appendLiteral(value);
+                }
+                else
+                {
+                    result.m_segments.push_back(
+                        { SegmentKind::Function, result.m_source.size(), close + 1 - pos, 0, result.m_calls.size() });
+                    result.m_source.append(source.substr(pos, close + 1 - pos));
+                    result.m_calls.push_back(std::move(call));
+                }
+
+                pos = close + 1;
+                literalStart = pos;
+                continue;
+            }
+
+            std::size_t close = source.find('}', pos + 2);
+            if (close == std::string_view::npos)
+            {
+                break;
+            }
+
+            std::string_view name = source.substr(pos + 2, close - pos - 2);
+            if (!isVariableName(name))
+            {
+                pos += 2;
+                continue;
+            }
+
+            result.appendLiteral(source.substr(literalStart, pos - literalStart));
+
+            if (auto constant = constants.find(name); constant != constants.end())
+            {
+                result.appendLiteral(constant->second);
+            }
+            else
+            {
+                result.m_segments.push_back({ SegmentKind::Variable, result.m_source.size(), close + 1 - pos, table.intern(name) });
+                result.m_source.append(source.substr(pos, close + 1 - pos));
+            }
+
+            pos = close + 1;
+            literalStart = pos;
+        }
+
+        result.appendLiteral(source.substr(literalStart));
+
+        return result;
+    }
+
+    Template Template::compileJson(std::string_view json, VariableTable& table, const Constants& constants)
+    {
+        Template result;
+        result.m_source.reserve(json.size());
+
+        std::size_t literalStart = 0;
+        std::size_t pos = 0;
+
+        // Only strings can hold placeholders; everything between them is copied once into the literal buffer
+        while ((pos = json.find('"', pos)) != std::string_view::npos)
+        {
+            std::size_t end = pos + 1;
+            while (end < json.size() && json[end] != '"')
+            {
+                end += json[end] == '\\' ? 2 : 1;
+            }
+            if (end >= json.size())
+            {
+                throw std::runtime_error("Unterminated string in JSON body");
+            }
+
+            std::string_view quoted = json.substr(pos, end + 1 - pos);
+            if (quoted.find("${") == std::string_view::npos)
+            {
+                pos = end + 1;
+                continue;
+            }
+
+            result.appendLiteral(json.substr(literalStart, pos - literalStart));
+
+            std::string content = nlohmann::json::parse(quoted).get<std::string>();
+            std::optional<Encoding> encoding;
+            std::size_t colon = content.find(':');
+            if (content.starts_with("${") && content.ends_with("}") && colon != std::string::npos &&
+                isVariableName(std::string_view(content).substr(2, colon - 2)))
+            {
+                encoding = parseEncoding(std::string_view(content).substr(colon + 1, content.size() - colon - 2));
+                if (!encoding.has_value())
+                {
+                    throw std::runtime_error(std::format("Unknown type in '{}', expected string, int, number, bool or json", content));
+                }
+            }
+
+            if (!encoding.has_value() || encoding == Encoding::JsonString)
+            {
+                if (encoding.has_value())
+                {
+                    content.erase(colon, content.size() - colon - 1);
+                }
+                result.appendJsonString(compile(content, table, constants));
+            }
+            else
+            {
+                std::string_view name = std::string_view(content).substr(2, colon - 2);
+                if (auto constant = constants.find(name); constant != constants.end())
+                {
+                    std::string value = constant->second;
+                    if (!encodeValue(encoding.value(), value, 0))
+                    {
+                        throw std::runtime_error(std::format("Value '{}' of '{}' does not match its type", constant->second, name));
+                    }
+                    result.appendLiteral(value);
+                }
+                else
+                {
+                    result.m_segments.push_back(
+                        { SegmentKind::Variable, result.m_source.size(), content.size(), table.intern(name), 0, encoding.value() });
+                    result.m_source.append(content);
+                }
+            }
+
+            pos = end + 1;
+            literalStart = pos;
+        }
+
+        result.appendLiteral(json.substr(literalStart));
+
+        return result;
+    }
+
+    void Template::appendLiteral(std::string_view text)
+    {
+        if (text.empty())
+        {
+            return;
+        }
+
+        if (!m_segments.empty() && m_segments.back().kind == SegmentKind::Literal)
+        {
+            m_segments.back().length += text.size();
+        }
+        else
+        {
+            m_segments.push_back({ SegmentKind::Literal, m_source.size(), text.size(), 0 });
+        }
+
+        m_source.append(text);
+        m_literalLength += text.size();
+    }
+
+    void Template::appendJsonString(const Template& part)
+    {
+        appendLiteral("\"");
+        for (const auto& segment : part.m_segments)
+        {
+            std::string_view text = std::string_view(part.m_source).substr(segment.offset, segment.length);
+            if (segment.kind == SegmentKind::Literal)
+            {
+                std::string escaped;
+                appendJsonEscaped(text, escaped);
+                appendLiteral(escaped);
+                continue;
+            }
+
+            Segment copy = segment;
+            copy.offset = m_source.size();
+            copy.encoding = Encoding::JsonString;
+            if (segment.kind == SegmentKind::Function)
+            {
+                copy.call = m_calls.size();
+                m_calls.push_back(part.m_calls[segment.call]);
+            }
+            m_segments.push_back(copy);
+            m_source.append(text);
+        }
+        appendLiteral("\"");
+    }
+
+    void Template::render(const VariableFrame& frame, std::string& out) const
+    {
+        out.clear();
+        out.reserve(m_literalLength);
+
+        for (const auto& segment : m_segments)
+        {
+            if (segment.kind == SegmentKind::Literal)
+            {
+                out.append(m_source, segment.offset, segment.length);
+                continue;
+            }
+
+            std::size_t start = out.size();
+            if (segment.kind == SegmentKind::Function)
+            {
+                appendCall(m_calls[segment.call], frame, std::string_view(m_source).substr(segment.offset, segment.length), out);
+            }
+            else if (frame.has(segment.slot))
+            {
+                out.append(frame.get(segment.slot));
+            }
+            else if (segment.encoding == Encoding::Text || segment.encoding == Encoding::JsonString)
+            {
+                LOG_WARNING_FMT("Variable '{}' not found, leaving as is", variableName(segment));
+                out.append(m_source, segment.offset, segment.length);
+                continue;
+            }
+            else
+            {
+                LOG_WARNING_FMT("Variable '{}' not found, writing null", variableName(segment));
+                out.append("null");
+                continue;
+            }
+
+            if (!encodeValue(segment.encoding, out, start))
+            {
+                LOG_WARNING_FMT("Value of '{}' is not a valid {}, writing null",
+                                variableName(segment),
+                                encodingName(segment.encoding));
+                out.resize(start);
+                out.append("null");
+            }
+        }
+    }
+
+    std::string Template::render(const VariableFrame& frame) const
+    {
+        std::string out;
+        render(frame, out);
+        return out;
+    }
+
+    const std::string& Template::getSource() const
+    {
+        return m_source;
+    }
+
+    const std::vector<Template::Segment>& Template::getSegments() const
+    {
+        return m_segments;
+    }
+
+    const std::vector<Template::Call>& Template::getCalls() const
+    {
+        return m_calls;
+    }
+
+    bool Template::isLiteral() const
+    {
+        return std::ranges::none_of(
+            m_segments,
+            [](const Segment& segment)
+            {
+                return segment.kind != SegmentKind::Literal;
+            });
+    }
+
+    std::string_view Template::variableName(const Segment& segment) const
+    {
+        std::string_view placeholder = std::string_view(m_source).substr(segment.offset + 2, segment.length - 3);
+        return placeholder.substr(0, placeholder.find(':'));
+    }
+} // namespace zaplet::scenario
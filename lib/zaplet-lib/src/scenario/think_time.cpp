@@ -0,0 +1,78 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/think_time.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <numbers>
+
+namespace zaplet::scenario
+{
+    ThinkTime ThinkTime::constant(std::chrono::milliseconds value)
+    {
+        ThinkTime thinkTime;
+        thinkTime.mean = static_cast<double>(value.count());
+        return thinkTime;
+    }
+
+    std::chrono::milliseconds ThinkTime::sample(Random& random) const
+    {
+        double value = mean;
+        switch (distribution)
+        {
+        case Distribution::Constant:
+            return std::chrono::milliseconds(std::llround(mean));
+        case Distribution::Uniform:
+            value = min + random.uniform() * (max.value_or(min) - min);
+            break;
+        case Distribution::Exponential:
+            value = -mean * std::log1p(-random.uniform());
+            break;
+        case Distribution::Normal:
+        {
+            // Box-Muller; 1 - u keeps the logarithm away from zero
+            double radius = std::sqrt(-2.0 * std::log1p(-random.uniform()));
+            value = mean + stddev * radius * std::cos(2.0 * std::numbers::pi * random.uniform());
+            break;
+        }
+        case Distribution::Pareto:
+            value = min / std::pow(1.0 - random.uniform(), 1.0 / shape);
+            break;
+        }
+
+        value = std::clamp(value, min, max.value_or(std::numeric_limits<double>::max()));
+        return std::chrono::milliseconds(std::llround(std::min(value, static_cast<double>(std::numeric_limits<std::int32_t>::max()))));
+    }
+
+    std::string ThinkTime::describe() const
+    {
+        std::string result;
+        switch (distribution)
+        {
+        case Distribution::Constant:
+            return std::format("{} ms", mean);
+        case Distribution::Uniform:
+            return std::format("uniform {}..{} ms", min, max.value_or(min));
+        case Distribution::Exponential:
+            result = std::format("exponential, mean {} ms", mean);
+            break;
+        case Distribution::Normal:
+            result = std::format("normal, mean {} ms, stddev {} ms", mean, stddev);
+            break;
+        case Distribution::Pareto:
+            result = std::format("pareto, scale {} ms, shape {}", min, shape);
+            break;
+        }
+
+        if (max.has_value())
+        {
+            result += std::format(", at most {} ms", max.value());
+        }
+        return result;
+    }
+} // namespace zaplet::scenario
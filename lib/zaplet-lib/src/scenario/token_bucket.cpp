@@ -0,0 +1,63 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/token_bucket.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace zaplet::scenario
+{
+    TokenBucket::TokenBucket(double rate, std::size_t burst)
+        : m_rate(rate)
+        , m_burst(std::max<std::size_t>(burst, 1))
+        , m_interval(std::max<std::int64_t>(std::llround(1e9 / rate), 1))
+        , m_tolerance(static_cast<std::int64_t>(m_burst - 1) * m_interval)
+    {
+    }
+
+    std::chrono::nanoseconds TokenBucket::reserve()
+    {
+        std::int64_t current = now();
+        std::int64_t empty = m_empty.load(std::memory_order_relaxed);
+        std::int64_t next = 0;
+        do
+        {
+            next = std::max(empty, current) + m_interval;
+        } while (!m_empty.compare_exchange_weak(empty, next, std::memory_order_relaxed));
+
+        // the token is available once the bucket would not be drawn past its tolerance
+        return std::chrono::nanoseconds(std::max<std::int64_t>(empty - m_tolerance - current, 0));
+    }
+
+    bool TokenBucket::tryTake()
+    {
+        std::int64_t current = now();
+        std::int64_t empty = m_empty.load(std::memory_order_relaxed);
+        do
+        {
+            if (empty - m_tolerance > current)
+            {
+                return false;
+            }
+        } while (!m_empty.compare_exchange_weak(empty, std::max(empty, current) + m_interval, std::memory_order_relaxed));
+
+        return true;
+    }
+
+    double TokenBucket::getRate() const
+    {
+        return m_rate;
+    }
+
+    std::size_t TokenBucket::getBurst() const
+    {
+        return m_burst;
+    }
+
+    std::int64_t TokenBucket::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+} // namespace zaplet::scenario
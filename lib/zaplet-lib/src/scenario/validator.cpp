@@ -0,0 +1,557 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/validator.h"
+
+#include "zaplet/logging/logger.h"
+#include "zaplet/scenario/json_path.h"
+#include "zaplet/scenario/pattern.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace zaplet::scenario
+{
+    namespace
+    {
+        enum class ValueType
+        {
+            Null,
+            Boolean,
+            Number,
+            Integer,
+            String,
+            Array,
+            Object
+        };
+
+        ValueType parseType(const std::string& type, const std::string& context)
+        {
+            if (type == "null")
+            {
+                return ValueType::Null;
+            }
+            if (type == "boolean")
+            {
+                return ValueType::Boolean;
+            }
+            if (type == "number")
+            {
+                return ValueType::Number;
+            }
+            if (type == "integer")
+            {
+                return ValueType::Integer;
+            }
+            if (type == "string")
+            {
+                return ValueType::String;
+            }
+            if (type == "array")
+            {
+                return ValueType::Array;
+            }
+            if (type == "object")
+            {
+                return ValueType::Object;
+            }
+
+            throw std::runtime_error(std::format("Unknown type '{}' for {}", type, context));
+        }
+
+        bool isWhole(double number)
+        {
+            return std::isfinite(number) && std::trunc(number) == number;
+        }
+
+        bool hasType(const nlohmann::json& node, ValueType type)
+        {
+            switch (type)
+            {
+            case ValueType::Null:
+                return node.is_null();
+            case ValueType::Boolean:
+                return node.is_boolean();
+            case ValueType::Number:
+                return node.is_number();
+            case ValueType::Integer:
+                return node.is_number_integer() || (node.is_number_float() && isWhole(node.get<double>()));
+            case ValueType::String:
+                return node.is_string();
+            case ValueType::Array:
+                return node.is_array();
+            case ValueType::Object:
+                return node.is_object();
+            }
+
+            return false;
+        }
+
+        // Numbers compare by value, so an expected 1 matches an actual 1.0
+        bool jsonEquals(const nlohmann::json& expected, const nlohmann::json& actual)
+        {
+            if (expected.is_number() && actual.is_number())
+            {
+                return expected.get<double>() == actual.get<double>();
+            }
+
+            return expected == actual;
+        }
+
+        std::optional<double> parseNumber(std::string_view text)
+        {
+            double number = 0.0;
+            const char* end = text.data() + text.size();
+            auto [ptr, ec] = std::from_chars(text.data(), end, number);
+            if (text.empty() || ec != std::errc() || ptr != end)
+            {
+                return std::nullopt;
+            }
+
+            return number;
+        }
+
+        // Every member of expected must be present in actual; arrays match index by index and actual may be longer.
+        // On failure where receives the location of the first mismatch.
+        bool containsJson(const nlohmann::json& expected, const nlohmann::json& actual, std::string& where)
+        {
+            if (expected.is_object())
+            {
+                if (!actual.is_object())
+                {
+                    return false;
+                }
+
+                for (const auto& [key, value] : expected.items())
+                {
+                    auto it = actual.find(key);
+                    if (it == actual.end() || !containsJson(value, *it, where))
+                    {
+                        where = std::format(".{}{}", key, it == actual.end() ? "" : where);
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            if (expected.is_array())
+            {
+                if (!actual.is_array() || actual.size() < expected.size())
+                {
+                    return false;
+                }
+
+                for (std::size_t i = 0; i < expected.size(); ++i)
+                {
+                    if (!containsJson(expected[i], actual[i], where))
+                    {
+                        where = std::format("[{}]{}", i, where);
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            return jsonEquals(expected, actual);
+        }
+    } // namespace
+
+    struct ResponseValidator::Check
+    {
+        enum class Kind
+        {
+            Status,
+            Header,
+            Latency,
+            Size,
+            Body,
+            Json,
+            Field
+        };
+
+        Kind kind = Kind::Status;
+        std::string name;
+
+        // Status, Latency and Size limits
+        int statusCode = 0;
+        std::chrono::milliseconds maxLatency{ 0 };
+        std::optional<std::size_t> minSize;
+        std::optional<std::size_t> maxSize;
+
+        // Body and Json expectations
+        std::string text;
+        std::optional<nlohmann::json> document;
+
+        // Header and Field matchers
+        JsonPath path;
+        bool exists = true;
+        std::optional<ValueType> type;
+        std::optional<nlohmann::json> equals;
+        std::optional<Pattern> pattern;
+        std::optional<double> min;
+        std::optional<double> max;
+        std::optional<std::size_t> length;
+        std::optional<std::size_t> minLength;
+        std::optional<std::size_t> maxLength;
+
+        void compileMatcher(const ValueMatcher& matcher, const std::string& context)
+        {
+            exists = matcher.exists;
+            if (matcher.type.has_value())
+            {
+                type = parseType(matcher.type.value(), context);
+            }
+            if (matcher.equals.has_value())
+            {
+                equals = nlohmann::json::parse(matcher.equals.value());
+            }
+            if (matcher.pattern.has_value())
+            {
+                pattern = Pattern::compile(matcher.pattern.value());
+            }
+            min = matcher.min;
+            max = matcher.max;
+            length = matcher.length;
+            minLength = matcher.minLength;
+            maxLength = matcher.maxLength;
+        }
+
+        std::optional<std::string> checkLength(std::size_t size) const
+        {
+            if (length.has_value() && size != length.value())
+            {
+                return std::format("length {} is not {}", size, length.value());
+            }
+            if (minLength.has_value() && size < minLength.value())
+            {
+                return std::format("length {} is less than {}", size, minLength.value());
+            }
+            if (maxLength.has_value() && size > maxLength.value())
+            {
+                return std::format("length {} is greater than {}", size, maxLength.value());
+            }
+
+            return std::nullopt;
+        }
+
+        std::optional<std::string> checkRange(double number) const
+        {
+            if (min.has_value() && number < min.value())
+            {
+                return std::format("{} is less than {}", number, min.value());
+            }
+            if (max.has_value() && number > max.value())
+            {
+                return std::format("{} is greater than {}", number, max.value());
+            }
+
+            return std::nullopt;
+        }
+
+        // Returns a description of the first failed matcher
+        std::optional<std::string> checkJson(const nlohmann::json* node) const
+        {
+            if (node == nullptr)
+            {
+                return exists ? std::optional<std::string>("not found") : std::nullopt;
+            }
+            if (!exists)
+            {
+                return "is present";
+            }
+
+            if (type.has_value() && !hasType(*node, type.value()))
+            {
+                return std::format("unexpected type {}", node->type_name());
+            }
+            if (equals.has_value() && !jsonEquals(equals.value(), *node))
+            {
+                return std::format("expected {}, got {}", equals->dump(), node->dump());
+            }
+            if (pattern.has_value() && !(node->is_string() && pattern->contains(node->get_ref<const std::string&>())))
+            {
+                return std::format("{} does not match {}", node->dump(), pattern->getSource());
+            }
+            if (min.has_value() || max.has_value())
+            {
+                if (!node->is_number())
+                {
+                    return std::format("{} is not a number", node->dump());
+                }
+                if (auto failure = checkRange(node->get<double>()))
+                {
+                    return failure;
+                }
+            }
+            if (length.has_value() || minLength.has_value() || maxLength.has_value())
+            {
+                if (!node->is_string() && !node->is_array() && !node->is_object())
+                {
+                    return std::format("{} has no length", node->dump());
+                }
+                return checkLength(node->is_string() ? node->get_ref<const std::string&>().size() : node->size());
+            }
+
+            return std::nullopt;
+        }
+
+        // Header values are strings; numeric matchers apply when the value holds a number
+        std::optional<std::string> checkHeader(const std::string* value) const
+        {
+            if (value == nullptr)
+            {
+                return exists ? std::optional<std::string>("not present") : std::nullopt;
+            }
+            if (!exists)
+            {
+                return "is present";
+            }
+
+            auto number = parseNumber(*value);
+
+            if (type.has_value())
+            {
+                bool typed = type == ValueType::String || (type == ValueType::Number && number.has_value()) ||
+                             (type == ValueType::Integer && number.has_value() && isWhole(number.value()));
+                if (!typed)
+                {
+                    return std::format("'{}' is not of the expected type", *value);
+                }
+            }
+            if (equals.has_value())
+            {
+                bool equal = equals->is_string() ? equals->get_ref<const std::string&>() == *value
+                                                 : equals->is_number() && number.has_value() && equals->get<double>() == number.value();
+                if (!equal)
+                {
+                    return std::format("expected {}, got '{}'", equals->dump(), *value);
+                }
+            }
+            if (pattern.has_value() && !pattern->contains(*value))
+            {
+                return std::format("'{}' does not match {}", *value, pattern->getSource());
+            }
+            if (min.has_value() || max.has_value())
+            {
+                if (!number.has_value())
+                {
+                    return std::format("'{}' is not a number", *value);
+                }
+                if (auto failure = checkRange(number.value()))
+                {
+                    return failure;
+                }
+            }
+
+            return checkLength(value->size());
+        }
+    };
+
+    ResponseValidator::ResponseValidator() = default;
+    ResponseValidator::~ResponseValidator() = default;
+    ResponseValidator::ResponseValidator(ResponseValidator&& other) noexcept = default;
+    ResponseValidator& ResponseValidator::operator=(ResponseValidator&& other) noexcept = default;
+
+    ResponseValidator ResponseValidator::compile(const ResponseExpectation& expectation)
+    {
+        ResponseValidator validator;
+
+        if (expectation.statusCode != 0)
+        {
+            Check check;
+            check.kind = Check::Kind::Status;
+            check.statusCode = expectation.statusCode;
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        for (const auto& [name, matcher] : expectation.headers)
+        {
+            Check check;
+            check.kind = Check::Kind::Header;
+            check.name = name;
+            check.compileMatcher(matcher, "header " + name);
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        if (expectation.maxLatency.has_value())
+        {
+            Check check;
+            check.kind = Check::Kind::Latency;
+            check.maxLatency = expectation.maxLatency.value();
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        if (expectation.minSize.has_value() || expectation.maxSize.has_value())
+        {
+            Check check;
+            check.kind = Check::Kind::Size;
+            check.minSize = expectation.minSize;
+            check.maxSize = expectation.maxSize;
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        if (expectation.body.has_value() && !expectation.body->empty())
+        {
+            Check check;
+            check.kind = Check::Kind::Body;
+            check.text = expectation.body.value();
+
+            auto document = nlohmann::json::parse(check.text, nullptr, false);
+            if (!document.is_discarded())
+            {
+                check.document = std::move(document);
+                validator.m_needsDocument = true;
+            }
+
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        if (expectation.json.has_value())
+        {
+            Check check;
+            check.kind = Check::Kind::Json;
+            check.text = expectation.json.value();
+
+            auto document = nlohmann::json::parse(check.text, nullptr, false);
+            if (document.is_discarded())
+            {
+                throw std::runtime_error(std::format("Invalid expected JSON: {}", check.text));
+            }
+
+            check.document = std::move(document);
+            validator.m_needsDocument = true;
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        for (const auto& [path, matcher] : expectation.fields)
+        {
+            Check check;
+            check.kind = Check::Kind::Field;
+            check.name = path;
+            check.path = JsonPath::compile(path);
+            check.compileMatcher(matcher, "field " + path);
+            validator.m_needsDocument = true;
+            validator.m_checks.push_back(std::move(check));
+        }
+
+        return validator;
+    }
+
+    bool ResponseValidator::validate(ResponseDocument& document) const
+    {
+        const http::Response& response = document.getResponse();
+        bool isValid = true;
+
+        for (const auto& check : m_checks)
+        {
+            switch (check.kind)
+            {
+            case Check::Kind::Status:
+                if (check.statusCode != response.getStatusCode())
+                {
+                    LOG_ERROR_FMT("Status code validation failed: expected {}, got {}", check.statusCode, response.getStatusCode());
+                    isValid = false;
+                }
+                break;
+            case Check::Kind::Header:
+                {
+                    const std::string* value = response.getHeaders().find(check.name);
+                    if (auto failure = check.checkHeader(value))
+                    {
+                        LOG_ERROR_FMT("Header validation failed for {}: {}", check.name, failure.value());
+                        isValid = false;
+                    }
+                    break;
+                }
+            case Check::Kind::Latency:
+                if (response.getLatency() > check.maxLatency)
+                {
+                    LOG_ERROR_FMT(
+                        "Latency validation failed: {} ms exceeds {} ms", response.getLatency().count(), check.maxLatency.count());
+                    isValid = false;
+                }
+                break;
+            case Check::Kind::Size:
+                {
+                    std::size_t size = response.getBody().size();
+                    if ((check.minSize.has_value() && size < check.minSize.value()) ||
+                        (check.maxSize.has_value() && size > check.maxSize.value()))
+                    {
+                        LOG_ERROR_FMT(
+                            "Body size validation failed: {} bytes, expected between {} and {}",
+                            size,
+                            check.minSize.value_or(0),
+                            check.maxSize.has_value() ? std::to_string(check.maxSize.value()) : "unlimited");
+                        isValid = false;
+                    }
+                    break;
+                }
+            case Check::Kind::Body:
+                {
+                    const nlohmann::json* actual = check.document.has_value() ? document.getJson() : nullptr;
+                    bool equal = actual != nullptr ? check.document.value() == *actual : check.text == response.getBody();
+                    if (!equal)
+                    {
+                        LOG_ERROR(actual != nullptr ? "JSON body validation failed" : "Body validation failed");
+                        LOG_DEBUG_FMT("Expected: {}", check.text);
+                        LOG_DEBUG_FMT("Actual: {}", response.getBody());
+                        isValid = false;
+                    }
+                    break;
+                }
+            case Check::Kind::Json:
+                {
+                    const nlohmann::json* actual = document.getJson();
+                    std::string where;
+                    if (actual == nullptr)
+                    {
+                        LOG_ERROR("JSON body validation failed: response body is not JSON");
+                        isValid = false;
+                    }
+                    else if (!containsJson(check.document.value(), *actual, where))
+                    {
+                        LOG_ERROR_FMT("JSON body validation failed at ${}", where);
+                        LOG_DEBUG_FMT("Expected subset: {}", check.text);
+                        LOG_DEBUG_FMT("Actual: {}", response.getBody());
+                        isValid = false;
+                    }
+                    break;
+                }
+            case Check::Kind::Field:
+                {
+                    const nlohmann::json* root = document.getJson();
+                    const nlohmann::json* node = root != nullptr ? check.path.selectFirst(*root) : nullptr;
+                    if (auto failure = check.checkJson(node))
+                    {
+                        LOG_ERROR_FMT("Field validation failed for {}: {}", check.name, failure.value());
+                        isValid = false;
+                    }
+                    break;
+                }
+            }
+        }
+
+        return isValid;
+    }
+
+    bool ResponseValidator::needsDocument() const
+    {
+        return m_needsDocument;
+    }
+
+    std::size_t ResponseValidator::size() const
+    {
+        return m_checks.size();
+    }
+} // namespace zaplet::scenario
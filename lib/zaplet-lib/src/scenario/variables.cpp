@@ -0,0 +1,96 @@
+/*
+ * Code written by Максим Пискарёв "gliptodont"
+ */
+
+#include "zaplet/scenario/variables.h"
+
+#include <stdexcept>
+
+namespace zaplet::scenario
+{
+    VariableSlot VariableTable::intern(std::string_view name)
+    {
+        auto it = m_slots.find(name);
+        if (it != m_slots.end())
+        {
+            return it->second;
+        }
+
+        VariableSlot slot = m_names.size();
+        m_names.emplace_back(name);
+        m_slots.emplace(std::string(name), slot);
+        return slot;
+    }
+
+    std::optional<VariableSlot> VariableTable::find(std::string_view name) const
+    {
+        auto it = m_slots.find(name);
+        if (it == m_slots.end())
+        {
+            return std::nullopt;
+        }
+
+        return it->second;
+    }
+
+    const std::string& VariableTable::getName(VariableSlot slot) const
+    {
+        return m_names.at(slot);
+    }
+
+    std::size_t VariableTable::size() const
+    {
+        return m_names.size();
+    }
+
+    VariableFrame::VariableFrame(std::size_t size)
+        : m_values(size)
+    {
+    }
+
+    bool VariableFrame::has(VariableSlot slot) const
+    {
+        return slot < m_values.size() && m_values[slot].has_value();
+    }
+
+    const std::string& VariableFrame::get(VariableSlot slot) const
+    {
+        if (!has(slot))
+        {
+            throw std::out_of_range("Variable slot is not set");
+        }
+
+        return *m_values[slot];
+    }
+
+    void VariableFrame::set(VariableSlot slot, std::string_view value)
+    {
+        if (slot >= m_values.size())
+        {
+            m_values.resize(slot + 1);
+        }
+
+        auto& entry = m_values[slot];
+        if (entry.has_value())
+        {
+            entry->assign(value);
+        }
+        else
+        {
+            entry.emplace(value);
+        }
+    }
+
+    void VariableFrame::unset(VariableSlot slot)
+    {
+        if (slot < m_values.size())
+        {
+            m_values[slot].reset();
+        }
+    }
+
+    std::size_t VariableFrame::size() const
+    {
+        return m_values.size();
+    }
+} // namespace zaplet::scenario
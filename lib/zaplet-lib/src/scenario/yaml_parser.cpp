@@ -4,8 +4,79 @@
 
 #include "zaplet/scenario/yaml_parser.h"
 
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <string_view>
+
 namespace zaplet::scenario
 {
+    namespace
+    {
+        // Plain scalars are typed the way YAML reads them; quoted scalars always stay strings
+        nlohmann::ordered_json toJson(const YAML::Node& node)
+        {
+            if (node.IsMap())
+            {
+                nlohmann::ordered_json object = nlohmann::ordered_json::object();
+                for (const auto& it : node)
+                {
+                    object[it.first.as<std::string>()] = toJson(it.second);
+                }
+                return object;
+            }
+
+            if (node.IsSequence())
+            {
+                nlohmann::ordered_json array = nlohmann::ordered_json::array();
+                for (const auto& item : node)
+                {
+                    array.push_back(toJson(item));
+                }
+                return array;
+            }
+
+            if (node.IsNull())
+            {
+                return nullptr;
+            }
+
+            std::string scalar = node.as<std::string>();
+            if (node.Tag() == "!")
+            {
+                return scalar;
+            }
+
+            if (scalar == "true" || scalar == "false")
+            {
+                return scalar == "true";
+            }
+
+            const char* begin = scalar.data();
+            const char* end = scalar.data() + scalar.size();
+
+            std::int64_t integer = 0;
+            auto [intPtr, intEc] = std::from_chars(begin, end, integer);
+            if (intEc == std::errc() && intPtr == end)
+            {
+                return integer;
+            }
+
+            double number = 0.0;
+            auto [numberPtr, numberEc] = std::from_chars(begin, end, number);
+            if (numberEc == std::errc() && numberPtr == end && !scalar.empty())
+            {
+                return number;
+            }
+
+            return scalar;
+        }
+    } // namespace
+
     Scenario YamlParser::parseFile(const std::string& filePath) const
     {
         try
@@ -16,7 +87,21 @@ namespace zaplet::scenario
             }
 
             YAML::Node config = YAML::LoadFile(filePath);
-            return parseScenario(config);
+            Scenario scenario = parseScenario(config);
+
+            // Data files are looked up next to the scenario file
+            auto data = scenario.getData();
+            for (auto& source : data)
+            {
+                std::filesystem::path path(source.file);
+                if (path.is_relative())
+                {
+                    source.file = (std::filesystem::path(filePath).parent_path() / path).string();
+                }
+            }
+            scenario.setData(data);
+
+            return scenario;
         } catch (const YAML::Exception& e)
         {
             throw std::runtime_error("Failed to parse file: " + std::string(e.what()));
@@ -36,6 +121,164 @@ namespace zaplet::scenario
         }
     }
 
+    bool YamlParser::isMixFile(const std::string& filePath)
+    {
+        try
+        {
+            YAML::Node config = YAML::LoadFile(filePath);
+            return config.IsMap() && config["scenarios"] && !config["steps"];
+        } catch (const YAML::Exception&)
+        {
+            return false;
+        }
+    }
+
+    Mix YamlParser::parseMixFile(const std::string& filePath) const
+    {
+        try
+        {
+            if (!std::filesystem::exists(filePath))
+            {
+                throw std::runtime_error("Mix file does not exist: " + filePath);
+            }
+
+            YAML::Node node = YAML::LoadFile(filePath);
+            Mix mix;
+
+            if (!node["name"])
+            {
+                throw std::runtime_error("Mix must have a name");
+            }
+            mix.name = node["name"].as<std::string>();
+
+            if (node["description"])
+            {
+                mix.description = node["description"].as<std::string>();
+            }
+
+            if (node["vus"])
+            {
+                int virtualUsers = node["vus"].as<int>();
+                if (virtualUsers < 1)
+                {
+                    throw std::runtime_error("Number of virtual users must be positive");
+                }
+                mix.virtualUsers = static_cast<std::size_t>(virtualUsers);
+            }
+
+            if (node["duration"])
+            {
+                mix.duration = parseDuration(node["duration"].as<std::string>());
+            }
+
+            if (!node["scenarios"] || !node["scenarios"].IsSequence() || node["scenarios"].size() == 0)
+            {
+                throw std::runtime_error("Mix must have a non-empty list of scenarios");
+            }
+
+            for (const auto& entryNode : node["scenarios"])
+            {
+                MixEntry entry;
+                if (!entryNode["file"])
+                {
+                    throw std::runtime_error("Mix scenario must have a file");
+                }
+                entry.file = entryNode["file"].as<std::string>();
+
+                std::filesystem::path path(entry.file);
+                if (path.is_relative())
+                {
+                    entry.file = (std::filesystem::path(filePath).parent_path() / path).string();
+                }
+
+                if (entryNode["weight"] && entryNode["vus"])
+                {
+                    throw std::runtime_error(std::format("Mix scenario '{}' cannot have both weight and vus", entry.file));
+                }
+
+                if (entryNode["vus"])
+                {
+                    int virtualUsers = entryNode["vus"].as<int>();
+                    if (virtualUsers < 1)
+                    {
+                        throw std::runtime_error(std::format("Mix scenario '{}' must have a positive number of virtual users", entry.file));
+                    }
+                    entry.virtualUsers = static_cast<std::size_t>(virtualUsers);
+                }
+                else
+                {
+                    entry.weight = entryNode["weight"] ? entryNode["weight"].as<double>() : 1.0;
+                    if (!(entry.weight > 0.0))
+                    {
+                        throw std::runtime_error(std::format("Mix scenario '{}' must have a positive weight", entry.file));
+                    }
+                }
+
+                mix.entries.push_back(std::move(entry));
+            }
+
+            LOG_DEBUG_FMT("Parsed mix '{}' with {} scenarios", mix.name, mix.entries.size());
+            return mix;
+        } catch (const YAML::Exception& e)
+        {
+            throw std::runtime_error("Failed to parse file: " + std::string(e.what()));
+        }
+    }
+
+    std::chrono::milliseconds YamlParser::parseDuration(const std::string& value)
+    {
+        std::chrono::milliseconds duration{ 0 };
+        auto invalid = [&value]()
+        { return std::runtime_error(std::format("Invalid duration '{}', expected a value such as 90s, 10m or 1h30m", value)); };
+
+        const char* it = value.data();
+        const char* end = value.data() + value.size();
+        if (it == end)
+        {
+            throw invalid();
+        }
+
+        while (it != end)
+        {
+            std::int64_t amount = 0;
+            auto [next, ec] = std::from_chars(it, end, amount);
+            if (ec != std::errc() || amount < 0)
+            {
+                throw invalid();
+            }
+
+            const char* unitEnd = std::find_if(next, end, [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+            std::string_view unit(next, static_cast<std::size_t>(unitEnd - next));
+            if (unit == "ms")
+            {
+                duration += std::chrono::milliseconds(amount);
+            }
+            else if (unit == "s" || (unit.empty() && it == value.data() && next == end))
+            {
+                duration += std::chrono::seconds(amount);
+            }
+            else if (unit == "m")
+            {
+                duration += std::chrono::minutes(amount);
+            }
+            else if (unit == "h")
+            {
+                duration += std::chrono::hours(amount);
+            }
+            else
+            {
+                throw invalid();
+            }
+            it = unitEnd;
+        }
+
+        if (duration.count() <= 0)
+        {
+            throw std::runtime_error(std::format("Duration '{}' must be positive", value));
+        }
+        return duration;
+    }
+
     Scenario YamlParser::parseScenario(const YAML::Node& node) const
     {
         Scenario scenario;
@@ -54,7 +297,18 @@ namespace zaplet::scenario
             scenario.setDescription(node["description"].as<std::string>());
         }
 
-        if (node["repeat"])
+        if (node["burst"] && (node["repeat"] || node["pacing"]))
+        {
+            throw std::runtime_error(
+                std::format("Burst scenario '{}' is repeated by its rounds, not by repeat or pacing", scenario.getName()));
+        }
+
+        if (node["burst"])
+        {
+            scenario.setBurst(parseBurst(node["burst"]));
+            scenario.setRepeatCount(node["duration"] ? std::nullopt : std::optional<int>(scenario.getBurst()->rounds));
+        }
+        else if (node["repeat"])
         {
             std::string repeatValue = node["repeat"].as<std::string>();
             if (repeatValue == "infinite" || repeatValue == "inf")
@@ -73,16 +327,119 @@ namespace zaplet::scenario
                 }
             }
         }
+        else if (node["duration"])
+        {
+            // a time-bounded scenario repeats until its duration is over
+            scenario.setRepeatCount(std::nullopt);
+        }
         else
         {
             scenario.setRepeatCount(1);
         }
 
+        if (node["duration"])
+        {
+            scenario.setDuration(parseDuration(node["duration"].as<std::string>()));
+        }
+
+        if (node["think_time"])
+        {
+            scenario.setThinkTime(parseThinkTime(node["think_time"], "Think time"));
+        }
+
+        if (node["pacing"])
+        {
+            scenario.setPacing(parseDuration(node["pacing"].as<std::string>()));
+        }
+
         if (node["continue_on_error"])
         {
             scenario.setContinueOnError(node["continue_on_error"].as<bool>());
         }
 
+        if (node["json_streaming"])
+        {
+            scenario.setJsonStreaming(node["json_streaming"].as<bool>());
+        }
+
+        if (node["auto_parallel"])
+        {
+            scenario.setAutoParallel(node["auto_parallel"].as<bool>());
+        }
+
+        if (node["vus"])
+        {
+            int virtualUsers = node["vus"].as<int>();
+            if (virtualUsers < 1)
+            {
+                throw std::runtime_error("Number of virtual users must be positive");
+            }
+            scenario.setVirtualUsers(static_cast<std::size_t>(virtualUsers));
+        }
+
+        if (node["seed"])
+        {
+            scenario.setSeed(node["seed"].as<std::uint64_t>());
+        }
+
+        if (node["data"])
+        {
+            std::vector<DataSource> data;
+            if (node["data"].IsSequence())
+            {
+                for (const auto& sourceNode : node["data"])
+                {
+                    data.push_back(parseDataSource(sourceNode));
+                }
+            }
+            else
+            {
+                data.push_back(parseDataSource(node["data"]));
+            }
+            scenario.setData(data);
+        }
+
+        if (node["targets"])
+        {
+            if (!node["targets"].IsMap())
+            {
+                throw std::runtime_error("Targets must be a map of target group names to their nodes");
+            }
+
+            std::map<std::string, TargetDefinition> targets;
+            for (const auto& it : node["targets"])
+            {
+                auto name = it.first.as<std::string>();
+                targets[name] = parseTargets(it.second, name);
+            }
+            scenario.setTargets(targets);
+        }
+
+        if (node["http_cache"])
+        {
+            scenario.setHttpCache(parseHttpCache(node["http_cache"]));
+        }
+
+        if (node["rate_limits"])
+        {
+            if (!node["rate_limits"].IsSequence())
+            {
+                throw std::runtime_error("Rate limits must be a list");
+            }
+
+            std::vector<RateLimit> rateLimits;
+            for (const auto& limitNode : node["rate_limits"])
+            {
+                RateLimit limit = parseRateLimit(limitNode, "Rate limit");
+                if (!limit.match.has_value())
+                {
+                    throw std::runtime_error("Rate limits of a scenario need a match pattern for the URLs they apply to");
+                }
+                rateLimits.push_back(std::move(limit));
+            }
+            scenario.setRateLimits(rateLimits);
+        }
+
         if (node["environment"] && node["environment"].IsMap())
         {
             std::map<std::string, std::string> env;
@@ -109,10 +466,67 @@ namespace zaplet::scenario
             throw std::runtime_error("Scenario must have steps");
         }
 
+        if (node["setup"])
+        {
+            PhaseScope scope = PhaseScope::Run;
+            auto steps = parsePhase(node["setup"], "setup", scope);
+            scenario.setSetup(steps, scope);
+        }
+
+        if (node["teardown"])
+        {
+            PhaseScope scope = PhaseScope::Run;
+            auto steps = parsePhase(node["teardown"], "teardown", scope);
+            scenario.setTeardown(steps, scope);
+        }
+
         LOG_INFO_FMT("Parsed scenario '{}' with {} steps", scenario.getName(), scenario.getSteps().size());
         return scenario;
     }
 
+    std::vector<Step> YamlParser::parsePhase(const YAML::Node& node, const std::string& phase, PhaseScope& scope) const
+    {
+        // Either a plain list of steps, or a map with the steps and their scope
+        YAML::Node stepsNode = node;
+        if (node.IsMap())
+        {
+            if (node["scope"])
+            {
+                auto value = node["scope"].as<std::string>();
+                if (value == "run")
+                {
+                    scope = PhaseScope::Run;
+                }
+                else if (value == "vu")
+                {
+                    scope = PhaseScope::VirtualUser;
+                }
+                else
+                {
+                    throw std::runtime_error(std::format("Unknown {} scope '{}', expected run or vu", phase, value));
+                }
+            }
+            stepsNode = node["steps"];
+        }
+
+        if (!stepsNode || !stepsNode.IsSequence())
+        {
+            throw std::runtime_error(std::format("The {} section must be a list of steps", phase));
+        }
+
+        std::vector<Step> steps;
+        for (const auto& stepNode : stepsNode)
+        {
+            Step step = parseStep(stepNode);
+            if (!step.dependsOn.empty())
+            {
+                throw std::runtime_error(std::format("Step '{}' cannot use depends_on in the {} section", step.name, phase));
+            }
+            steps.push_back(std::move(step));
+        }
+        return steps;
+    }
+
     Step YamlParser::parseStep(const YAML::Node& node) const
     {
         Step step;
@@ -131,9 +545,53 @@ namespace zaplet::scenario
             step.description = node["description"].as<std::string>();
         }
 
-        if (node["request"])
+        if (node["parallel"])
+        {
+            if (!node["parallel"].IsSequence() || node["parallel"].size() == 0)
+            {
+                throw std::runtime_error(std::format("Parallel group '{}' must be a non-empty list of steps", step.name));
+            }
+
+            if (node["request"])
+            {
+                throw std::runtime_error(std::format("Step '{}' cannot have both a request and parallel steps", step.name));
+            }
+
+            for (const auto& branchNode : node["parallel"])
+            {
+                Step branch = parseStep(branchNode);
+                if (branch.loop.has_value() || branch.foreach.has_value() || !branch.parallel.empty() || !branch.dependsOn.empty() ||
+                    branch.credentials.has_value())
+                {
+                    throw std::runtime_error(
+                        std::format("Parallel step '{}' cannot contain loop, foreach, parallel, depends_on or credentials", branch.name));
+                }
+                step.parallel.push_back(std::move(branch));
+            }
+        }
+        else if (node["request"])
         {
             step.request = parseRequest(node["request"]);
+            if (node["request"]["target"])
+            {
+                step.target = node["request"]["target"].as<std::string>();
+            }
+
+            if (node["request"]["body_json"])
+            {
+                if (node["request"]["body"])
+                {
+                    throw std::runtime_error(std::format("Step '{}' cannot have both body and body_json", step.name));
+                }
+
+                step.request.setBody(toJson(node["request"]["body_json"]).dump());
+                step.bodyJson = true;
+
+                if (!step.request.getHeaders().contains("Content-Type"))
+                {
+                    step.request.setHeader("Content-Type", "application/json");
+                }
+            }
         }
         else
         {
@@ -142,13 +600,16 @@ namespace zaplet::scenario
 
         if (node["expected_response"])
         {
-            step.expectedResponse = parseResponse(node["expected_response"]);
+            if (!step.parallel.empty())
+            {
+                throw std::runtime_error(std::format("Parallel group '{}' cannot have an expected response, its steps can", step.name));
+            }
+            step.expectedResponse = parseExpectation(node["expected_response"]);
         }
 
         if (node["delay"])
         {
-            int delayMs = node["delay"].as<int>();
-            step.delay = std::chrono::milliseconds(delayMs);
+            step.delay = parseThinkTime(node["delay"], std::format("Delay of step '{}'", step.name));
         }
 
         if (node["condition"])
@@ -156,31 +617,495 @@ namespace zaplet::scenario
             step.condition = node["condition"].as<std::string>();
         }
 
-        if (node["variables"] && node["variables"].IsMap())
+        if (node["loop"])
         {
-            std::map<std::string, std::string> variables;
-            for (const auto& it : node["variables"])
+            int count = node["loop"].as<int>();
+            if (count < 0)
             {
-                std::string key = it.first.as<std::string>();
-                std::string value = it.second.as<std::string>();
-                variables[key] = value;
+                throw std::runtime_error(std::format("Loop count of step '{}' cannot be negative", step.name));
             }
-            step.variables = variables;
+            step.loop = count;
         }
 
-        LOG_DEBUG_FMT("Parsed step '{}' with method {} to URL {}", step.name, step.request.getMethod(), step.request.getUrl());
-        return step;
-    }
+        if (node["foreach"])
+        {
+            if (step.loop.has_value())
+            {
+                throw std::runtime_error(std::format("Step '{}' cannot have both loop and foreach", step.name));
+            }
+            step.foreach = node["foreach"].as<std::string>();
 
-    http::Request YamlParser::parseRequest(const YAML::Node& node) const
-    {
-        http::Request request;
+            if (node["as"])
+            {
+                step.itemVariable = node["as"].as<std::string>();
+            }
+        }
 
-        if (node["url"])
+        if (node["depends_on"])
         {
-            request.setUrl(node["url"].as<std::string>());
-        }
-        else
+            if (node["depends_on"].IsSequence())
+            {
+                for (const auto& dependency : node["depends_on"])
+                {
+                    step.dependsOn.push_back(dependency.as<std::string>());
+                }
+            }
+            else
+            {
+                step.dependsOn.push_back(node["depends_on"].as<std::string>());
+            }
+        }
+
+        if (node["variables"] && node["variables"].IsMap())
+        {
+            if (!step.parallel.empty())
+            {
+                throw std::runtime_error(std::format("Parallel group '{}' cannot extract variables, its steps can", step.name));
+            }
+
+            std::map<std::string, std::string> variables;
+            for (const auto& it : node["variables"])
+            {
+                std::string key = it.first.as<std::string>();
+                std::string value = it.second.as<std::string>();
+                variables[key] = value;
+            }
+            step.variables = variables;
+        }
+
+        if (node["credentials"])
+        {
+            if (!step.parallel.empty())
+            {
+                throw std::runtime_error(std::format("Parallel group '{}' cannot publish credentials", step.name));
+            }
+            step.credentials = parseCredentials(node["credentials"], step.name);
+        }
+
+        if (node["cache"])
+        {
+            if (!step.parallel.empty() || step.credentials.has_value())
+            {
+                throw std::runtime_error(
+                    std::format("Step '{}' cannot be cached, it is a parallel group or publishes credentials", step.name));
+            }
+            step.cache = parseCache(node["cache"], step.name);
+        }
+
+        if (node["rate_limit"])
+        {
+            if (!step.parallel.empty())
+            {
+                throw std::runtime_error(std::format("Parallel group '{}' cannot be rate limited, its steps can", step.name));
+            }
+            step.rateLimit = parseRateLimit(node["rate_limit"], std::format("Rate limit of step '{}'", step.name));
+            if (step.rateLimit->match.has_value())
+            {
+                throw std::runtime_error(std::format("Rate limit of step '{}' applies to the step and cannot have match", step.name));
+            }
+        }
+
+        if (!step.parallel.empty())
+        {
+            LOG_DEBUG_FMT("Parsed parallel group '{}' with {} steps", step.name, step.parallel.size());
+        }
+        else
+        {
+            LOG_DEBUG_FMT("Parsed step '{}' with method {} to URL {}", step.name, step.request.getMethod(), step.request.getUrl());
+        }
+        return step;
+    }
+
+    TargetDefinition YamlParser::parseTargets(const YAML::Node& node, const std::string& name) const
+    {
+        // Either just the list of node URLs, or a map with the list and how to balance between them
+        TargetDefinition targets;
+        YAML::Node urls = node.IsMap() ? node["urls"] : node;
+        if (!urls || !urls.IsSequence() || urls.size() == 0)
+        {
+            throw std::runtime_error(std::format("Target group '{}' must have a list of URLs", name));
+        }
+        for (const auto& url : urls)
+        {
+            targets.urls.push_back(url.as<std::string>());
+        }
+
+        if (!node.IsMap())
+        {
+            return targets;
+        }
+
+        if (node["resolve"])
+        {
+            targets.resolve = node["resolve"].as<bool>();
+        }
+
+        if (node["balance"])
+        {
+            auto balance = node["balance"].as<std::string>();
+            if (balance == "round_robin")
+            {
+                targets.balance = BalanceMode::RoundRobin;
+            }
+            else if (balance == "least_outstanding")
+            {
+                targets.balance = BalanceMode::LeastOutstanding;
+            }
+            else if (balance == "consistent_hash")
+            {
+                targets.balance = BalanceMode::ConsistentHash;
+            }
+            else
+            {
+                throw std::runtime_error(
+                    std::format("Target group '{}' has unknown balance '{}', expected round_robin, least_outstanding or consistent_hash",
+                                name,
+                                balance));
+            }
+        }
+
+        if (node["key"])
+        {
+            targets.key = node["key"].as<std::string>();
+        }
+        if (targets.balance == BalanceMode::ConsistentHash && !targets.key.has_value())
+        {
+            throw std::runtime_error(std::format("Target group '{}' is balanced by consistent hashing and needs a key", name));
+        }
+        return targets;
+    }
+
+    RateLimit YamlParser::parseRateLimit(const YAML::Node& node, const std::string& context) const
+    {
+        // Either just the rate, or a map with the rate and its options
+        RateLimit limit;
+        if (node.IsScalar())
+        {
+            limit.rate = parseRate(node.as<std::string>(), context);
+            return limit;
+        }
+
+        if (!node.IsMap() || !node["rate"])
+        {
+            throw std::runtime_error(std::format("{} must be a rate such as 10/s or a map with a rate", context));
+        }
+        limit.rate = parseRate(node["rate"].as<std::string>(), context);
+
+        if (node["burst"])
+        {
+            int burst = node["burst"].as<int>();
+            if (burst < 1)
+            {
+                throw std::runtime_error(std::format("{} needs a positive burst", context));
+            }
+            limit.burst = static_cast<std::size_t>(burst);
+        }
+
+        if (node["on_limit"])
+        {
+            auto action = node["on_limit"].as<std::string>();
+            if (action == "wait")
+            {
+                limit.action = RateLimitAction::Wait;
+            }
+            else if (action == "skip")
+            {
+                limit.action = RateLimitAction::Skip;
+            }
+            else
+            {
+                throw std::runtime_error(std::format("{} has unknown on_limit '{}', expected wait or skip", context, action));
+            }
+        }
+
+        if (node["match"])
+        {
+            limit.match = node["match"].as<std::string>();
+        }
+        return limit;
+    }
+
+    double YamlParser::parseRate(const std::string& value, const std::string& context)
+    {
+        // requests per second, minute or hour; a plain number counts per second
+        double count = 0.0;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), count);
+        if (ec != std::errc() || count <= 0.0)
+        {
+            throw std::runtime_error(std::format("{} has invalid rate '{}'", context, value));
+        }
+
+        std::string_view unit(end, value.data() + value.size());
+        if (unit.empty() || unit == "/s")
+        {
+            return count;
+        }
+        if (unit == "/m")
+        {
+            return count / 60.0;
+        }
+        if (unit == "/h")
+        {
+            return count / 3600.0;
+        }
+        throw std::runtime_error(std::format("{} has invalid rate '{}', expected a count per s, m or h such as 10/s", context, value));
+    }
+
+    std::optional<HttpCachePolicy> YamlParser::parseHttpCache(const YAML::Node& node) const
+    {
+        // Either just whether every virtual user keeps a cache, or its bounds
+        if (node.IsScalar())
+        {
+            return node.as<bool>() ? std::optional<HttpCachePolicy>(HttpCachePolicy()) : std::nullopt;
+        }
+        if (!node.IsMap())
+        {
+            throw std::runtime_error("HTTP cache must be true, false or a map with max_entries and max_size");
+        }
+
+        HttpCachePolicy policy;
+        if (node["max_entries"])
+        {
+            int entries = node["max_entries"].as<int>();
+            if (entries < 1)
+            {
+                throw std::runtime_error("HTTP cache must hold at least one entry");
+            }
+            policy.maxEntries = static_cast<std::size_t>(entries);
+        }
+
+        if (node["max_size"])
+        {
+            // bytes, or a number of KB, MB or GB
+            auto value = node["max_size"].as<std::string>();
+            std::uint64_t size = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), size);
+            std::string_view unit(end, static_cast<std::size_t>(value.data() + value.size() - end));
+            std::size_t shift = unit.empty() ? 0 : unit == "KB" ? 10 : unit == "MB" ? 20 : unit == "GB" ? 30 : 64;
+            if (ec != std::errc() || size == 0 || shift == 64)
+            {
+                throw std::runtime_error(std::format("Invalid HTTP cache size '{}', expected a value such as 512KB or 16MB", value));
+            }
+            policy.maxBytes = static_cast<std::size_t>(size << shift);
+        }
+
+        return policy;
+    }
+
+    BurstPolicy YamlParser::parseBurst(const YAML::Node& node) const
+    {
+        if (!node.IsMap())
+        {
+            throw std::runtime_error("Burst must be a map with rounds and interval");
+        }
+
+        BurstPolicy burst;
+        if (node["rounds"])
+        {
+            burst.rounds = node["rounds"].as<int>();
+            if (burst.rounds < 1)
+            {
+                throw std::runtime_error("Burst rounds must be positive");
+            }
+        }
+        if (node["interval"])
+        {
+            burst.interval = parseDuration(node["interval"].as<std::string>());
+        }
+        return burst;
+    }
+
+    ThinkTime YamlParser::parseThinkTime(const YAML::Node& node, const std::string& context) const
+    {
+        if (node.IsScalar())
+        {
+            int valueMs = node.as<int>();
+            if (valueMs < 0)
+            {
+                throw std::runtime_error(std::format("{} cannot be negative", context));
+            }
+            return ThinkTime::constant(std::chrono::milliseconds(valueMs));
+        }
+
+        if (!node.IsMap())
+        {
+            throw std::runtime_error(std::format("{} must be a number of milliseconds or a distribution", context));
+        }
+
+        ThinkTime thinkTime;
+        std::string distribution = node["distribution"] ? node["distribution"].as<std::string>() : "constant";
+        auto require = [&node, &context, &distribution](const char* key)
+        {
+            if (!node[key])
+            {
+                throw std::runtime_error(std::format("{}: the {} distribution needs '{}'", context, distribution, key));
+            }
+            double value = node[key].as<double>();
+            if (value < 0.0)
+            {
+                throw std::runtime_error(std::format("{}: '{}' cannot be negative", context, key));
+            }
+            return value;
+        };
+
+        if (node["max"])
+        {
+            thinkTime.max = node["max"].as<double>();
+        }
+        if (node["min"] && distribution != "uniform" && distribution != "pareto")
+        {
+            thinkTime.min = require("min");
+        }
+
+        if (distribution == "constant")
+        {
+            thinkTime.distribution = Distribution::Constant;
+            thinkTime.mean = require("value");
+        }
+        else if (distribution == "uniform")
+        {
+            thinkTime.distribution = Distribution::Uniform;
+            thinkTime.min = require("min");
+            thinkTime.max = require("max");
+        }
+        else if (distribution == "exponential")
+        {
+            thinkTime.distribution = Distribution::Exponential;
+            thinkTime.mean = require("mean");
+        }
+        else if (distribution == "normal")
+        {
+            thinkTime.distribution = Distribution::Normal;
+            thinkTime.mean = require("mean");
+            thinkTime.stddev = require("stddev");
+        }
+        else if (distribution == "pareto")
+        {
+            thinkTime.distribution = Distribution::Pareto;
+            thinkTime.min = require("min");
+            thinkTime.shape = require("shape");
+            if (thinkTime.min <= 0.0 || thinkTime.shape <= 0.0)
+            {
+                throw std::runtime_error(std::format("{}: the pareto distribution needs a positive 'min' and 'shape'", context));
+            }
+        }
+        else
+        {
+            throw std::runtime_error(std::format(
+                "{}: unknown distribution '{}', expected constant, uniform, exponential, normal or pareto", context, distribution));
+        }
+
+        if (thinkTime.max.has_value() && thinkTime.max.value() < thinkTime.min)
+        {
+            throw std::runtime_error(std::format("{}: 'max' cannot be less than 'min'", context));
+        }
+        return thinkTime;
+    }
+
+    CachePolicy YamlParser::parseCache(const YAML::Node& node, const std::string& stepName) const
+    {
+        CachePolicy policy;
+        if (!node.IsMap())
+        {
+            throw std::runtime_error(std::format("Cache of step '{}' must be a map", stepName));
+        }
+
+        if (node["scope"])
+        {
+            std::string scope = node["scope"].as<std::string>();
+            if (scope == "vu")
+            {
+                policy.scope = CacheScope::VirtualUser;
+            }
+            else if (scope == "global")
+            {
+                policy.scope = CacheScope::Global;
+            }
+            else
+            {
+                throw std::runtime_error(std::format("Cache of step '{}' has unknown scope '{}', expected vu or global", stepName, scope));
+            }
+        }
+
+        if (node["ttl"])
+        {
+            policy.ttl = parseDuration(node["ttl"].as<std::string>());
+            if (policy.ttl->count() == 0)
+            {
+                throw std::runtime_error(std::format("Cache ttl of step '{}' must be positive", stepName));
+            }
+        }
+
+        return policy;
+    }
+
+    CredentialPolicy YamlParser::parseCredentials(const YAML::Node& node, const std::string& stepName) const
+    {
+        CredentialPolicy policy;
+        if (!node.IsMap())
+        {
+            throw std::runtime_error(std::format("Credentials of step '{}' must be a map", stepName));
+        }
+
+        if (node["pool"])
+        {
+            int pool = node["pool"].as<int>();
+            if (pool < 1)
+            {
+                throw std::runtime_error(std::format("Credential pool of step '{}' must hold at least one credential", stepName));
+            }
+            policy.pool = static_cast<std::size_t>(pool);
+        }
+
+        if (node["ttl"] && node["expires_in"])
+        {
+            throw std::runtime_error(std::format("Credentials of step '{}' cannot have both ttl and expires_in", stepName));
+        }
+        if (node["ttl"])
+        {
+            int ttlMs = node["ttl"].as<int>();
+            if (ttlMs <= 0)
+            {
+                throw std::runtime_error(std::format("Credential ttl of step '{}' must be positive", stepName));
+            }
+            policy.ttl = std::chrono::milliseconds(ttlMs);
+        }
+        if (node["expires_in"])
+        {
+            policy.expiresIn = node["expires_in"].as<std::string>();
+        }
+
+        if (node["refresh_before"])
+        {
+            int refreshMs = node["refresh_before"].as<int>();
+            if (refreshMs < 0)
+            {
+                throw std::runtime_error(std::format("Credential refresh_before of step '{}' cannot be negative", stepName));
+            }
+            policy.refreshBefore = std::chrono::milliseconds(refreshMs);
+        }
+
+        if (node["refresh"])
+        {
+            policy.refresh = node["refresh"].as<std::string>();
+            if (policy.refresh.value() == stepName)
+            {
+                throw std::runtime_error(std::format("Step '{}' cannot refresh its own credentials", stepName));
+            }
+        }
+
+        return policy;
+    }
+
+    http::Request YamlParser::parseRequest(const YAML::Node& node) const
+    {
+        http::Request request;
+
+        if (node["url"])
+        {
+            request.setUrl(node["url"].as<std::string>());
+        }
+        else
         {
             throw std::runtime_error("Request must have a URL");
         }
@@ -196,14 +1121,14 @@ namespace zaplet::scenario
 
         if (node["headers"] && node["headers"].IsMap())
         {
-            std::map<std::string, std::string> headers;
+            http::Headers headers;
             for (const auto& it : node["headers"])
             {
                 std::string key = it.first.as<std::string>();
                 std::string value = it.second.as<std::string>();
-                headers[key] = value;
+                headers.set(key, value);
             }
-            request.setHeaders(headers);
+            request.setHeaders(std::move(headers));
         }
 
         if (node["body"])
@@ -231,32 +1156,213 @@ namespace zaplet::scenario
         return request;
     }
 
-    http::Response YamlParser::parseResponse(const YAML::Node& node) const
+    ResponseExpectation YamlParser::parseExpectation(const YAML::Node& node) const
     {
-        http::Response response;
+        ResponseExpectation expectation;
 
         if (node["status_code"])
         {
-            response.setStatusCode(node["status_code"].as<int>());
+            expectation.statusCode = node["status_code"].as<int>();
         }
 
         if (node["headers"] && node["headers"].IsMap())
         {
-            std::map<std::string, std::string> headers;
             for (const auto& it : node["headers"])
             {
-                std::string key = it.first.as<std::string>();
-                std::string value = it.second.as<std::string>();
-                headers[key] = value;
+                std::string name = it.first.as<std::string>();
+                if (it.second.IsMap())
+                {
+                    expectation.headers[name] = parseMatcher(it.second, "header " + name);
+                }
+                else
+                {
+                    expectation.headers[name].equals = nlohmann::json(it.second.as<std::string>()).dump();
+                }
             }
-            response.setHeaders(headers);
         }
 
         if (node["body"])
         {
-            response.setBody(node["body"].as<std::string>());
+            expectation.body = node["body"].as<std::string>();
+        }
+
+        if (node["json"])
+        {
+            const YAML::Node& json = node["json"];
+            expectation.json = json.IsScalar() ? json.as<std::string>() : toJson(json).dump();
+        }
+
+        if (node["fields"] && node["fields"].IsMap())
+        {
+            for (const auto& it : node["fields"])
+            {
+                std::string path = it.first.as<std::string>();
+                if (it.second.IsMap())
+                {
+                    expectation.fields[path] = parseMatcher(it.second, "field " + path);
+                }
+                else
+                {
+                    expectation.fields[path].equals = toJson(it.second).dump();
+                }
+            }
+        }
+
+        if (node["max_latency"])
+        {
+            expectation.maxLatency = std::chrono::milliseconds(node["max_latency"].as<int>());
+        }
+
+        if (node["min_size"])
+        {
+            expectation.minSize = node["min_size"].as<std::size_t>();
+        }
+
+        if (node["max_size"])
+        {
+            expectation.maxSize = node["max_size"].as<std::size_t>();
+        }
+
+        return expectation;
+    }
+
+    ValueMatcher YamlParser::parseMatcher(const YAML::Node& node, const std::string& context) const
+    {
+        ValueMatcher matcher;
+
+        for (const auto& it : node)
+        {
+            std::string key = it.first.as<std::string>();
+
+            if (key == "exists")
+            {
+                matcher.exists = it.second.as<bool>();
+            }
+            else if (key == "type")
+            {
+                matcher.type = it.second.as<std::string>();
+            }
+            else if (key == "equals")
+            {
+                matcher.equals = toJson(it.second).dump();
+            }
+            else if (key == "matches")
+            {
+                matcher.pattern = it.second.as<std::string>();
+            }
+            else if (key == "min")
+            {
+                matcher.min = it.second.as<double>();
+            }
+            else if (key == "max")
+            {
+                matcher.max = it.second.as<double>();
+            }
+            else if (key == "length")
+            {
+                matcher.length = it.second.as<std::size_t>();
+            }
+            else if (key == "min_length")
+            {
+                matcher.minLength = it.second.as<std::size_t>();
+            }
+            else if (key == "max_length")
+            {
+                matcher.maxLength = it.second.as<std::size_t>();
+            }
+            else
+            {
+                throw std::runtime_error(std::format("Unknown matcher '{}' for {}", key, context));
+            }
+        }
+
+        return matcher;
+    }
+
+    DataSource YamlParser::parseDataSource(const YAML::Node& node) const
+    {
+        DataSource source;
+
+        if (node["file"])
+        {
+            source.file = node["file"].as<std::string>();
+        }
+        else
+        {
+            throw std::runtime_error("Data source must have a file");
+        }
+
+        if (node["format"])
+        {
+            source.format = node["format"].as<std::string>();
+        }
+        else
+        {
+            std::string extension = std::filesystem::path(source.file).extension().string();
+            source.format = extension == ".ndjson" || extension == ".jsonl" ? "ndjson" : "csv";
+        }
+
+        if (source.format != "csv" && source.format != "ndjson")
+        {
+            throw std::runtime_error(std::format("Unknown data format '{}' for {}", source.format, source.file));
+        }
+
+        if (node["mode"])
+        {
+            std::string mode = node["mode"].as<std::string>();
+            if (mode == "sequential")
+            {
+                source.mode = DataMode::Sequential;
+            }
+            else if (mode == "random")
+            {
+                source.mode = DataMode::Random;
+            }
+            else if (mode == "unique")
+            {
+                source.mode = DataMode::Unique;
+            }
+            else if (mode == "circular")
+            {
+                source.mode = DataMode::Circular;
+            }
+            else
+            {
+                throw std::runtime_error(std::format("Unknown data mode '{}' for {}", mode, source.file));
+            }
+        }
+
+        if (node["delimiter"])
+        {
+            std::string delimiter = node["delimiter"].as<std::string>();
+            if (delimiter.size() != 1)
+            {
+                throw std::runtime_error(std::format("Delimiter for {} must be a single character", source.file));
+            }
+            source.delimiter = delimiter.front();
+        }
+
+        if (node["header"])
+        {
+            source.header = node["header"].as<bool>();
+        }
+
+        if (node["columns"] && node["columns"].IsSequence())
+        {
+            for (const auto& column : node["columns"])
+            {
+                source.columns.push_back(column.as<std::string>());
+            }
+        }
+
+        if (node["variables"] && node["variables"].IsMap())
+        {
+            for (const auto& it : node["variables"])
+            {
+                source.variables[it.first.as<std::string>()] = it.second.as<std::string>();
+            }
         }
 
-        return response;
+        return source;
     }
 } // namespace zaplet::scenario
\ No newline at end of file